@@ -0,0 +1,11 @@
+@echo off
+IF NOT EXIST build mkdir build
+pushd build
+
+REM NOTE: Vectorization is disabled so the scalar loops from listing 58 stay scalar
+call cl -O1 -nologo -Zi -FC ..\sum_benchmark.cpp -Fesum_benchmark_msvc.exe
+call clang -O3 -g -fno-unroll-loops -fno-vectorize -fno-slp-vectorize -fuse-ld=lld ..\sum_benchmark.cpp -o sum_benchmark_clang.exe
+call cl -O1 -nologo -Zi -FC ..\sum_listing_report.cpp -Fesum_listing_report_msvc.exe
+call clang -O3 -g -fno-unroll-loops -fno-vectorize -fno-slp-vectorize -fuse-ld=lld ..\sum_listing_report.cpp -o sum_listing_report_clang.exe
+
+popd
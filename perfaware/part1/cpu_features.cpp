@@ -0,0 +1,71 @@
+/* NOTE(agent): Which SIMD instruction sets this CPU can actually run, checked with CPUID. The wider registers
+   also have to be enabled by the OS (so that it saves and restores them on a context switch), which is what
+   XCR0 says, so an instruction set that uses them only counts if the OS has turned them on too.
+   
+   This is shared by sum_simd.cpp and part2/haversine_batch.cpp, which each turn it into their own choice of
+   kernel, so it is guarded to let a program include both of them. */
+
+#if !defined(CPU_FEATURES_CPP)
+#define CPU_FEATURES_CPP
+
+#if _MSC_VER
+#include <intrin.h>
+#define CPU_TARGET_XSAVE
+#else
+#include <cpuid.h>
+#define CPU_TARGET_XSAVE __attribute__((target("xsave")))
+#endif
+
+struct cpu_features
+{
+    b32 SSE2;
+    b32 FMA;
+    b32 AVX2;
+    b32 AVX512F;
+};
+
+static void CPUID(u32 Leaf, u32 SubLeaf, u32 *Regs)
+{
+#if _MSC_VER
+    __cpuidex((int *)Regs, Leaf, SubLeaf);
+#else
+    __cpuid_count(Leaf, SubLeaf, Regs[0], Regs[1], Regs[2], Regs[3]);
+#endif
+}
+
+CPU_TARGET_XSAVE static u64 ReadXCR0(void)
+{
+    u64 Result = _xgetbv(0);
+    return Result;
+}
+
+static cpu_features GetCPUFeatures(void)
+{
+    cpu_features Result = {};
+    
+    u32 Regs[4];
+    CPUID(0, 0, Regs);
+    u32 MaxLeaf = Regs[0];
+    
+    CPUID(1, 0, Regs);
+    Result.SSE2 = ((Regs[3] & (1 << 26)) != 0);
+    
+    b32 FMA = ((Regs[2] & (1 << 12)) != 0);
+    b32 OSXSAVE = ((Regs[2] & (1 << 27)) != 0);
+    b32 AVX = ((Regs[2] & (1 << 28)) != 0);
+    if(OSXSAVE && (MaxLeaf >= 7))
+    {
+        u64 XCR0 = ReadXCR0();
+        b32 YMMEnabled = ((XCR0 & 0x6) == 0x6);
+        b32 ZMMEnabled = ((XCR0 & 0xe6) == 0xe6);
+        
+        CPUID(7, 0, Regs);
+        Result.FMA = (FMA && AVX && YMMEnabled);
+        Result.AVX2 = ((Regs[1] & (1 << 5)) && AVX && YMMEnabled);
+        Result.AVX512F = ((Regs[1] & (1 << 16)) && ZMMEnabled);
+    }
+    
+    return Result;
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include <stdint.h>
+
+// NOTE(agent): These are spelled exactly the way sim86.h spells them, so this file can be included
+// alongside the simulator (where uint64_t would be a different type than its u64 on some platforms).
+typedef char unsigned u8;
+typedef short unsigned u16;
+typedef int unsigned u32;
+typedef long long unsigned u64;
+
+typedef char s8;
+typedef short s16;
+typedef int s32;
+typedef long long s64;
+
+typedef s32 b32;
+typedef float f32;
+typedef double f64;
+
+#if _WIN32
+
+#include <intrin.h>
+#include <windows.h>
+#include <psapi.h>
+
+#pragma comment(lib, "psapi.lib")
+
+static u64 GetOSTimerFreq(void)
+{
+    LARGE_INTEGER Freq;
+    QueryPerformanceFrequency(&Freq);
+    return Freq.QuadPart;
+}
+
+static u64 ReadOSTimer(void)
+{
+    LARGE_INTEGER Value;
+    QueryPerformanceCounter(&Value);
+    return Value.QuadPart;
+}
+
+static u64 ReadOSPageFaultCount(void)
+{
+    PROCESS_MEMORY_COUNTERS_EX MemoryCounters = {};
+    MemoryCounters.cb = sizeof(MemoryCounters);
+    GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS *)&MemoryCounters, sizeof(MemoryCounters));
+    
+    u64 Result = MemoryCounters.PageFaultCount;
+    return Result;
+}
+
+#else
+
+#include <x86intrin.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+static u64 GetOSTimerFreq(void)
+{
+    return 1000000;
+}
+
+static u64 ReadOSTimer(void)
+{
+    // NOTE(agent): The "struct" keyword is not necessary here when compiling in C++,
+    // but just in case anyone is using this file from C, I include it.
+    struct timeval Value;
+    gettimeofday(&Value, 0);
+    
+    u64 Result = GetOSTimerFreq()*(u64)Value.tv_sec + (u64)Value.tv_usec;
+    return Result;
+}
+
+static u64 ReadOSPageFaultCount(void)
+{
+    // NOTE(agent): Soft faults (the page just had to be mapped) and hard faults (it had to be read from disk)
+    // are both counted, since either one costs the program far more than the access that triggered it.
+    struct rusage Usage = {};
+    getrusage(RUSAGE_SELF, &Usage);
+    
+    u64 Result = Usage.ru_minflt + Usage.ru_majflt;
+    return Result;
+}
+
+#endif
+
+/* NOTE(agent): This does not need to be "inline", it could just be "static"
+   because compilers will inline it anyway. But compilers will warn about
+   static functions that aren't used. So "inline" is just the simplest way
+   to tell them to stop complaining about that. */
+inline u64 ReadCPUTimer(void)
+{
+    // NOTE(agent): If you were on ARM, you would need to replace __rdtsc
+    // with one of their performance counter read instructions, depending
+    // on which ones are available on your platform.
+    
+    return __rdtsc();
+}
+
+static u64 EstimateCPUTimerFreq(u64 MillisecondsToWait)
+{
+    /* NOTE(agent): The CPU timer (the TSC on x64) does not come with a way to ask how fast it runs,
+       so it is measured against the OS timer instead. Note that on most modern x64 CPUs, the TSC
+       runs at a fixed rate regardless of what the cores are clocked at, so "cycles" measured with
+       it are TSC ticks, not necessarily core clocks. */
+    
+    u64 OSFreq = GetOSTimerFreq();
+    
+    u64 CPUStart = ReadCPUTimer();
+    u64 OSStart = ReadOSTimer();
+    u64 OSEnd = 0;
+    u64 OSElapsed = 0;
+    u64 OSWaitTime = OSFreq * MillisecondsToWait / 1000;
+    while(OSElapsed < OSWaitTime)
+    {
+        OSEnd = ReadOSTimer();
+        OSElapsed = OSEnd - OSStart;
+    }
+    
+    u64 CPUEnd = ReadCPUTimer();
+    u64 CPUElapsed = CPUEnd - CPUStart;
+    
+    u64 CPUFreq = 0;
+    if(OSElapsed)
+    {
+        CPUFreq = OSFreq * CPUElapsed / OSElapsed;
+    }
+    
+    return CPUFreq;
+}
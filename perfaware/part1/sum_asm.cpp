@@ -0,0 +1,250 @@
+/* NOTE(agent): The listing 58 loops only come out the way they are written if the compiler is told not to
+   vectorize or unroll them, and even then, what it does with them is up to the compiler. These are the same
+   loops written directly in x64 assembly, instruction for instruction the same shape as the 8086 versions in
+   listings 59 through 64 (just with 32-bit registers and 4-byte elements), so there is something fixed to
+   compare the compiled versions against.
+   
+   Note that listing 64 is what CLANG made of TreeScalarPtr, and it adds all four elements straight into one
+   register - so TreeScalarPtrAsm is a single dependency chain, not a tree. That's the shape of the listing, so
+   that's what is reproduced here.
+   
+   These use GCC/CLANG inline assembly, which MSVC does not support for x64, so they only exist on those compilers.
+   The same goes for PrintDisassembly, which needs objdump and a way to find the running executable. */
+
+#if !_MSC_VER
+
+#include <unistd.h>
+
+#define HAS_ASM_SUM_KERNELS 1
+
+// NOTE(agent): Listing 59
+static u32 SingleScalarAsm(u32 Count, u32 *Input)
+{
+    u32 Sum;
+    u64 Index;
+    __asm__(
+        "    xorl %[Sum], %[Sum]\n"
+        "    testq %[Count], %[Count]\n"
+        "    je 2f\n"
+        "    xorl %k[Index], %k[Index]\n"
+        "1:\n"
+        "    addl (%[Input], %[Index], 4), %[Sum]\n"
+        "    incq %[Index]\n"
+        "    cmpq %[Index], %[Count]\n"
+        "    jne 1b\n"
+        "2:\n"
+        : [Sum] "=&r" (Sum), [Index] "=&r" (Index)
+        : [Count] "r" ((u64)Count), [Input] "r" (Input)
+        : "cc", "memory");
+    
+    return Sum;
+}
+
+// NOTE(agent): Listing 60
+static u32 Unroll2ScalarAsm(u32 Count, u32 *Input)
+{
+    u32 Sum;
+    u64 Index;
+    __asm__(
+        "    xorl %[Sum], %[Sum]\n"
+        "    testq %[Count], %[Count]\n"
+        "    je 2f\n"
+        "    xorl %k[Index], %k[Index]\n"
+        "1:\n"
+        "    addl (%[Input], %[Index], 4), %[Sum]\n"
+        "    addl 4(%[Input], %[Index], 4), %[Sum]\n"
+        "    addq $2, %[Index]\n"
+        "    cmpq %[Count], %[Index]\n"
+        "    jb 1b\n"
+        "2:\n"
+        : [Sum] "=&r" (Sum), [Index] "=&r" (Index)
+        : [Count] "r" ((u64)Count), [Input] "r" (Input)
+        : "cc", "memory");
+    
+    return Sum;
+}
+
+// NOTE(agent): Listing 61
+static u32 DualScalarAsm(u32 Count, u32 *Input)
+{
+    u32 SumA, SumB;
+    u64 Index;
+    __asm__(
+        "    xorl %[SumA], %[SumA]\n"
+        "    testq %[Count], %[Count]\n"
+        "    je 2f\n"
+        "    xorl %[SumB], %[SumB]\n"
+        "    xorl %k[Index], %k[Index]\n"
+        "1:\n"
+        "    addl (%[Input], %[Index], 4), %[SumA]\n"
+        "    addl 4(%[Input], %[Index], 4), %[SumB]\n"
+        "    addq $2, %[Index]\n"
+        "    cmpq %[Count], %[Index]\n"
+        "    jb 1b\n"
+        "    addl %[SumB], %[SumA]\n"
+        "2:\n"
+        : [SumA] "=&r" (SumA), [SumB] "=&r" (SumB), [Index] "=&r" (Index)
+        : [Count] "r" ((u64)Count), [Input] "r" (Input)
+        : "cc", "memory");
+    
+    return SumA;
+}
+
+// NOTE(agent): Listing 62
+static u32 QuadScalarAsm(u32 Count, u32 *Input)
+{
+    u32 SumA, SumB, SumC, SumD;
+    u64 Index;
+    __asm__(
+        "    xorl %[SumA], %[SumA]\n"
+        "    testq %[Count], %[Count]\n"
+        "    je 2f\n"
+        "    xorl %[SumB], %[SumB]\n"
+        "    xorl %[SumC], %[SumC]\n"
+        "    xorl %[SumD], %[SumD]\n"
+        "    xorl %k[Index], %k[Index]\n"
+        "1:\n"
+        "    addl (%[Input], %[Index], 4), %[SumA]\n"
+        "    addl 4(%[Input], %[Index], 4), %[SumB]\n"
+        "    addl 8(%[Input], %[Index], 4), %[SumC]\n"
+        "    addl 12(%[Input], %[Index], 4), %[SumD]\n"
+        "    addq $4, %[Index]\n"
+        "    cmpq %[Count], %[Index]\n"
+        "    jb 1b\n"
+        "    addl %[SumB], %[SumA]\n"
+        "    addl %[SumD], %[SumC]\n"
+        "    addl %[SumC], %[SumA]\n"
+        "2:\n"
+        : [SumA] "=&r" (SumA), [SumB] "=&r" (SumB), [SumC] "=&r" (SumC), [SumD] "=&r" (SumD), [Index] "=&r" (Index)
+        : [Count] "r" ((u64)Count), [Input] "r" (Input)
+        : "cc", "memory");
+    
+    return SumA;
+}
+
+// NOTE(agent): Listing 63
+static u32 QuadScalarPtrAsm(u32 Count, u32 *Input)
+{
+    u32 SumA, SumB, SumC, SumD;
+    u64 GroupCount = Count;
+    __asm__(
+        "    xorl %[SumA], %[SumA]\n"
+        "    cmpq $4, %[GroupCount]\n"
+        "    jb 2f\n"
+        "    shrq $2, %[GroupCount]\n"
+        "    xorl %[SumB], %[SumB]\n"
+        "    xorl %[SumC], %[SumC]\n"
+        "    xorl %[SumD], %[SumD]\n"
+        "1:\n"
+        "    addl (%[Input]), %[SumA]\n"
+        "    addl 4(%[Input]), %[SumB]\n"
+        "    addl 8(%[Input]), %[SumC]\n"
+        "    addl 12(%[Input]), %[SumD]\n"
+        "    addq $16, %[Input]\n"
+        "    decq %[GroupCount]\n"
+        "    jne 1b\n"
+        "    addl %[SumB], %[SumA]\n"
+        "    addl %[SumD], %[SumC]\n"
+        "    addl %[SumC], %[SumA]\n"
+        "2:\n"
+        : [SumA] "=&r" (SumA), [SumB] "=&r" (SumB), [SumC] "=&r" (SumC), [SumD] "=&r" (SumD),
+          [GroupCount] "+r" (GroupCount), [Input] "+r" (Input)
+        :
+        : "cc", "memory");
+    
+    return SumA;
+}
+
+// NOTE(agent): Listing 64
+static u32 TreeScalarPtrAsm(u32 Count, u32 *Input)
+{
+    u32 Sum;
+    u64 GroupCount = Count;
+    __asm__(
+        "    xorl %[Sum], %[Sum]\n"
+        "    cmpq $4, %[GroupCount]\n"
+        "    jb 2f\n"
+        "    shrq $2, %[GroupCount]\n"
+        "1:\n"
+        "    addl (%[Input]), %[Sum]\n"
+        "    addl 4(%[Input]), %[Sum]\n"
+        "    addl 8(%[Input]), %[Sum]\n"
+        "    addl 12(%[Input]), %[Sum]\n"
+        "    addq $16, %[Input]\n"
+        "    decq %[GroupCount]\n"
+        "    jne 1b\n"
+        "2:\n"
+        : [Sum] "=&r" (Sum), [GroupCount] "+r" (GroupCount), [Input] "+r" (Input)
+        :
+        : "cc", "memory");
+    
+    return Sum;
+}
+
+static char const *GetExecutablePath(char const *Arg0, char *Buffer, u32 BufferSize)
+{
+    // NOTE(agent): This has to be resolved here, since "/proc/self/exe" would mean objdump itself once objdump opens it
+    char const *Result = Arg0;
+#if __linux__
+    ssize_t Length = readlink("/proc/self/exe", Buffer, BufferSize - 1);
+    if(Length > 0)
+    {
+        Buffer[Length] = 0;
+        Result = Buffer;
+    }
+#endif
+
+    return Result;
+}
+
+static b32 PrintDisassembly(char const *ExePath, char const *FunctionName, FILE *Dest)
+{
+    /* NOTE(agent): This just runs objdump on the executable and picks out the functions whose (demangled) names
+       start with FunctionName followed by "(" - which also catches any clones the compiler made of it, like
+       "SingleScalar(unsigned int, unsigned int*) [clone .constprop.0]". */
+    
+    b32 Result = false;
+    
+    char Command[2048];
+    snprintf(Command, sizeof(Command), "objdump -d -C --no-show-raw-insn \"%s\"", ExePath);
+    
+    FILE *Pipe = popen(Command, "r");
+    if(Pipe)
+    {
+        size_t NameLength = strlen(FunctionName);
+        b32 Printing = false;
+        
+        char Line[1024];
+        while(fgets(Line, sizeof(Line), Pipe))
+        {
+            // NOTE(agent): Function headers look like "0000000000001234 <Name(args)>:"
+            char *Open = strchr(Line, '<');
+            b32 IsHeader = (Open && strstr(Line, ">:"));
+            if(IsHeader)
+            {
+                Printing = ((strncmp(Open + 1, FunctionName, NameLength) == 0) && (Open[1 + NameLength] == '('));
+                Result |= Printing;
+            }
+            else if(Line[0] == '\n')
+            {
+                Printing = false;
+            }
+            
+            if(Printing)
+            {
+                fputs(Line, Dest);
+            }
+        }
+        
+        if(Result)
+        {
+            fputs("\n", Dest);
+        }
+        
+        pclose(Pipe);
+    }
+    
+    return Result;
+}
+
+#endif
@@ -0,0 +1,754 @@
+/* NOTE(agent): This times the sum loops from listing 58 over a range of input sizes, from ones that fit
+   in L1 to ones that can only come from main memory. Since the whole point is to look at the scalar loops,
+   it must be built with the same switches listing 58 asks for, so the compiler doesn't vectorize them:
+   
+   MSVC: cl -O1 sum_benchmark.cpp
+   GCC: g++ -O3 -fno-unroll-loops -fno-tree-vectorize sum_benchmark.cpp -o sum_benchmark
+   CLANG: clang++ -O3 -fno-unroll-loops -fno-vectorize -fno-slp-vectorize sum_benchmark.cpp -o sum_benchmark
+   
+   On Linux, add -pthread for the multithreaded mode.
+   
+   Usage: sum_benchmark [-minsize bytes] [-maxsize bytes] [-trials count] [-seconds count] [-csv filename]
+                        [-threads [-kernel name] [-maxthreads count]] [-grid] [-disasm]
+   
+   Each kernel is normally timed as the best of a fixed number of trials (more for small sizes). With -seconds,
+   each one is instead run with the repetition tester from part2 until it goes that many seconds without
+   getting any faster.
+   
+   Results are printed as a table, and also written as CSV (to sum_benchmark.csv by default) so they can
+   be compared across machines. The SIMD kernels from sum_simd.cpp are included for whichever instruction
+   sets the CPU supports, which can be limited by setting SUM_ISA (see sum_simd.cpp).
+   
+   With -threads, instead of comparing kernels, one kernel (SumU32 unless -kernel says otherwise) is run
+   split across 1, 2, 4, ... threads, up to the number of logical processors (or -maxthreads), to show how
+   throughput at each size scales with core count. See sum_threads.cpp for how the work is divided.
+   
+   With -grid, the SumKernel template from sum_grid.cpp is run instead, for every unroll factor and accumulator
+   count from 1 to 16 and for u32, u64, f32, and f64 elements, and each size gets a heatmap of adds/cycle.
+   Reading down a column shows what unrolling alone buys, and reading across a row shows where adding
+   accumulators stops helping because the loop is no longer latency-bound.
+   
+   On GCC and CLANG, the kernel table also has hand-written assembly versions of the listing 58 loops (see
+   sum_asm.cpp), named with an "Asm" suffix, so the compiled loops can be compared against the shape they were
+   supposed to have. -disasm prints the compiler's actual code for each scalar kernel (using objdump) and exits. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform_metrics.cpp"
+#include "../part2/repetition_tester.cpp"
+#include "listing_0058_prologue_sum_loops.cpp"
+#include "sum_simd.cpp"
+#include "sum_grid.cpp"
+#include "sum_asm.cpp"
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+typedef u32 sum_function(u32 Count, u32 *Input);
+
+#include "sum_threads.cpp"
+
+struct sum_kernel
+{
+    char const *Name;
+    sum_function *Function;
+    sum_isa ISA;
+};
+
+static sum_kernel const SumKernels[] =
+{
+    {"SingleScalar", SingleScalar, SumISA_Scalar},
+    {"Unroll2Scalar", Unroll2Scalar, SumISA_Scalar},
+    {"DualScalar", DualScalar, SumISA_Scalar},
+    {"QuadScalar", QuadScalar, SumISA_Scalar},
+    {"QuadScalarPtr", QuadScalarPtr, SumISA_Scalar},
+    {"TreeScalarPtr", TreeScalarPtr, SumISA_Scalar},
+    
+#if HAS_ASM_SUM_KERNELS
+    {"SingleScalarAsm", SingleScalarAsm, SumISA_Scalar},
+    {"Unroll2ScalarAsm", Unroll2ScalarAsm, SumISA_Scalar},
+    {"DualScalarAsm", DualScalarAsm, SumISA_Scalar},
+    {"QuadScalarAsm", QuadScalarAsm, SumISA_Scalar},
+    {"QuadScalarPtrAsm", QuadScalarPtrAsm, SumISA_Scalar},
+    {"TreeScalarPtrAsm", TreeScalarPtrAsm, SumISA_Scalar},
+#endif
+    
+    {"SSE2x1", SumSSE2<1>, SumISA_SSE2},
+    {"SSE2x2", SumSSE2<2>, SumISA_SSE2},
+    {"SSE2x4", SumSSE2<4>, SumISA_SSE2},
+    {"AVX2x1", SumAVX2<1>, SumISA_AVX2},
+    {"AVX2x2", SumAVX2<2>, SumISA_AVX2},
+    {"AVX2x4", SumAVX2<4>, SumISA_AVX2},
+    {"AVX512x1", SumAVX512<1>, SumISA_AVX512},
+    {"AVX512x2", SumAVX512<2>, SumISA_AVX512},
+    {"AVX512x4", SumAVX512<4>, SumISA_AVX512},
+    
+    {"SumU32", SumU32, SumISA_Scalar},
+};
+
+struct sum_result
+{
+    u64 BestTSC;
+    u32 Sum;
+    b32 Correct;
+};
+
+struct sum_benchmark
+{
+    u64 CPUTimerFreq;
+    
+    u32 MinTrialCount;
+    u64 MinBytesPerTest;
+    
+    // NOTE(agent): When this is set, kernels are timed with the repetition tester instead of a fixed number of trials
+    u32 SecondsToTry;
+    
+    u32 *Input;
+    u32 InputCount;
+};
+
+static u32 *AllocateInput(u32 Count)
+{
+    // NOTE(agent): Aligned to a cache line, so no kernel is ever penalized for a misaligned start
+    u8 *Memory = (u8 *)malloc((u64)Count*sizeof(u32) + 64);
+    u32 *Result = 0;
+    if(Memory)
+    {
+        Result = (u32 *)(((uintptr_t)Memory + 63) & ~(uintptr_t)63);
+    }
+    
+    return Result;
+}
+
+static void FillInput(u32 Count, u32 *Input)
+{
+    // NOTE(agent): Arbitrary but reproducible, so the sums (and thus the CSV) are the same on every machine
+    u32 Value = 0x12345678;
+    for(u32 Index = 0; Index < Count; ++Index)
+    {
+        Value = Value*1664525 + 1013904223;
+        Input[Index] = Value >> 8;
+    }
+}
+
+static u32 ReferenceSum(u32 Count, u32 *Input)
+{
+    u64 Sum = 0;
+    for(u32 Index = 0; Index < Count; ++Index)
+    {
+        Sum += Input[Index];
+    }
+    
+    u32 Result = (u32)Sum;
+    return Result;
+}
+
+static u32 CheckUnalignedSums(sum_isa ISA, u32 *Input)
+{
+    // NOTE(agent): The listing 58 loops only handle multiples of four, but the SIMD ones are supposed to handle
+    // anything, so they are checked at every small count and every starting alignment within a cache line.
+    u32 ErrorCount = 0;
+    for(u32 KernelIndex = 0; KernelIndex < ArrayCount(SumKernels); ++KernelIndex)
+    {
+        sum_kernel Kernel = SumKernels[KernelIndex];
+        if((Kernel.ISA != SumISA_Scalar) && (Kernel.ISA <= ISA))
+        {
+            for(u32 Offset = 0; Offset < 16; ++Offset)
+            {
+                for(u32 Count = 0; Count < 256; ++Count)
+                {
+                    u32 Expected = ReferenceSum(Count, Input + Offset);
+                    u32 Sum = Kernel.Function(Count, Input + Offset);
+                    if(Sum != Expected)
+                    {
+                        fprintf(stderr, "ERROR: %s returned %u for %u elements at offset %u (expected %u)\n",
+                                Kernel.Name, Sum, Count, Offset, Expected);
+                        ++ErrorCount;
+                    }
+                }
+            }
+        }
+    }
+    
+    return ErrorCount;
+}
+
+static u32 GetTrialCount(sum_benchmark *Bench, u64 ByteCount)
+{
+    // NOTE(agent): Small inputs take so little time that a single run is mostly timer noise,
+    // so they get run many more times than large ones.
+    u64 Result = Bench->MinBytesPerTest / ByteCount;
+    if(Result < Bench->MinTrialCount)
+    {
+        Result = Bench->MinTrialCount;
+    }
+    
+    return (u32)Result;
+}
+
+static sum_result TimeSumFunction(sum_benchmark *Bench, sum_function *Function, u32 Count, u32 ExpectedSum)
+{
+    sum_result Result = {};
+    Result.BestTSC = (u64)-1;
+    Result.Correct = true;
+    
+    u64 ByteCount = (u64)Count*sizeof(u32);
+    
+    // NOTE(agent): One untimed run first, so inputs that fit in cache are already in it
+    Result.Sum = Function(Count, Bench->Input);
+    
+    if(Bench->SecondsToTry)
+    {
+        repetition_tester Tester = {};
+        NewTestWave(&Tester, ByteCount, Bench->CPUTimerFreq, Bench->SecondsToTry);
+        Tester.PrintNewMinimums = false;
+        
+        while(IsTesting(&Tester))
+        {
+            BeginTime(&Tester);
+            u32 Sum = Function(Count, Bench->Input);
+            EndTime(&Tester);
+            CountBytes(&Tester, ByteCount);
+            
+            if(Sum != ExpectedSum)
+            {
+                Result.Sum = Sum;
+                Result.Correct = false;
+            }
+        }
+        
+        Result.BestTSC = Tester.Results.Min.E[RepValue_CPUTimer];
+    }
+    else
+    {
+        u32 TrialCount = GetTrialCount(Bench, ByteCount);
+        for(u32 Trial = 0; Trial < TrialCount; ++Trial)
+        {
+            u64 Start = ReadCPUTimer();
+            u32 Sum = Function(Count, Bench->Input);
+            u64 Elapsed = ReadCPUTimer() - Start;
+            
+            if(Result.BestTSC > Elapsed)
+            {
+                Result.BestTSC = Elapsed;
+            }
+            
+            if(Sum != ExpectedSum)
+            {
+                Result.Sum = Sum;
+                Result.Correct = false;
+            }
+        }
+    }
+    
+    if(Result.Sum != ExpectedSum)
+    {
+        Result.Correct = false;
+    }
+    
+    return Result;
+}
+
+static sum_result TimeThreadedSum(sum_benchmark *Bench, sum_thread_pool *Pool, sum_function *Function,
+                                  u32 Count, u32 ExpectedSum)
+{
+    sum_result Result = {};
+    Result.BestTSC = (u64)-1;
+    Result.Correct = true;
+    
+    u32 TrialCount = GetTrialCount(Bench, (u64)Count*sizeof(u32));
+    
+    Result.Sum = RunSumThreads(Pool, Function, Count, Bench->Input);
+    
+    for(u32 Trial = 0; Trial < TrialCount; ++Trial)
+    {
+        u64 Start = ReadCPUTimer();
+        u32 Sum = RunSumThreads(Pool, Function, Count, Bench->Input);
+        u64 Elapsed = ReadCPUTimer() - Start;
+        
+        if(Result.BestTSC > Elapsed)
+        {
+            Result.BestTSC = Elapsed;
+        }
+        
+        if(Sum != ExpectedSum)
+        {
+            Result.Sum = Sum;
+            Result.Correct = false;
+        }
+    }
+    
+    if(Result.Sum != ExpectedSum)
+    {
+        Result.Correct = false;
+    }
+    
+    return Result;
+}
+
+static void PrintSize(FILE *Dest, u64 ByteCount)
+{
+    if(ByteCount >= (1024*1024*1024))
+    {
+        fprintf(Dest, "%6.1fgb", (f64)ByteCount / (1024.0*1024.0*1024.0));
+    }
+    else if(ByteCount >= (1024*1024))
+    {
+        fprintf(Dest, "%6.1fmb", (f64)ByteCount / (1024.0*1024.0));
+    }
+    else
+    {
+        fprintf(Dest, "%6.1fkb", (f64)ByteCount / 1024.0);
+    }
+}
+
+template<typename element>
+static sum_result TimeGridKernel(sum_benchmark *Bench, grid_kernel<element> Kernel, u32 Count, element *Input,
+                                 b32 Exact, element ExpectedSum)
+{
+    sum_result Result = {};
+    Result.BestTSC = (u64)-1;
+    Result.Correct = true;
+    
+    u32 TrialCount = GetTrialCount(Bench, (u64)Count*sizeof(element));
+    
+    element Sum = Kernel.Function(Count, Input);
+    for(u32 Trial = 0; Trial < TrialCount; ++Trial)
+    {
+        u64 Start = ReadCPUTimer();
+        Sum = Kernel.Function(Count, Input);
+        u64 Elapsed = ReadCPUTimer() - Start;
+        
+        if(Result.BestTSC > Elapsed)
+        {
+            Result.BestTSC = Elapsed;
+        }
+        
+        if(Exact && (Sum != ExpectedSum))
+        {
+            Result.Correct = false;
+        }
+    }
+    
+    return Result;
+}
+
+template<typename element>
+static u32 RunGridSweep(sum_benchmark *Bench, grid_kernel<element> const *Kernels, u64 MinSize, u64 MaxSize, FILE *CSV)
+{
+    u32 ErrorCount = 0;
+    char const *ElementName = grid_element<element>::Name();
+    
+    // NOTE(agent): Every element type reuses the same input buffer, so it is refilled for each one
+    element *Input = (element *)Bench->Input;
+    u32 MaxCount = (u32)(((u64)Bench->InputCount*sizeof(u32)) / sizeof(element));
+    FillGridInput(MaxCount, Input);
+    
+    for(u64 Size = MinSize; Size <= MaxSize; Size *= 2)
+    {
+        u32 Count = (u32)(Size / sizeof(element));
+        if(Count > MaxCount)
+        {
+            Count = MaxCount;
+        }
+        u64 ByteCount = (u64)Count*sizeof(element);
+        
+        u64 ExpectedSum = ReferenceGridSum(Count, Input);
+        b32 Exact = (Count <= grid_element<element>::MaxExactCount);
+        
+        f64 AddsPerCycle[GRID_UNROLL_COUNT*GRID_UNROLL_COUNT] = {};
+        f64 MaxAddsPerCycle = 0;
+        
+        for(u32 KernelIndex = 0; KernelIndex < (GRID_UNROLL_COUNT*GRID_UNROLL_COUNT); ++KernelIndex)
+        {
+            grid_kernel<element> Kernel = Kernels[KernelIndex];
+            if(Kernel.AccumulatorCount > Kernel.Unroll)
+            {
+                continue;
+            }
+            
+            sum_result Result = TimeGridKernel(Bench, Kernel, Count, Input, Exact, (element)ExpectedSum);
+            
+            f64 Cycles = (f64)Result.BestTSC;
+            f64 BytesPerCycle = (f64)ByteCount / Cycles;
+            f64 GBPerSecond = ((f64)ByteCount / (1024.0*1024.0*1024.0)) / (Cycles / (f64)Bench->CPUTimerFreq);
+            AddsPerCycle[KernelIndex] = (f64)Count / Cycles;
+            if(MaxAddsPerCycle < AddsPerCycle[KernelIndex])
+            {
+                MaxAddsPerCycle = AddsPerCycle[KernelIndex];
+            }
+            
+            if(CSV)
+            {
+                fprintf(CSV, "%s,%u,%u,%llu,%u,%llu,%f,%f,%f,%d\n", ElementName, Kernel.Unroll, Kernel.AccumulatorCount,
+                        (unsigned long long)ByteCount, Count, (unsigned long long)Result.BestTSC, AddsPerCycle[KernelIndex],
+                        BytesPerCycle, GBPerSecond, Result.Correct);
+            }
+            
+            if(!Result.Correct)
+            {
+                fprintf(stderr, "ERROR: SumKernel<%u, %u, %s> returned the wrong sum for %u elements\n",
+                        Kernel.Unroll, Kernel.AccumulatorCount, ElementName, Count);
+                ++ErrorCount;
+            }
+        }
+        
+        // NOTE(agent): Rows are unroll factors and columns are accumulator counts, shaded relative to the best cell
+        printf("%s adds/cycle, ", ElementName);
+        PrintSize(stdout, ByteCount);
+        printf(" (rows: unroll, columns: accumulators)\n");
+        printf("%6s", "");
+        for(u32 Column = 0; Column < GRID_UNROLL_COUNT; ++Column)
+        {
+            printf("%s%6u", Column ? "  " : " ", GridUnrolls[Column]);
+        }
+        printf("\n");
+        
+        for(u32 Row = 0; Row < GRID_UNROLL_COUNT; ++Row)
+        {
+            printf("%6u", GridUnrolls[Row]);
+            for(u32 Column = 0; Column <= Row; ++Column)
+            {
+                f64 Value = AddsPerCycle[Row*GRID_UNROLL_COUNT + Column];
+                printf(" %6.2f%c", Value, GetHeatShade(Value, MaxAddsPerCycle));
+            }
+            printf("\n");
+        }
+        printf("\n");
+    }
+    
+    return ErrorCount;
+}
+
+static u32 RunThreadScaling(sum_benchmark *Bench, sum_kernel Kernel, u64 MinSize, u64 MaxSize,
+                            u32 MaxThreadCount, FILE *CSV)
+{
+    u32 ErrorCount = 0;
+    
+    // NOTE(agent): 1, 2, 4, ... and then always the full count, even if it isn't a power of two
+    u32 ThreadCounts[32];
+    u32 ThreadCountCount = 0;
+    for(u32 ThreadCount = 1; ThreadCount < MaxThreadCount; ThreadCount *= 2)
+    {
+        ThreadCounts[ThreadCountCount++] = ThreadCount;
+    }
+    ThreadCounts[ThreadCountCount++] = MaxThreadCount;
+    
+    u32 SizeCount = 0;
+    for(u64 Size = MinSize; Size <= MaxSize; Size *= 2)
+    {
+        ++SizeCount;
+    }
+    
+    // NOTE(agent): Threads are only started once per thread count, so the sizes are the inner loop,
+    // and the table is filled in here and printed once everything has been run.
+    f64 *GBPerSecond = (f64 *)calloc((u64)SizeCount*ThreadCountCount, sizeof(f64));
+    static sum_thread_pool Pool;
+    
+    for(u32 CountIndex = 0; CountIndex < ThreadCountCount; ++CountIndex)
+    {
+        u32 ThreadCount = ThreadCounts[CountIndex];
+        if(!StartSumThreads(&Pool, ThreadCount))
+        {
+            fprintf(stderr, "ERROR: Unable to start %u threads.\n", ThreadCount);
+            StopSumThreads(&Pool);
+            ++ErrorCount;
+            break;
+        }
+        
+        u32 SizeIndex = 0;
+        for(u64 Size = MinSize; Size <= MaxSize; Size *= 2, ++SizeIndex)
+        {
+            u32 Count = (u32)(Size / sizeof(u32)) & ~3u;
+            u64 ByteCount = (u64)Count*sizeof(u32);
+            u32 ExpectedSum = ReferenceSum(Count, Bench->Input);
+            
+            sum_result Result = TimeThreadedSum(Bench, &Pool, Kernel.Function, Count, ExpectedSum);
+            
+            f64 Cycles = (f64)Result.BestTSC;
+            f64 AddsPerCycle = (f64)Count / Cycles;
+            f64 BytesPerCycle = (f64)ByteCount / Cycles;
+            f64 Rate = ((f64)ByteCount / (1024.0*1024.0*1024.0)) / (Cycles / (f64)Bench->CPUTimerFreq);
+            GBPerSecond[SizeIndex*ThreadCountCount + CountIndex] = Rate;
+            
+            if(CSV)
+            {
+                fprintf(CSV, "%s,%u,%llu,%u,%llu,%f,%f,%f,%d\n", Kernel.Name, ThreadCount, (unsigned long long)ByteCount,
+                        Count, (unsigned long long)Result.BestTSC, AddsPerCycle, BytesPerCycle, Rate, Result.Correct);
+            }
+            
+            if(!Result.Correct)
+            {
+                fprintf(stderr, "ERROR: %s on %u threads returned %u for %u elements (expected %u)\n",
+                        Kernel.Name, ThreadCount, Result.Sum, Count, ExpectedSum);
+                ++ErrorCount;
+            }
+        }
+        
+        StopSumThreads(&Pool);
+    }
+    
+    printf("%s, GB/s by thread count:\n", Kernel.Name);
+    printf("%8s", "Size");
+    for(u32 CountIndex = 0; CountIndex < ThreadCountCount; ++CountIndex)
+    {
+        printf(" %9u", ThreadCounts[CountIndex]);
+    }
+    printf("\n");
+    
+    u32 SizeIndex = 0;
+    for(u64 Size = MinSize; Size <= MaxSize; Size *= 2, ++SizeIndex)
+    {
+        PrintSize(stdout, (u64)((u32)(Size / sizeof(u32)) & ~3u)*sizeof(u32));
+        for(u32 CountIndex = 0; CountIndex < ThreadCountCount; ++CountIndex)
+        {
+            printf(" %9.2f", GBPerSecond[SizeIndex*ThreadCountCount + CountIndex]);
+        }
+        printf("\n");
+    }
+    
+    free(GBPerSecond);
+    
+    return ErrorCount;
+}
+
+int main(int ArgCount, char **Args)
+{
+    u64 MinSize = 4*1024;
+    u64 MaxSize = 256*1024*1024;
+    char const *CSVFileName = "sum_benchmark.csv";
+    b32 Threaded = false;
+    b32 Grid = false;
+    b32 Disassemble = false;
+    char const *KernelName = "SumU32";
+    u32 MaxThreadCount = 0;
+    
+    sum_benchmark Bench = {};
+    Bench.MinTrialCount = 10;
+    Bench.MinBytesPerTest = 256*1024*1024;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-minsize") == 0))
+        {
+            MinSize = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(HasValue && (strcmp(Arg, "-maxsize") == 0))
+        {
+            MaxSize = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(HasValue && (strcmp(Arg, "-trials") == 0))
+        {
+            Bench.MinTrialCount = atoi(Args[++ArgIndex]);
+        }
+        else if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            Bench.SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else if(HasValue && (strcmp(Arg, "-csv") == 0))
+        {
+            CSVFileName = Args[++ArgIndex];
+        }
+        else if(strcmp(Arg, "-threads") == 0)
+        {
+            Threaded = true;
+        }
+        else if(strcmp(Arg, "-grid") == 0)
+        {
+            Grid = true;
+        }
+        else if(strcmp(Arg, "-disasm") == 0)
+        {
+            Disassemble = true;
+        }
+        else if(HasValue && (strcmp(Arg, "-kernel") == 0))
+        {
+            KernelName = Args[++ArgIndex];
+        }
+        else if(HasValue && (strcmp(Arg, "-maxthreads") == 0))
+        {
+            MaxThreadCount = atoi(Args[++ArgIndex]);
+        }
+        else
+        {
+            fprintf(stderr, "USAGE: %s [-minsize bytes] [-maxsize bytes] [-trials count] [-seconds count] [-csv filename]\n", Args[0]);
+            fprintf(stderr, "       %*s [-threads [-kernel name] [-maxthreads count]] [-grid] [-disasm]\n", (int)strlen(Args[0]), "");
+            return 1;
+        }
+    }
+    
+    if(Disassemble)
+    {
+#if HAS_ASM_SUM_KERNELS
+        char ExePathBuffer[1024];
+        char const *ExePath = GetExecutablePath(Args[0], ExePathBuffer, sizeof(ExePathBuffer));
+        int Result = 0;
+        for(u32 KernelIndex = 0; KernelIndex < ArrayCount(SumKernels); ++KernelIndex)
+        {
+            sum_kernel Kernel = SumKernels[KernelIndex];
+            if((Kernel.ISA == SumISA_Scalar) && !PrintDisassembly(ExePath, Kernel.Name, stdout))
+            {
+                fprintf(stderr, "ERROR: Unable to find %s in the disassembly of %s (is objdump installed?)\n", Kernel.Name, ExePath);
+                Result = 1;
+            }
+        }
+        
+        return Result;
+#else
+        fprintf(stderr, "ERROR: -disasm uses objdump, which is only supported on GCC and CLANG builds (for MSVC, use dumpbin /disasm).\n");
+        return 1;
+#endif
+    }
+    
+    // NOTE(agent): Every kernel steps by four elements at a time, so counts are kept to multiples of four
+    if(MinSize < 16)
+    {
+        MinSize = 16;
+    }
+    if(MaxSize > 0xfffffff0ull)
+    {
+        MaxSize = 0xfffffff0ull;
+    }
+    
+    Bench.InputCount = (u32)(MaxSize / sizeof(u32)) & ~3u;
+    Bench.Input = AllocateInput(Bench.InputCount);
+    if(!Bench.Input)
+    {
+        fprintf(stderr, "ERROR: Unable to allocate %llu bytes of input.\n", (unsigned long long)MaxSize);
+        return 1;
+    }
+    
+    FillInput(Bench.InputCount, Bench.Input);
+    
+    // NOTE(agent): Before any threads are started (see InitSumU32)
+    InitSumU32();
+    
+    sum_isa ISA = GetSumISA();
+    u32 ErrorCount = CheckUnalignedSums(ISA, Bench.Input);
+    
+    Bench.CPUTimerFreq = GetCPUTimerFreq();
+    printf("CPU timer frequency: %llu (estimated)\n", (unsigned long long)Bench.CPUTimerFreq);
+    printf("Instruction set: %s (supported: %s)\n", SumISANames[ISA], SumISANames[GetSupportedSumISA()]);
+    printf("Cycles below are CPU timer ticks, which may not match core clocks if the core is not running at the timer frequency.\n\n");
+    
+    char const *CSVHeader = "Kernel,Bytes,Count,BestTSC,AddsPerCycle,BytesPerCycle,GBPerSecond,Correct\n";
+    if(Grid)
+    {
+        CSVHeader = "Element,Unroll,Accumulators,Bytes,Count,BestTSC,AddsPerCycle,BytesPerCycle,GBPerSecond,Correct\n";
+    }
+    else if(Threaded)
+    {
+        CSVHeader = "Kernel,Threads,Bytes,Count,BestTSC,AddsPerCycle,BytesPerCycle,GBPerSecond,Correct\n";
+    }
+    
+    FILE *CSV = fopen(CSVFileName, "w");
+    if(CSV)
+    {
+        fputs(CSVHeader, CSV);
+    }
+    else
+    {
+        fprintf(stderr, "WARNING: Unable to open %s, CSV output will not be written.\n", CSVFileName);
+    }
+    
+    if(Grid)
+    {
+        ErrorCount += RunGridSweep(&Bench, GridKernelsU32, MinSize, MaxSize, CSV);
+        ErrorCount += RunGridSweep(&Bench, GridKernelsU64, MinSize, MaxSize, CSV);
+        ErrorCount += RunGridSweep(&Bench, GridKernelsF32, MinSize, MaxSize, CSV);
+        ErrorCount += RunGridSweep(&Bench, GridKernelsF64, MinSize, MaxSize, CSV);
+    }
+    else if(Threaded)
+    {
+        sum_kernel const *Kernel = 0;
+        for(u32 KernelIndex = 0; KernelIndex < ArrayCount(SumKernels); ++KernelIndex)
+        {
+            if(strcmp(SumKernels[KernelIndex].Name, KernelName) == 0)
+            {
+                Kernel = &SumKernels[KernelIndex];
+            }
+        }
+        
+        if(!Kernel)
+        {
+            fprintf(stderr, "ERROR: Unknown kernel \"%s\".\n", KernelName);
+            ++ErrorCount;
+        }
+        else if(Kernel->ISA > ISA)
+        {
+            fprintf(stderr, "ERROR: %s needs %s, which is not available.\n", Kernel->Name, SumISANames[Kernel->ISA]);
+            ++ErrorCount;
+        }
+        else
+        {
+            if((MaxThreadCount == 0) || (MaxThreadCount > MAX_SUM_THREADS))
+            {
+                MaxThreadCount = GetProcessorCount();
+                if(MaxThreadCount > MAX_SUM_THREADS)
+                {
+                    MaxThreadCount = MAX_SUM_THREADS;
+                }
+            }
+            
+            ErrorCount += RunThreadScaling(&Bench, *Kernel, MinSize, MaxSize, MaxThreadCount, CSV);
+        }
+    }
+    else
+    {
+        printf("%-16s %8s %12s %12s %10s %s\n", "Kernel", "Size", "Adds/cycle", "Bytes/cycle", "GB/s", "Sum");
+        
+        for(u64 Size = MinSize; Size <= MaxSize; Size *= 2)
+        {
+            u32 Count = (u32)(Size / sizeof(u32)) & ~3u;
+            u64 ByteCount = (u64)Count*sizeof(u32);
+            u32 ExpectedSum = ReferenceSum(Count, Bench.Input);
+            
+            for(u32 KernelIndex = 0; KernelIndex < ArrayCount(SumKernels); ++KernelIndex)
+            {
+                sum_kernel Kernel = SumKernels[KernelIndex];
+                if(Kernel.ISA > ISA)
+                {
+                    continue;
+                }
+                
+                sum_result Result = TimeSumFunction(&Bench, Kernel.Function, Count, ExpectedSum);
+                
+                f64 Cycles = (f64)Result.BestTSC;
+                f64 AddsPerCycle = (f64)Count / Cycles;
+                f64 BytesPerCycle = (f64)ByteCount / Cycles;
+                f64 GBPerSecond = ((f64)ByteCount / (1024.0*1024.0*1024.0)) / (Cycles / (f64)Bench.CPUTimerFreq);
+                
+                printf("%-16s ", Kernel.Name);
+                PrintSize(stdout, ByteCount);
+                printf(" %12.3f %12.3f %10.2f %s\n", AddsPerCycle, BytesPerCycle, GBPerSecond,
+                       Result.Correct ? "ok" : "MISMATCH");
+                
+                if(CSV)
+                {
+                    fprintf(CSV, "%s,%llu,%u,%llu,%f,%f,%f,%d\n", Kernel.Name, (unsigned long long)ByteCount, Count,
+                            (unsigned long long)Result.BestTSC, AddsPerCycle, BytesPerCycle, GBPerSecond, Result.Correct);
+                }
+                
+                if(!Result.Correct)
+                {
+                    fprintf(stderr, "ERROR: %s returned %u for %u elements (expected %u)\n", Kernel.Name, Result.Sum, Count, ExpectedSum);
+                    ++ErrorCount;
+                }
+            }
+            printf("\n");
+        }
+    }
+    
+    if(CSV)
+    {
+        fclose(CSV);
+    }
+    
+    int Result = (ErrorCount == 0) ? 0 : 1;
+    return Result;
+}
@@ -0,0 +1,164 @@
+/* NOTE(agent): Unroll2Scalar, DualScalar, and QuadScalar from listing 58 are just three points in a grid: how many
+   elements each trip through the loop adds (the unroll factor), and how many independent sums they are spread
+   across (the accumulator count). SumKernel<Unroll, AccumulatorCount, element> is the whole grid, so that
+   SumKernel<1, 1, u32> is SingleScalar, SumKernel<2, 1, u32> is Unroll2Scalar, SumKernel<2, 2, u32> is
+   DualScalar, and SumKernel<4, 4, u32> is QuadScalar.
+   
+   Each loop trip adds element Lane of the group to accumulator (Lane % AccumulatorCount), so there are Unroll
+   adds per trip, in AccumulatorCount dependency chains. Having more accumulators than adds per trip doesn't mean
+   anything, so only AccumulatorCount <= Unroll is measured.
+   
+   Keep in mind that integer addition is associative, so the compiler is allowed to regroup the integer
+   adds into fewer, shorter chains than were written (GCC does, once there are four or more per trip).
+   Floating point addition is not, so without fast-math switches the f32 and f64 kernels always have exactly
+   the chains written here, and are the cleanest place to see the latency-bound to throughput-bound crossover.
+   
+   The unrolling is done with templates instead of a loop, so it happens the same way no matter what
+   the compiler's unrolling switches are set to (these are meant to be built with unrolling turned off,
+   just like listing 58). */
+
+template<u32 Lane, u32 Unroll, u32 AccumulatorCount, typename element>
+struct sum_lanes
+{
+    static inline void Add(element *Sums, element *Input)
+    {
+        Sums[Lane % AccumulatorCount] += Input[Lane];
+        sum_lanes<Lane + 1, Unroll, AccumulatorCount, element>::Add(Sums, Input);
+    }
+};
+
+template<u32 Unroll, u32 AccumulatorCount, typename element>
+struct sum_lanes<Unroll, Unroll, AccumulatorCount, element>
+{
+    static inline void Add(element *, element *)
+    {
+    }
+};
+
+template<u32 Unroll, u32 AccumulatorCount, typename element>
+static element SumKernel(u32 Count, element *Input)
+{
+    element Sums[AccumulatorCount] = {};
+    
+    u32 GroupCount = Count / Unroll;
+    while(GroupCount--)
+    {
+        sum_lanes<0, Unroll, AccumulatorCount, element>::Add(Sums, Input);
+        Input += Unroll;
+    }
+    
+    // NOTE(agent): Unlike listing 58, counts that aren't a multiple of the unroll factor are allowed,
+    // and the extra elements go to the first accumulator.
+    Count %= Unroll;
+    while(Count--)
+    {
+        Sums[0] += *Input++;
+    }
+    
+    element Sum = Sums[0];
+    for(u32 Index = 1; Index < AccumulatorCount; ++Index)
+    {
+        Sum += Sums[Index];
+    }
+    
+    return Sum;
+}
+
+/* NOTE(agent): Grid inputs are all whole numbers from 0 to 255. That way u32 and u64 sums are always exact (u32 just
+   wraps), f64 sums are exact for any count that fits in a u32, and f32 sums are exact as long as no partial sum can
+   pass 2^24, which is what MaxExactCount says. Past that, an f32 sum depends on the order it was added in, so it
+   can't be checked against anything. */
+
+template<typename element> struct grid_element;
+
+template<> struct grid_element<u32>
+{
+    static char const *Name(void) {return "u32";}
+    static u32 const MaxExactCount = 0xffffffff;
+};
+
+template<> struct grid_element<u64>
+{
+    static char const *Name(void) {return "u64";}
+    static u32 const MaxExactCount = 0xffffffff;
+};
+
+template<> struct grid_element<f32>
+{
+    static char const *Name(void) {return "f32";}
+    static u32 const MaxExactCount = (1 << 24) / 256;
+};
+
+template<> struct grid_element<f64>
+{
+    static char const *Name(void) {return "f64";}
+    static u32 const MaxExactCount = 0xffffffff;
+};
+
+template<typename element>
+struct grid_kernel
+{
+    u32 Unroll;
+    u32 AccumulatorCount;
+    element (*Function)(u32 Count, element *Input);
+};
+
+#define GRID_UNROLL_COUNT 5
+static u32 const GridUnrolls[GRID_UNROLL_COUNT] = {1, 2, 4, 8, 16};
+
+#define GRID_ROW(U, element) \
+    {U, 1, SumKernel<U, 1, element>}, {U, 2, SumKernel<U, 2, element>}, {U, 4, SumKernel<U, 4, element>}, \
+    {U, 8, SumKernel<U, 8, element>}, {U, 16, SumKernel<U, 16, element>}
+
+/* NOTE(agent): Every row lists all five accumulator counts so the table can be indexed directly. The ones with more
+   accumulators than the unroll factor still work (the extra accumulators just stay zero), but they are the same loop
+   as AccumulatorCount == Unroll, so they are never run. */
+#define GRID_KERNELS(element) \
+    {GRID_ROW(1, element), GRID_ROW(2, element), GRID_ROW(4, element), GRID_ROW(8, element), GRID_ROW(16, element)}
+
+static grid_kernel<u32> const GridKernelsU32[GRID_UNROLL_COUNT*GRID_UNROLL_COUNT] = GRID_KERNELS(u32);
+static grid_kernel<u64> const GridKernelsU64[GRID_UNROLL_COUNT*GRID_UNROLL_COUNT] = GRID_KERNELS(u64);
+static grid_kernel<f32> const GridKernelsF32[GRID_UNROLL_COUNT*GRID_UNROLL_COUNT] = GRID_KERNELS(f32);
+static grid_kernel<f64> const GridKernelsF64[GRID_UNROLL_COUNT*GRID_UNROLL_COUNT] = GRID_KERNELS(f64);
+
+template<typename element>
+static void FillGridInput(u32 Count, element *Input)
+{
+    u32 Value = 0x12345678;
+    for(u32 Index = 0; Index < Count; ++Index)
+    {
+        Value = Value*1664525 + 1013904223;
+        Input[Index] = (element)(Value >> 24);
+    }
+}
+
+template<typename element>
+static u64 ReferenceGridSum(u32 Count, element *Input)
+{
+    u64 Sum = 0;
+    for(u32 Index = 0; Index < Count; ++Index)
+    {
+        Sum += (u64)Input[Index];
+    }
+    
+    return Sum;
+}
+
+static char GetHeatShade(f64 Value, f64 MaxValue)
+{
+    static char const Shades[] = " .:-=+*#%@";
+    u32 ShadeCount = sizeof(Shades) - 1;
+    
+    u32 Index = 0;
+    if(MaxValue > 0)
+    {
+        Index = (u32)(Value / MaxValue * (f64)ShadeCount);
+        if(Index >= ShadeCount)
+        {
+            Index = ShadeCount - 1;
+        }
+    }
+    
+    char Result = Shades[Index];
+    return Result;
+}
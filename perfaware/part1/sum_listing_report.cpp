@@ -0,0 +1,320 @@
+/* NOTE(agent): Puts the 8086 versions of the sum loops (listings 59 through 64) side by side with the C++ versions
+   from listing 58 they were compiled from. Each listing is run through sim86 in headless mode to get its estimated
+   clocks on an 8086 and on an 8088, and the matching C++ function is timed on this machine. Build it the same way
+   as sum_benchmark (see the switches in listing 58), and point it at a built sim86:
+   
+   Usage: sum_listing_report [-sim86 path] [-listings directory] [-count elements] [-trials count]
+   
+   The listings all start with "mov di, 8" (the element count) followed by a fixed amount of setup, so rather
+   than dividing the total clocks by 8, each listing is run twice, once as-is and once with the count patched
+   to 8 + 256. The difference between the two is the cost of exactly 256 elements, with the setup, the function
+   prologue, and the ret all cancelled out.
+   
+   Native numbers are CPU timer ticks per element, which may not be the same as core clocks (see
+   platform_metrics.cpp). The "x" columns are speedups over SingleScalar within the same column. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform_metrics.cpp"
+#include "listing_0058_prologue_sum_loops.cpp"
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+#if _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+typedef u32 sum_function(u32 Count, u32 *Input);
+
+struct listing_kernel
+{
+    char const *ListingName;
+    char const *KernelName;
+    sum_function *Function;
+};
+
+static listing_kernel const ListingKernels[] =
+{
+    {"listing_0059_SingleScalar", "SingleScalar", SingleScalar},
+    {"listing_0060_Unroll2Scalar", "Unroll2Scalar", Unroll2Scalar},
+    {"listing_0061_DualScalar", "DualScalar", DualScalar},
+    {"listing_0062_QuadScalar", "QuadScalar", QuadScalar},
+    {"listing_0063_QuadScalarPtr", "QuadScalarPtr", QuadScalarPtr},
+    {"listing_0064_TreeScalarPtr", "TreeScalarPtr", TreeScalarPtr},
+};
+
+struct listing_result
+{
+    f64 ClocksPerElement8086;
+    f64 ClocksPerElement8088;
+    f64 CyclesPerElementNative;
+};
+
+#define LISTING_BASE_COUNT 8
+#define LISTING_EXTRA_COUNT 256
+
+static u32 LoadListing(char const *FileName, u8 *Dest, u32 MaxSize)
+{
+    u32 Result = 0;
+    
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+        Result = (u32)fread(Dest, 1, MaxSize, File);
+        fclose(File);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open %s.\n", FileName);
+    }
+    
+    return Result;
+}
+
+static b32 WriteListing(char const *FileName, u8 *Source, u32 Size)
+{
+    b32 Result = false;
+    
+    FILE *File = fopen(FileName, "wb");
+    if(File)
+    {
+        Result = (fwrite(Source, 1, Size, File) == Size);
+        fclose(File);
+    }
+    
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Unable to write %s.\n", FileName);
+    }
+    
+    return Result;
+}
+
+static b32 SimulateClocks(char const *Sim86Path, char const *FileName, b32 Assume8088, u32 *Clocks)
+{
+    b32 Result = false;
+    
+    char Command[1024];
+    snprintf(Command, sizeof(Command), "\"%s\" -headless -stoponret %s\"%s\"", Sim86Path,
+             Assume8088 ? "-8088 " : "", FileName);
+    
+    FILE *Pipe = popen(Command, "r");
+    if(Pipe)
+    {
+        char Line[256];
+        while(fgets(Line, sizeof(Line), Pipe))
+        {
+            u32 InstructionCount, MinClocks, MaxClocks;
+            if(sscanf(Line, "HEADLESS: %u instructions, %u to %u clocks.", &InstructionCount, &MinClocks, &MaxClocks) == 3)
+            {
+                // NOTE(agent): None of these listings have instructions with variable timing, so Min and Max always match
+                *Clocks = MinClocks;
+                Result = true;
+            }
+        }
+        
+        pclose(Pipe);
+    }
+    
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Unable to get clocks from \"%s\" for %s.\n", Sim86Path, FileName);
+    }
+    
+    return Result;
+}
+
+static b32 GetClocksPerElement(char const *Sim86Path, char const *TempFileName, u8 *Listing, u32 ListingSize,
+                               b32 Assume8088, f64 *ClocksPerElement)
+{
+    b32 Result = false;
+    
+    u32 BaseClocks = 0;
+    u32 ExtraClocks = 0;
+    
+    // NOTE(agent): The count is the 16-bit immediate of the "mov di, 8" (bf 08 00) the listing starts with
+    u16 Counts[2] = {LISTING_BASE_COUNT, LISTING_BASE_COUNT + LISTING_EXTRA_COUNT};
+    u32 *Clocks[2] = {&BaseClocks, &ExtraClocks};
+    
+    u32 RunCount = 0;
+    for(u32 RunIndex = 0; RunIndex < ArrayCount(Counts); ++RunIndex)
+    {
+        Listing[1] = (u8)(Counts[RunIndex] & 0xff);
+        Listing[2] = (u8)(Counts[RunIndex] >> 8);
+        if(WriteListing(TempFileName, Listing, ListingSize) &&
+           SimulateClocks(Sim86Path, TempFileName, Assume8088, Clocks[RunIndex]))
+        {
+            ++RunCount;
+        }
+    }
+    
+    remove(TempFileName);
+    
+    if((RunCount == ArrayCount(Counts)) && (ExtraClocks >= BaseClocks))
+    {
+        *ClocksPerElement = (f64)(ExtraClocks - BaseClocks) / (f64)LISTING_EXTRA_COUNT;
+        Result = true;
+    }
+    
+    return Result;
+}
+
+static f64 TimeNativeKernel(sum_function *Function, u32 Count, u32 *Input, u32 TrialCount)
+{
+    // NOTE(agent): One untimed run first so the input is in cache, then the best of TrialCount runs
+    Function(Count, Input);
+    
+    u64 BestTSC = (u64)-1;
+    for(u32 Trial = 0; Trial < TrialCount; ++Trial)
+    {
+        u64 Start = ReadCPUTimer();
+        Function(Count, Input);
+        u64 Elapsed = ReadCPUTimer() - Start;
+        
+        if(BestTSC > Elapsed)
+        {
+            BestTSC = Elapsed;
+        }
+    }
+    
+    f64 Result = (f64)BestTSC / (f64)Count;
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    char const *Sim86Path = "sim86";
+    char const *ListingDirectory = ".";
+    u32 NativeCount = 4096;
+    u32 TrialCount = 10000;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-sim86") == 0))
+        {
+            Sim86Path = Args[++ArgIndex];
+        }
+        else if(HasValue && (strcmp(Arg, "-listings") == 0))
+        {
+            ListingDirectory = Args[++ArgIndex];
+        }
+        else if(HasValue && (strcmp(Arg, "-count") == 0))
+        {
+            NativeCount = (u32)strtoul(Args[++ArgIndex], 0, 10);
+        }
+        else if(HasValue && (strcmp(Arg, "-trials") == 0))
+        {
+            TrialCount = (u32)strtoul(Args[++ArgIndex], 0, 10);
+        }
+        else
+        {
+            fprintf(stderr, "USAGE: %s [-sim86 path] [-listings directory] [-count elements] [-trials count]\n", Args[0]);
+            return 1;
+        }
+    }
+    
+    // NOTE(agent): The listing 58 loops step by four elements at a time
+    NativeCount &= ~3u;
+    if(NativeCount == 0)
+    {
+        NativeCount = 4;
+    }
+    
+    u32 *Input = (u32 *)malloc(NativeCount*sizeof(u32));
+    if(!Input)
+    {
+        fprintf(stderr, "ERROR: Unable to allocate %u elements of input.\n", NativeCount);
+        return 1;
+    }
+    
+    u32 Value = 0x12345678;
+    for(u32 Index = 0; Index < NativeCount; ++Index)
+    {
+        Value = Value*1664525 + 1013904223;
+        Input[Index] = Value >> 8;
+    }
+    
+    u64 CPUTimerFreq = EstimateCPUTimerFreq(100);
+    printf("CPU timer frequency: %llu (estimated)\n", (unsigned long long)CPUTimerFreq);
+    printf("Native timings are the best of %u runs over %u elements, in CPU timer ticks per element.\n\n", TrialCount, NativeCount);
+    
+    listing_result Results[ArrayCount(ListingKernels)] = {};
+    b32 Valid[ArrayCount(ListingKernels)] = {};
+    u32 ErrorCount = 0;
+    
+    for(u32 KernelIndex = 0; KernelIndex < ArrayCount(ListingKernels); ++KernelIndex)
+    {
+        listing_kernel Kernel = ListingKernels[KernelIndex];
+        listing_result *Result = &Results[KernelIndex];
+        
+        char FileName[1024];
+        snprintf(FileName, sizeof(FileName), "%s/%s", ListingDirectory, Kernel.ListingName);
+        
+        char TempFileName[1024];
+        snprintf(TempFileName, sizeof(TempFileName), "%s.report.tmp", Kernel.ListingName);
+        
+        u8 Listing[4096];
+        u32 ListingSize = LoadListing(FileName, Listing, sizeof(Listing));
+        if(ListingSize)
+        {
+            if((ListingSize >= 3) && (Listing[0] == 0xbf) && (Listing[1] == LISTING_BASE_COUNT) && (Listing[2] == 0))
+            {
+                Valid[KernelIndex] =
+                    (GetClocksPerElement(Sim86Path, TempFileName, Listing, ListingSize, false, &Result->ClocksPerElement8086) &&
+                     GetClocksPerElement(Sim86Path, TempFileName, Listing, ListingSize, true, &Result->ClocksPerElement8088));
+            }
+            else
+            {
+                fprintf(stderr, "ERROR: %s does not start with \"mov di, %u\".\n", FileName, LISTING_BASE_COUNT);
+            }
+        }
+        
+        Result->CyclesPerElementNative = TimeNativeKernel(Kernel.Function, NativeCount, Input, TrialCount);
+        
+        if(!Valid[KernelIndex])
+        {
+            ++ErrorCount;
+        }
+    }
+    
+    printf("%-28s %-14s %10s %10s %10s %8s %8s %8s\n", "Listing", "Kernel",
+           "8086 clk", "8088 clk", "Native", "8086 x", "8088 x", "Native x");
+    for(u32 KernelIndex = 0; KernelIndex < ArrayCount(ListingKernels); ++KernelIndex)
+    {
+        listing_kernel Kernel = ListingKernels[KernelIndex];
+        listing_result Base = Results[0];
+        listing_result Result = Results[KernelIndex];
+        
+        printf("%-28s %-14s ", Kernel.ListingName, Kernel.KernelName);
+        if(Valid[KernelIndex])
+        {
+            printf("%10.2f %10.2f ", Result.ClocksPerElement8086, Result.ClocksPerElement8088);
+        }
+        else
+        {
+            printf("%10s %10s ", "-", "-");
+        }
+        printf("%10.3f ", Result.CyclesPerElementNative);
+        
+        if(Valid[0] && Valid[KernelIndex])
+        {
+            printf("%8.2f %8.2f ", Base.ClocksPerElement8086 / Result.ClocksPerElement8086,
+                   Base.ClocksPerElement8088 / Result.ClocksPerElement8088);
+        }
+        else
+        {
+            printf("%8s %8s ", "-", "-");
+        }
+        printf("%8.2f\n", Base.CyclesPerElementNative / Result.CyclesPerElementNative);
+    }
+    
+    int Result = (ErrorCount == 0) ? 0 : 1;
+    return Result;
+}
@@ -0,0 +1,249 @@
+/* NOTE(agent): SIMD versions of the u32 sum from listing 58, for SSE2, AVX2, and AVX-512, each with 1, 2, or 4
+   independent vector accumulators (the vector equivalents of SingleScalar, DualScalar, and QuadScalar).
+   
+   Unlike the listing 58 loops, these take any Count and any Input alignment. Elements before the first
+   vector-aligned address, and whatever is left over after the last full iteration, are summed with a
+   scalar loop.
+   
+   Which instruction sets can actually be used is checked at runtime with CPUID, so the same executable runs
+   anywhere. Setting the environment variable SUM_ISA to scalar, sse2, avx2, or avx512 limits it to that
+   level (it is never raised past what the CPU supports). */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <immintrin.h>
+
+#include "cpu_features.cpp"
+
+#if _MSC_VER
+#define SUM_TARGET_AVX2
+#define SUM_TARGET_AVX512
+#else
+#define SUM_TARGET_AVX2 __attribute__((target("avx2")))
+#define SUM_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+enum sum_isa
+{
+    SumISA_Scalar,
+    SumISA_SSE2,
+    SumISA_AVX2,
+    SumISA_AVX512,
+    
+    SumISA_Count,
+};
+
+static char const *SumISANames[SumISA_Count] =
+{
+    "scalar",
+    "sse2",
+    "avx2",
+    "avx512",
+};
+
+static sum_isa GetSupportedSumISA(void)
+{
+    sum_isa Result = SumISA_Scalar;
+    
+    cpu_features Features = GetCPUFeatures();
+    if(Features.SSE2)
+    {
+        Result = SumISA_SSE2;
+    }
+    
+    if(Features.AVX2)
+    {
+        Result = SumISA_AVX2;
+        
+        if(Features.AVX512F)
+        {
+            Result = SumISA_AVX512;
+        }
+    }
+    
+    return Result;
+}
+
+static sum_isa GetSumISA(void)
+{
+    sum_isa Result = GetSupportedSumISA();
+    
+    char const *Override = getenv("SUM_ISA");
+    if(Override)
+    {
+        for(u32 ISA = 0; ISA < SumISA_Count; ++ISA)
+        {
+            if((strcmp(Override, SumISANames[ISA]) == 0) && (ISA < (u32)Result))
+            {
+                Result = (sum_isa)ISA;
+            }
+        }
+    }
+    
+    return Result;
+}
+
+static u32 SumUnalignedHead(u32 *Count, u32 **Input, uintptr_t Alignment)
+{
+    u32 Sum = 0;
+    while(*Count && ((uintptr_t)*Input & (Alignment - 1)))
+    {
+        Sum += **Input;
+        ++*Input;
+        --*Count;
+    }
+    
+    return Sum;
+}
+
+static u32 SumTail(u32 Count, u32 *Input)
+{
+    u32 Sum = 0;
+    while(Count--)
+    {
+        Sum += *Input++;
+    }
+    
+    return Sum;
+}
+
+static u32 HorizontalSum(__m128i Value)
+{
+    Value = _mm_add_epi32(Value, _mm_shuffle_epi32(Value, _MM_SHUFFLE(1, 0, 3, 2)));
+    Value = _mm_add_epi32(Value, _mm_shuffle_epi32(Value, _MM_SHUFFLE(2, 3, 0, 1)));
+    u32 Result = (u32)_mm_cvtsi128_si32(Value);
+    return Result;
+}
+
+/* NOTE(agent): The accumulators are written out by hand rather than kept in an array, so there is no
+   question of whether the compiler keeps them all in registers (these are meant to be compiled with
+   unrolling turned off). The "if"s on AccumulatorCount are all resolved at compile time. */
+
+template<u32 AccumulatorCount>
+static u32 SumSSE2(u32 Count, u32 *Input)
+{
+    u32 Sum = SumUnalignedHead(&Count, &Input, 16);
+    
+    __m128i SumA = _mm_setzero_si128();
+    __m128i SumB = _mm_setzero_si128();
+    __m128i SumC = _mm_setzero_si128();
+    __m128i SumD = _mm_setzero_si128();
+    
+    u32 const Stride = 4*AccumulatorCount;
+    while(Count >= Stride)
+    {
+        SumA = _mm_add_epi32(SumA, _mm_load_si128((__m128i *)Input + 0));
+        if(AccumulatorCount > 1)
+        {
+            SumB = _mm_add_epi32(SumB, _mm_load_si128((__m128i *)Input + 1));
+        }
+        if(AccumulatorCount > 2)
+        {
+            SumC = _mm_add_epi32(SumC, _mm_load_si128((__m128i *)Input + 2));
+            SumD = _mm_add_epi32(SumD, _mm_load_si128((__m128i *)Input + 3));
+        }
+        
+        Input += Stride;
+        Count -= Stride;
+    }
+    
+    __m128i Total = _mm_add_epi32(_mm_add_epi32(SumA, SumB), _mm_add_epi32(SumC, SumD));
+    Sum += HorizontalSum(Total);
+    Sum += SumTail(Count, Input);
+    
+    return Sum;
+}
+
+template<u32 AccumulatorCount>
+SUM_TARGET_AVX2 static u32 SumAVX2(u32 Count, u32 *Input)
+{
+    u32 Sum = SumUnalignedHead(&Count, &Input, 32);
+    
+    __m256i SumA = _mm256_setzero_si256();
+    __m256i SumB = _mm256_setzero_si256();
+    __m256i SumC = _mm256_setzero_si256();
+    __m256i SumD = _mm256_setzero_si256();
+    
+    u32 const Stride = 8*AccumulatorCount;
+    while(Count >= Stride)
+    {
+        SumA = _mm256_add_epi32(SumA, _mm256_load_si256((__m256i *)Input + 0));
+        if(AccumulatorCount > 1)
+        {
+            SumB = _mm256_add_epi32(SumB, _mm256_load_si256((__m256i *)Input + 1));
+        }
+        if(AccumulatorCount > 2)
+        {
+            SumC = _mm256_add_epi32(SumC, _mm256_load_si256((__m256i *)Input + 2));
+            SumD = _mm256_add_epi32(SumD, _mm256_load_si256((__m256i *)Input + 3));
+        }
+        
+        Input += Stride;
+        Count -= Stride;
+    }
+    
+    __m256i Total = _mm256_add_epi32(_mm256_add_epi32(SumA, SumB), _mm256_add_epi32(SumC, SumD));
+    Sum += HorizontalSum(_mm_add_epi32(_mm256_castsi256_si128(Total), _mm256_extracti128_si256(Total, 1)));
+    Sum += SumTail(Count, Input);
+    
+    return Sum;
+}
+
+template<u32 AccumulatorCount>
+SUM_TARGET_AVX512 static u32 SumAVX512(u32 Count, u32 *Input)
+{
+    u32 Sum = SumUnalignedHead(&Count, &Input, 64);
+    
+    __m512i SumA = _mm512_setzero_si512();
+    __m512i SumB = _mm512_setzero_si512();
+    __m512i SumC = _mm512_setzero_si512();
+    __m512i SumD = _mm512_setzero_si512();
+    
+    u32 const Stride = 16*AccumulatorCount;
+    while(Count >= Stride)
+    {
+        SumA = _mm512_add_epi32(SumA, _mm512_load_si512((__m512i *)Input + 0));
+        if(AccumulatorCount > 1)
+        {
+            SumB = _mm512_add_epi32(SumB, _mm512_load_si512((__m512i *)Input + 1));
+        }
+        if(AccumulatorCount > 2)
+        {
+            SumC = _mm512_add_epi32(SumC, _mm512_load_si512((__m512i *)Input + 2));
+            SumD = _mm512_add_epi32(SumD, _mm512_load_si512((__m512i *)Input + 3));
+        }
+        
+        Input += Stride;
+        Count -= Stride;
+    }
+    
+    __m512i Total = _mm512_add_epi32(_mm512_add_epi32(SumA, SumB), _mm512_add_epi32(SumC, SumD));
+    // NOTE(agent): Only done once per call, so it is just stored and summed rather than shuffled down
+    u32 Lanes[16];
+    _mm512_storeu_si512(Lanes, Total);
+    Sum += SumTail(16, Lanes);
+    Sum += SumTail(Count, Input);
+    
+    return Sum;
+}
+
+typedef u32 simd_sum_function(u32 Count, u32 *Input);
+
+// NOTE(agent): SSE2 (which every x64 CPU has) until InitSumU32 is called
+static simd_sum_function *SumU32Function = SumSSE2<4>;
+
+static void InitSumU32(void)
+{
+    /* NOTE(agent): Picks the widest implementation available. This has to be called before any threads that
+       call SumU32 are started - it is the only thing that ever writes SumU32Function, so after it, any number
+       of threads can call SumU32 at once. */
+    simd_sum_function *Functions[SumISA_Count] = {SumTail, SumSSE2<4>, SumAVX2<4>, SumAVX512<4>};
+    SumU32Function = Functions[GetSumISA()];
+}
+
+static u32 SumU32(u32 Count, u32 *Input)
+{
+    u32 Result = SumU32Function(Count, Input);
+    return Result;
+}
@@ -0,0 +1,221 @@
+/* NOTE(agent): Runs one of the sum kernels on several cores at once. The input is cut into one contiguous
+   partition per thread, each thread sums its own partition with the same kernel, and the partial sums are
+   added together at the end (u32 addition wraps, so the order they are combined in doesn't matter).
+   
+   Since the point is to time the sums and not the OS, the threads are started once per thread count, pinned
+   to their own logical processor, and then kept spinning between runs. Each run is started by bumping
+   a generation counter, and is over once every thread has reported in, so the time for a run includes
+   getting every thread going and waiting for the slowest one - which is what the caller would actually
+   see. The calling thread is always thread 0 and sums the first partition itself. */
+
+#include "../part2/os_thread.cpp"
+
+#define MAX_SUM_THREADS 256
+
+struct sum_thread_slot
+{
+    // NOTE(agent): Each thread only ever writes its own slot, and slots are a cache line apart, so the
+    // threads never fight over a line while they are running.
+    u32 volatile Sum;
+    u8 Pad[60];
+};
+
+struct sum_thread_pool
+{
+    sum_function *Function;
+    u32 *Input;
+    u32 Count;
+    
+    u32 ThreadCount;
+    u32 volatile Generation;
+    u32 volatile DoneCount;
+    b32 volatile Quit;
+    
+    u32 StartedCount;
+    os_thread Threads[MAX_SUM_THREADS];
+    sum_thread_slot Slots[MAX_SUM_THREADS];
+};
+
+struct sum_thread_param
+{
+    sum_thread_pool *Pool;
+    u32 ThreadIndex;
+};
+
+static b32 PinThreadToProcessor(u32 ProcessorIndex)
+{
+#if _WIN32
+    // NOTE(agent): This only reaches the first 64 processors (one processor group), which is more than enough here
+    b32 Result = false;
+    if(ProcessorIndex < 64)
+    {
+        Result = (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << ProcessorIndex) != 0);
+    }
+#else
+    // NOTE(agent): ProcessorIndex counts the processors this process is allowed to run on, which are not
+    // necessarily numbered 0 to N-1 (under taskset, or in a container).
+    b32 Result = false;
+    cpu_set_t Allowed;
+    CPU_ZERO(&Allowed);
+    if(sched_getaffinity(0, sizeof(Allowed), &Allowed) == 0)
+    {
+        u32 Seen = 0;
+        for(u32 CPU = 0; CPU < CPU_SETSIZE; ++CPU)
+        {
+            if(CPU_ISSET(CPU, &Allowed))
+            {
+                if(Seen++ == ProcessorIndex)
+                {
+                    cpu_set_t Set;
+                    CPU_ZERO(&Set);
+                    CPU_SET(CPU, &Set);
+                    Result = (pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set) == 0);
+                    break;
+                }
+            }
+        }
+    }
+#endif
+
+    return Result;
+}
+
+static void WaitWhileEqual(u32 volatile *Value, u32 Compare)
+{
+    // NOTE(agent): Spinning is what keeps the start and finish of a run fast, but if there are more threads than
+    // free processors, a spinning thread can be sitting on the processor the thread it's waiting on needs. So after
+    // a while it starts giving the processor up between checks.
+    u32 SpinCount = 0;
+    while(*Value == Compare)
+    {
+        if(SpinCount < 4096)
+        {
+            ++SpinCount;
+            _mm_pause();
+        }
+        else
+        {
+            YieldThread();
+        }
+    }
+}
+
+static void GetPartition(u32 Count, u32 ThreadCount, u32 ThreadIndex, u32 *First, u32 *PartitionCount)
+{
+    // NOTE(agent): Partitions start on 16-element (64-byte) boundaries, so no two threads ever share a cache line,
+    // and every partition but the last is a multiple of four elements, which the listing 58 loops require.
+    // The last one gets whatever is left.
+    u32 Size = (Count / ThreadCount) & ~15u;
+    *First = Size*ThreadIndex;
+    *PartitionCount = (ThreadIndex == (ThreadCount - 1)) ? (Count - *First) : Size;
+}
+
+static void SumPartition(sum_thread_pool *Pool, u32 ThreadIndex)
+{
+    u32 First, PartitionCount;
+    GetPartition(Pool->Count, Pool->ThreadCount, ThreadIndex, &First, &PartitionCount);
+    Pool->Slots[ThreadIndex].Sum = Pool->Function(PartitionCount, Pool->Input + First);
+}
+
+static void SumWorkerLoop(sum_thread_param *Param)
+{
+    sum_thread_pool *Pool = Param->Pool;
+    u32 ThreadIndex = Param->ThreadIndex;
+    free(Param);
+    
+    PinThreadToProcessor(ThreadIndex);
+    
+    u32 SeenGeneration = 0;
+    for(;;)
+    {
+        WaitWhileEqual(&Pool->Generation, SeenGeneration);
+        SeenGeneration = Pool->Generation;
+        
+        if(Pool->Quit)
+        {
+            break;
+        }
+        
+        SumPartition(Pool, ThreadIndex);
+        AtomicIncrementU32(&Pool->DoneCount);
+    }
+}
+
+static THREAD_PROC(SumThreadProc)
+{
+    SumWorkerLoop((sum_thread_param *)Param);
+    return 0;
+}
+
+static b32 StartSumThreads(sum_thread_pool *Pool, u32 ThreadCount)
+{
+    Pool->ThreadCount = ThreadCount;
+    Pool->Generation = 0;
+    Pool->DoneCount = 0;
+    Pool->Quit = false;
+    Pool->StartedCount = 0;
+    
+    PinThreadToProcessor(0);
+    
+    for(u32 ThreadIndex = 1; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        sum_thread_param *Param = (sum_thread_param *)malloc(sizeof(sum_thread_param));
+        Param->Pool = Pool;
+        Param->ThreadIndex = ThreadIndex;
+        
+        os_thread Thread;
+        if(!StartThread(&Thread, SumThreadProc, Param))
+        {
+            free(Param);
+            break;
+        }
+        
+        Pool->Threads[Pool->StartedCount++] = Thread;
+    }
+    
+    // NOTE(agent): Unlike a work queue, every partition has to have a thread, so if any thread failed to start,
+    // the caller gets told instead of quietly measuring fewer threads than it asked for.
+    b32 Result = (Pool->StartedCount == (ThreadCount - 1));
+    return Result;
+}
+
+static void StopSumThreads(sum_thread_pool *Pool)
+{
+    Pool->Quit = true;
+    AtomicIncrementU32(&Pool->Generation);
+    
+    for(u32 ThreadIndex = 0; ThreadIndex < Pool->StartedCount; ++ThreadIndex)
+    {
+        JoinThread(Pool->Threads[ThreadIndex]);
+    }
+    
+    Pool->StartedCount = 0;
+}
+
+static u32 RunSumThreads(sum_thread_pool *Pool, sum_function *Function, u32 Count, u32 *Input)
+{
+    Pool->Function = Function;
+    Pool->Count = Count;
+    Pool->Input = Input;
+    Pool->DoneCount = 0;
+    
+    // NOTE(agent): The locked increment is a full barrier, so the workers see everything above before they see the new generation
+    AtomicIncrementU32(&Pool->Generation);
+    
+    SumPartition(Pool, 0);
+    
+    // NOTE(agent): Every worker bumps DoneCount exactly once per run, so it only ever counts up to WorkerCount
+    u32 WorkerCount = Pool->ThreadCount - 1;
+    for(u32 Done = Pool->DoneCount; Done != WorkerCount; Done = Pool->DoneCount)
+    {
+        WaitWhileEqual(&Pool->DoneCount, Done);
+    }
+    
+    u32 Result = 0;
+    for(u32 ThreadIndex = 0; ThreadIndex < Pool->ThreadCount; ++ThreadIndex)
+    {
+        Result += Pool->Slots[ThreadIndex].Sum;
+    }
+    
+    return Result;
+}
@@ -0,0 +1,235 @@
+/* NOTE(agent): A linear arena. Memory is handed out by bumping an offset, and given back by moving the offset
+   back to where it was at some earlier point - GetArenaPos/PopArenaTo, or BeginTemp/EndTemp around a scope, or
+   ClearArena to go all the way back. Nothing is ever freed on its own, so there is no per-allocation bookkeeping
+   at all, and a push is an align, a compare and an add.
+   
+   The memory comes from the OS in blocks (see os_memory.cpp), allocated with the arena's Policy, so an arena's
+   pages get faulted in however the program asks for any other os_memory. When a push doesn't fit in the current
+   block, the next block is at least twice as big as the current one (and at least MinimumBlockSize, and big
+   enough for the push), so an arena that grows to N bytes only makes about log2(N) OS calls.
+   
+   Blocks are not given back to the OS until FreeArena. A block that gets popped goes on a free list instead,
+   and when a new block is needed, the smallest free block that is big enough is reused. So a program that does
+   the same work over and over - pushing everything inside a temp scope, and popping it all at the end - only
+   asks the OS for memory on the first run. Every run after that makes no allocation calls at all, and since
+   the pages it gets back have already been touched, it takes no page faults either.
+   
+   Pushes are not cleared, unless they are done with PushSizeZero (or PushArrayZero) - memory from a reused
+   block has whatever was last written there. Alignment can be any power of two, and is of the actual address
+   (a new block gets enough extra room to align its first push). Pushes return 0 if the OS is out of memory.
+   
+   An arena is not thread-safe. Memory for other threads to work in has to be pushed ahead of time, by the
+   thread that owns the arena, and handed to them.
+   
+   usage:
+   
+   arena Arena = {}; // NOTE(agent): Lazy pages, ARENA_MINIMUM_BLOCK_SIZE blocks. Or set Policy/MinimumBlockSize.
+   
+   temp_arena Temp = BeginTemp(&Arena);
+   f64 *Values = PushArray(&Arena, Count, f64);
+   // ... use Values ...
+   EndTemp(Temp);
+   
+   FreeArena(&Arena); */
+
+#define ARENA_MINIMUM_BLOCK_SIZE (1024*1024)
+#define ARENA_DEFAULT_ALIGNMENT 16
+
+// NOTE(agent): The block header is padded to a cache line, so the first push in a block is cache-line aligned
+#define ARENA_BLOCK_HEADER_SIZE 64
+
+struct arena_block
+{
+    // NOTE(agent): Lives at the start of the block's own memory
+    os_memory Memory;
+    arena_block *Prev;
+    
+    u64 Base; // NOTE(agent): The arena position of this block's first byte
+    u64 Used;
+};
+
+struct arena
+{
+    arena_block *Current;
+    arena_block *FreeBlocks;
+    
+    // NOTE(agent): These only affect blocks allocated after they are set
+    memory_policy Policy;
+    u64 MinimumBlockSize;
+    
+    u64 OSAllocationCount;
+};
+
+struct temp_arena
+{
+    arena *Arena;
+    u64 Pos;
+};
+
+#define PushArray(Arena, Count, type) ((type *)PushSize(Arena, (Count)*sizeof(type)))
+#define PushArrayZero(Arena, Count, type) ((type *)PushSizeZero(Arena, (Count)*sizeof(type)))
+#define PushStruct(Arena, type) PushArray(Arena, 1, type)
+
+static u64 GetBlockCapacity(arena_block *Block)
+{
+    u64 Result = Block->Memory.MappedSize - ARENA_BLOCK_HEADER_SIZE;
+    return Result;
+}
+
+static u64 GetArenaPos(arena *Arena)
+{
+    arena_block *Block = Arena->Current;
+    u64 Result = Block ? (Block->Base + Block->Used) : 0;
+    return Result;
+}
+
+static arena_block *GetArenaBlock(arena *Arena, u64 Capacity)
+{
+    arena_block **BestLink = 0;
+    for(arena_block **Link = &Arena->FreeBlocks; *Link; Link = &(*Link)->Prev)
+    {
+        u64 FreeCapacity = GetBlockCapacity(*Link);
+        if((FreeCapacity >= Capacity) && (!BestLink || (FreeCapacity < GetBlockCapacity(*BestLink))))
+        {
+            BestLink = Link;
+        }
+    }
+    
+    arena_block *Result = 0;
+    if(BestLink)
+    {
+        Result = *BestLink;
+        *BestLink = Result->Prev;
+    }
+    else
+    {
+        u64 Size = ARENA_BLOCK_HEADER_SIZE + Capacity;
+        u64 MinimumSize = Arena->MinimumBlockSize ? Arena->MinimumBlockSize : ARENA_MINIMUM_BLOCK_SIZE;
+        if(Arena->Current && (Size < 2*Arena->Current->Memory.MappedSize))
+        {
+            Size = 2*Arena->Current->Memory.MappedSize;
+        }
+        if(Size < MinimumSize)
+        {
+            Size = MinimumSize;
+        }
+        
+        os_memory Memory = AllocateOSMemory(Size, Arena->Policy);
+        if(Memory.Data)
+        {
+            ++Arena->OSAllocationCount;
+            
+            Result = (arena_block *)Memory.Data;
+            Result->Memory = Memory;
+        }
+    }
+    
+    return Result;
+}
+
+static u64 GetAlignedOffset(arena_block *Block, u64 Used, u64 Alignment)
+{
+    // NOTE(agent): Aligns the address, not the offset, since the data starts a header into the block
+    u64 Data = (u64)Block + ARENA_BLOCK_HEADER_SIZE;
+    u64 Result = AlignOSMemorySize(Data + Used, Alignment) - Data;
+    return Result;
+}
+
+static void *PushSize(arena *Arena, u64 Size, u64 Alignment = ARENA_DEFAULT_ALIGNMENT)
+{
+    void *Result = 0;
+    
+    arena_block *Block = Arena->Current;
+    u64 Offset = Block ? GetAlignedOffset(Block, Block->Used, Alignment) : 0;
+    if(!Block || ((Offset + Size) > GetBlockCapacity(Block)))
+    {
+        // NOTE(agent): Whatever was left at the end of the current block is skipped. Blocks start page-aligned,
+        // so the data in a new one is ARENA_BLOCK_HEADER_SIZE-aligned, and anything more than that needs at most
+        // Alignment - ARENA_BLOCK_HEADER_SIZE bytes of padding in front of the push.
+        u64 Padding = (Alignment > ARENA_BLOCK_HEADER_SIZE) ? (Alignment - ARENA_BLOCK_HEADER_SIZE) : 0;
+        Block = GetArenaBlock(Arena, Size + Padding);
+        if(Block)
+        {
+            Block->Prev = Arena->Current;
+            Block->Base = Block->Prev ? (Block->Prev->Base + GetBlockCapacity(Block->Prev)) : 0;
+            Arena->Current = Block;
+            Offset = GetAlignedOffset(Block, 0, Alignment);
+        }
+    }
+    
+    if(Block)
+    {
+        Result = (u8 *)Block + ARENA_BLOCK_HEADER_SIZE + Offset;
+        Block->Used = Offset + Size;
+    }
+    
+    return Result;
+}
+
+static void *PushSizeZero(arena *Arena, u64 Size, u64 Alignment = ARENA_DEFAULT_ALIGNMENT)
+{
+    void *Result = PushSize(Arena, Size, Alignment);
+    if(Result)
+    {
+        memset(Result, 0, Size);
+    }
+    
+    return Result;
+}
+
+static void PopArenaTo(arena *Arena, u64 Pos)
+{
+    // NOTE(agent): Pos has to have come from GetArenaPos, on this arena, since the last time it was popped to
+    // before that
+    while(Arena->Current && (Arena->Current->Base > Pos))
+    {
+        arena_block *Block = Arena->Current;
+        Arena->Current = Block->Prev;
+        
+        Block->Prev = Arena->FreeBlocks;
+        Arena->FreeBlocks = Block;
+    }
+    
+    if(Arena->Current)
+    {
+        Arena->Current->Used = Pos - Arena->Current->Base;
+    }
+}
+
+static temp_arena BeginTemp(arena *Arena)
+{
+    temp_arena Result = {};
+    Result.Arena = Arena;
+    Result.Pos = GetArenaPos(Arena);
+    return Result;
+}
+
+static void EndTemp(temp_arena Temp)
+{
+    PopArenaTo(Temp.Arena, Temp.Pos);
+}
+
+static void ClearArena(arena *Arena)
+{
+    PopArenaTo(Arena, 0);
+}
+
+static void FreeArenaBlocks(arena_block *Block)
+{
+    while(Block)
+    {
+        // NOTE(agent): The block's os_memory is inside the memory it describes, so it has to be copied out first
+        os_memory Memory = Block->Memory;
+        Block = Block->Prev;
+        FreeOSMemory(&Memory);
+    }
+}
+
+static void FreeArena(arena *Arena)
+{
+    FreeArenaBlocks(Arena->Current);
+    FreeArenaBlocks(Arena->FreeBlocks);
+    
+    Arena->Current = 0;
+    Arena->FreeBlocks = 0;
+}
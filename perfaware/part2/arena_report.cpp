@@ -0,0 +1,241 @@
+/* NOTE(agent): Shows what keeping an arena (see arena.cpp) from one run to the next is worth. The same haversine
+   run is done -runs times in a row, two ways:
+   
+   fresh: A new arena for every run, freed at the end of it. Every run gets all of its memory from the OS, and
+          faults in all of its pages, which is what every run did back when each buffer was malloc'd and freed
+          (or allocated and freed with os_memory) on its own.
+   kept:  One arena for all of the runs. The first run allocates, and every run after that pops back to where
+          it started and reuses the same (already faulted-in) memory.
+   
+   Usage: arena_report [-runs count] [-threads count] [data.json]
+   
+   The runs are "serial" (read the whole file, parse it, compute the distances, sum them) and "pipeline" (see
+   haversine_pipeline.cpp, with -threads threads). For the first run and for the runs after it, it prints the
+   time (the fastest run, for the later ones), the calls into the C runtime heap (malloc, calloc, realloc and free,
+   from anywhere - including the C runtime itself, for things like fopen), the blocks the arena asked the OS for,
+   and the page faults. The heap calls are counted by replacing malloc and friends with versions that count
+   and then call the C runtime's own, which only works with glibc - anywhere else, that column is left blank.
+   The later-run counts are the most any one of those runs made.
+   
+   Whatever heap calls are left in the kept runs are not the haversine code's: they are fopen/fclose, and
+   whatever the OS's thread library needs when threads are started. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__GLIBC__)
+
+#define HEAP_CALLS_COUNTED 1
+
+extern "C" void *__libc_malloc(size_t Size);
+extern "C" void *__libc_calloc(size_t Count, size_t Size);
+extern "C" void *__libc_realloc(void *Memory, size_t Size);
+extern "C" void __libc_free(void *Memory);
+
+static unsigned long long volatile GlobalHeapCallCount;
+
+extern "C" void *malloc(size_t Size) __THROW
+{
+    __sync_fetch_and_add(&GlobalHeapCallCount, 1);
+    return __libc_malloc(Size);
+}
+
+extern "C" void *calloc(size_t Count, size_t Size) __THROW
+{
+    __sync_fetch_and_add(&GlobalHeapCallCount, 1);
+    return __libc_calloc(Count, Size);
+}
+
+extern "C" void *realloc(void *Memory, size_t Size) __THROW
+{
+    __sync_fetch_and_add(&GlobalHeapCallCount, 1);
+    return __libc_realloc(Memory, Size);
+}
+
+extern "C" void free(void *Memory) __THROW
+{
+    if(Memory)
+    {
+        __sync_fetch_and_add(&GlobalHeapCallCount, 1);
+    }
+    __libc_free(Memory);
+}
+
+#else
+
+#define HEAP_CALLS_COUNTED 0
+
+static unsigned long long GlobalHeapCallCount;
+
+#endif
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "profiler.cpp"
+#include "listing_0065_haversine_formula.cpp"
+#include "os_memory.cpp"
+#include "arena.cpp"
+#include "haversine_json.cpp"
+#include "haversine_math.cpp"
+#include "haversine_batch.cpp"
+#include "os_thread.cpp"
+#include "deterministic_sum.cpp"
+#include "haversine_pipeline.cpp"
+
+enum arena_test
+{
+    ArenaTest_Serial,
+    ArenaTest_Pipeline,
+    
+    ArenaTest_Count,
+};
+
+static char const *ArenaTestNames[ArenaTest_Count] =
+{
+    "serial",
+    "pipeline",
+};
+
+struct run_cost
+{
+    u64 Time;
+    u64 HeapCalls;
+    u64 OSAllocations;
+    u64 PageFaults;
+};
+
+static void PrintCost(char const *Name, char const *ArenaName, char const *Runs, run_cost Cost, u64 CPUTimerFreq)
+{
+    fprintf(stdout, "%-10s %-6s %-6s %10.2f", Name, ArenaName, Runs, 1000.0*SecondsFromCPUTime((f64)Cost.Time, CPUTimerFreq));
+    if(HEAP_CALLS_COUNTED)
+    {
+        fprintf(stdout, " %10llu", Cost.HeapCalls);
+    }
+    else
+    {
+        fprintf(stdout, " %10s", "");
+    }
+    fprintf(stdout, " %10llu %10llu\n", Cost.OSAllocations, Cost.PageFaults);
+}
+
+int main(int ArgCount, char **Args)
+{
+    // NOTE(agent): Before any threads are started (see InitHaversineBatch)
+    InitHaversineBatch();
+    
+    u32 RunCount = 10;
+    u32 ThreadCount = GetProcessorCount();
+    char *JSONFileName = 0;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-runs") == 0))
+        {
+            RunCount = atoi(Args[++ArgIndex]);
+        }
+        else if(HasValue && (strcmp(Arg, "-threads") == 0))
+        {
+            ThreadCount = atoi(Args[++ArgIndex]);
+        }
+        else if(!JSONFileName)
+        {
+            JSONFileName = Arg;
+        }
+        else
+        {
+            JSONFileName = 0;
+            break;
+        }
+    }
+    
+    if(!JSONFileName || (RunCount < 2) || (ThreadCount < 1) || (ThreadCount > MAX_PIPELINE_THREADS))
+    {
+        fprintf(stderr, "USAGE: %s [-runs 2 or more] [-threads 1 to %u] [data.json]\n", Args[0], MAX_PIPELINE_THREADS);
+        return 1;
+    }
+    
+    u64 CPUTimerFreq = GetCPUTimerFreq();
+    memory_policy Policy = GetDefaultMemoryPolicy();
+    
+    fprintf(stdout, "Runs: %u, pipeline threads: %u, memory policy: %s\n\n", RunCount, ThreadCount, MemoryPolicyNames[Policy]);
+    fprintf(stdout, "%-10s %-6s %-6s %10s %10s %10s %10s\n", "Run", "Arena", "Runs", "ms", "Heap", "OS", "Faults");
+    
+    int Result = 0;
+    
+    for(u32 Test = 0; Test < ArenaTest_Count; ++Test)
+    {
+        for(u32 Kept = 0; Kept < 2; ++Kept)
+        {
+            arena KeptArena = {};
+            KeptArena.Policy = Policy;
+            
+            run_cost First = {};
+            run_cost Later = {};
+            Later.Time = (u64)-1;
+            
+            for(u32 RunIndex = 0; RunIndex < RunCount; ++RunIndex)
+            {
+                arena FreshArena = {};
+                FreshArena.Policy = Policy;
+                arena *Arena = Kept ? &KeptArena : &FreshArena;
+                
+                u64 StartOSAllocations = Arena->OSAllocationCount;
+                u64 StartHeapCalls = GlobalHeapCallCount;
+                u64 StartPageFaults = ReadOSPageFaultCount();
+                u64 StartTime = ReadCPUTimer();
+                
+                pipeline_result Run = {};
+                if(Test == ArenaTest_Serial)
+                {
+                    Run = ComputeHaversineAverageSerial(Arena, JSONFileName);
+                }
+                else
+                {
+                    Run = ComputeHaversineAveragePipelined(Arena, JSONFileName, ThreadCount);
+                }
+                
+                if(!Kept)
+                {
+                    FreeArena(Arena);
+                }
+                
+                run_cost Cost = {};
+                Cost.Time = ReadCPUTimer() - StartTime;
+                Cost.PageFaults = ReadOSPageFaultCount() - StartPageFaults;
+                Cost.HeapCalls = GlobalHeapCallCount - StartHeapCalls;
+                Cost.OSAllocations = Arena->OSAllocationCount - StartOSAllocations;
+                
+                if(!Run.Valid)
+                {
+                    fprintf(stderr, "ERROR: The %s run failed.\n", ArenaTestNames[Test]);
+                    return 1;
+                }
+                
+                if(RunIndex == 0)
+                {
+                    First = Cost;
+                }
+                else
+                {
+                    if(Later.Time > Cost.Time) {Later.Time = Cost.Time;}
+                    if(Later.HeapCalls < Cost.HeapCalls) {Later.HeapCalls = Cost.HeapCalls;}
+                    if(Later.OSAllocations < Cost.OSAllocations) {Later.OSAllocations = Cost.OSAllocations;}
+                    if(Later.PageFaults < Cost.PageFaults) {Later.PageFaults = Cost.PageFaults;}
+                }
+            }
+            
+            PrintCost(ArenaTestNames[Test], Kept ? "kept" : "fresh", "first", First, CPUTimerFreq);
+            PrintCost(ArenaTestNames[Test], Kept ? "kept" : "fresh", "later", Later, CPUTimerFreq);
+            
+            FreeArena(&KeptArena);
+        }
+    }
+    
+    return Result;
+}
@@ -0,0 +1,32 @@
+@echo off
+IF NOT EXIST build mkdir build
+pushd build
+
+call cl -O2 -nologo -Zi -FC ..\haversine_generator.cpp -Fehaversine_generator_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\haversine_generator.cpp -o haversine_generator_clang.exe
+call cl -O2 -nologo -Zi -FC ..\haversine_processor.cpp -Fehaversine_processor_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\haversine_processor.cpp -o haversine_processor_clang.exe
+call clang -O3 -g -fuse-ld=lld -DPROFILER=1 ..\haversine_processor.cpp -o haversine_processor_profiled_clang.exe
+call cl -O2 -nologo -Zi -FC ..\haversine_batch_report.cpp -Fehaversine_batch_report_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\haversine_batch_report.cpp -o haversine_batch_report_clang.exe
+call cl -O2 -nologo -Zi -FC ..\haversine_math_report.cpp -Fehaversine_math_report_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\haversine_math_report.cpp -o haversine_math_report_clang.exe
+call cl -O2 -nologo -Zi -FC ..\haversine_pipeline_report.cpp -Fehaversine_pipeline_report_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\haversine_pipeline_report.cpp -o haversine_pipeline_report_clang.exe
+call clang -O3 -g -fuse-ld=lld -DPROFILER=1 ..\haversine_pipeline_report.cpp -o haversine_pipeline_report_profiled_clang.exe
+call cl -O2 -nologo -Zi -FC ..\file_reader_report.cpp -Fefile_reader_report_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\file_reader_report.cpp -o file_reader_report_clang.exe
+call cl -O2 -nologo -Zi -FC ..\read_bandwidth_test.cpp -Feread_bandwidth_test_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\read_bandwidth_test.cpp -o read_bandwidth_test_clang.exe
+call cl -O2 -nologo -Zi -FC ..\page_fault_probe.cpp -Fepage_fault_probe_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\page_fault_probe.cpp -o page_fault_probe_clang.exe
+call cl -O2 -nologo -Zi -FC ..\haversine_convert.cpp -Fehaversine_convert_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\haversine_convert.cpp -o haversine_convert_clang.exe
+call cl -O2 -nologo -Zi -FC ..\haversine_f32_report.cpp -Fehaversine_f32_report_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\haversine_f32_report.cpp -o haversine_f32_report_clang.exe
+call cl -O2 -nologo -Zi -FC ..\deterministic_sum_test.cpp -Fedeterministic_sum_test_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\deterministic_sum_test.cpp -o deterministic_sum_test_clang.exe
+call cl -O2 -nologo -Zi -FC ..\arena_report.cpp -Fearena_report_msvc.exe
+call clang -O3 -g -fuse-ld=lld ..\arena_report.cpp -o arena_report_clang.exe
+
+popd
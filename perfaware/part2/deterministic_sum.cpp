@@ -0,0 +1,340 @@
+/* NOTE(agent): Sums a sequence of f64s so that the result only depends on the values and their order - not on how
+   many threads do the summing, or on how the sequence is cut up into spans in memory. f64 addition isn't
+   associative, so any summation that lets the split change which values get added to which partial sum changes
+   the last few digits of the result. Here the split is fixed by the position of each value in the sequence:
+   
+   1) The sequence is cut into blocks of SUM_BLOCK_COUNT values, counting from the first value of the first span.
+      A block that crosses from one span into the next is copied into one place first, so every block is summed
+      the same way from the same contiguous values, wherever it came from.
+   
+   2) Each block is summed in 16 lanes (8 SSE2 registers), value N going into lane N % 16, with compensated
+      summation: every add also works out exactly what it rounded off (Knuth's TwoSum), and those are summed
+      separately. The lanes are then folded together pairwise, in a fixed order, the same way.
+   
+   3) The block sums (each still a value plus the error it rounded off) are combined in a fixed pairwise tree:
+      0+1, 2+3, ..., then those pairs, and so on, with an odd one out carried up a level as it is.
+   
+   Threads only ever get whole blocks, and write each block's sum to its own slot, so the thread count just
+   changes who computes which slot. The results are the same on any x64 CPU, since it's all plain SSE2 adds
+   and subtracts (no FMAs), but they do depend on the compiler keeping the adds in the order they're written -
+   compensated summation is exactly what fast-math optimizations are allowed to break.
+   
+   The compensation also makes the result far more accurate than a plain running sum: the error is about one
+   rounding of the total, rather than growing with the number of values. A TwoSum is six adds and subtracts, but
+   only one of them is on the dependency chain from one value to the next, so 16 lanes of them still keep up
+   with memory bandwidth.
+   
+   The block sums go on the arena that is passed in, and are popped off again before returning. Needs
+   os_thread.cpp and arena.cpp included first. */
+
+#include <emmintrin.h>
+
+#define SUM_BLOCK_COUNT 4096
+#define SUM_MAX_THREADS 256
+
+struct sum_span
+{
+    f64 *Values;
+    u64 Count;
+};
+
+struct sum_part
+{
+    // NOTE(agent): The sum is Value + Error, where Error is what the adds that made Value rounded off
+    f64 Value;
+    f64 Error;
+};
+
+struct sum_job
+{
+    sum_span *Spans;
+    u64 *SpanStarts;
+    u32 SpanCount;
+    
+    u64 TotalCount;
+    u64 BlockCount;
+    sum_part *BlockSums;
+    
+    u32 ThreadCount;
+};
+
+struct sum_thread
+{
+    sum_job *Job;
+    u32 ThreadIndex;
+};
+
+static sum_part AddSumParts(sum_part A, sum_part B)
+{
+    f64 Value = A.Value + B.Value;
+    f64 Z = Value - A.Value;
+    f64 Lost = (A.Value - (Value - Z)) + (B.Value - Z);
+    
+    sum_part Result = {Value, (A.Error + B.Error) + Lost};
+    return Result;
+}
+
+static inline void AddLanes(__m128d *Sum, __m128d *Error, __m128d X)
+{
+    // NOTE(agent): TwoSum, two lanes at a time
+    __m128d Value = _mm_add_pd(*Sum, X);
+    __m128d Z = _mm_sub_pd(Value, *Sum);
+    __m128d Lost = _mm_add_pd(_mm_sub_pd(*Sum, _mm_sub_pd(Value, Z)), _mm_sub_pd(X, Z));
+    
+    *Sum = Value;
+    *Error = _mm_add_pd(*Error, Lost);
+}
+
+static sum_part SumBlock(f64 *Values, u64 Count)
+{
+    // NOTE(agent): Count <= SUM_BLOCK_COUNT
+    __m128d Sum0 = _mm_setzero_pd(), Sum1 = _mm_setzero_pd(), Sum2 = _mm_setzero_pd(), Sum3 = _mm_setzero_pd();
+    __m128d Sum4 = _mm_setzero_pd(), Sum5 = _mm_setzero_pd(), Sum6 = _mm_setzero_pd(), Sum7 = _mm_setzero_pd();
+    __m128d Error0 = _mm_setzero_pd(), Error1 = _mm_setzero_pd(), Error2 = _mm_setzero_pd(), Error3 = _mm_setzero_pd();
+    __m128d Error4 = _mm_setzero_pd(), Error5 = _mm_setzero_pd(), Error6 = _mm_setzero_pd(), Error7 = _mm_setzero_pd();
+    
+    f64 Pad[16] = {};
+    for(u64 Index = 0; Index < Count; Index += 16)
+    {
+        // NOTE(agent): The last few values are padded out to 16 with zeros, which changes nothing but is the same
+        // every time
+        f64 *At = Values + Index;
+        if((Count - Index) < 16)
+        {
+            memcpy(Pad, At, (Count - Index)*sizeof(f64));
+            At = Pad;
+        }
+        
+        AddLanes(&Sum0, &Error0, _mm_loadu_pd(At + 0));
+        AddLanes(&Sum1, &Error1, _mm_loadu_pd(At + 2));
+        AddLanes(&Sum2, &Error2, _mm_loadu_pd(At + 4));
+        AddLanes(&Sum3, &Error3, _mm_loadu_pd(At + 6));
+        AddLanes(&Sum4, &Error4, _mm_loadu_pd(At + 8));
+        AddLanes(&Sum5, &Error5, _mm_loadu_pd(At + 10));
+        AddLanes(&Sum6, &Error6, _mm_loadu_pd(At + 12));
+        AddLanes(&Sum7, &Error7, _mm_loadu_pd(At + 14));
+    }
+    
+    f64 Sums[16];
+    f64 Errors[16];
+    __m128d SumLanes[] = {Sum0, Sum1, Sum2, Sum3, Sum4, Sum5, Sum6, Sum7};
+    __m128d ErrorLanes[] = {Error0, Error1, Error2, Error3, Error4, Error5, Error6, Error7};
+    for(u32 Register = 0; Register < 8; ++Register)
+    {
+        _mm_storeu_pd(Sums + 2*Register, SumLanes[Register]);
+        _mm_storeu_pd(Errors + 2*Register, ErrorLanes[Register]);
+    }
+    
+    sum_part Lanes[16];
+    for(u32 Lane = 0; Lane < 16; ++Lane)
+    {
+        Lanes[Lane].Value = Sums[Lane];
+        Lanes[Lane].Error = Errors[Lane];
+    }
+    
+    for(u32 Width = 16; Width > 1; Width /= 2)
+    {
+        for(u32 Lane = 0; Lane < Width/2; ++Lane)
+        {
+            Lanes[Lane] = AddSumParts(Lanes[2*Lane], Lanes[2*Lane + 1]);
+        }
+    }
+    
+    return Lanes[0];
+}
+
+static u32 FindSpan(sum_job *Job, u64 Start)
+{
+    // NOTE(agent): The last span that starts at or before Start. It might be empty, or end right at Start, in which
+    // case the caller moves on from it.
+    u32 Low = 0;
+    u32 High = Job->SpanCount;
+    while((High - Low) > 1)
+    {
+        u32 Middle = Low + (High - Low)/2;
+        if(Job->SpanStarts[Middle] <= Start)
+        {
+            Low = Middle;
+        }
+        else
+        {
+            High = Middle;
+        }
+    }
+    
+    return Low;
+}
+
+static void SumBlocks(sum_job *Job, u32 ThreadIndex)
+{
+    u64 FirstBlock = (Job->BlockCount*ThreadIndex) / Job->ThreadCount;
+    u64 EndBlock = (Job->BlockCount*(ThreadIndex + 1)) / Job->ThreadCount;
+    if(FirstBlock >= EndBlock)
+    {
+        return;
+    }
+    
+    u64 Start = FirstBlock*SUM_BLOCK_COUNT;
+    u32 SpanIndex = FindSpan(Job, Start);
+    u64 Offset = Start - Job->SpanStarts[SpanIndex];
+    
+    f64 Gathered[SUM_BLOCK_COUNT];
+    for(u64 Block = FirstBlock; Block < EndBlock; ++Block)
+    {
+        u64 Count = Job->TotalCount - Block*SUM_BLOCK_COUNT;
+        if(Count > SUM_BLOCK_COUNT)
+        {
+            Count = SUM_BLOCK_COUNT;
+        }
+        
+        u64 GatheredCount = 0;
+        f64 *Values = 0;
+        while(GatheredCount < Count)
+        {
+            sum_span *Span = Job->Spans + SpanIndex;
+            if(Offset == Span->Count)
+            {
+                ++SpanIndex;
+                Offset = 0;
+                continue;
+            }
+            
+            u64 Take = Span->Count - Offset;
+            if(Take > (Count - GatheredCount))
+            {
+                Take = Count - GatheredCount;
+            }
+            
+            if((GatheredCount == 0) && (Take == Count))
+            {
+                // NOTE(agent): The whole block is in this span, so it can be summed right where it is
+                Values = Span->Values + Offset;
+            }
+            else
+            {
+                memcpy(Gathered + GatheredCount, Span->Values + Offset, Take*sizeof(f64));
+                Values = Gathered;
+            }
+            
+            GatheredCount += Take;
+            Offset += Take;
+        }
+        
+        Job->BlockSums[Block] = SumBlock(Values, Count);
+    }
+}
+
+static THREAD_PROC(SumThreadProc)
+{
+    sum_thread *Thread = (sum_thread *)Param;
+    SumBlocks(Thread->Job, Thread->ThreadIndex);
+    return 0;
+}
+
+static b32 DeterministicSumSpans(arena *Arena, sum_span *Spans, u32 SpanCount, u32 ThreadCount, f64 *Sum)
+{
+    /* NOTE(agent): Sums the values of every span, in order, as if they were one array. Spans can be any length,
+       including 0. Returns false (and prints an error) only if it couldn't get the memory it needs for the block
+       sums. */
+    sum_job Job = {};
+    Job.Spans = Spans;
+    Job.SpanCount = SpanCount;
+    
+    u64 TotalCount = 0;
+    for(u32 SpanIndex = 0; SpanIndex < SpanCount; ++SpanIndex)
+    {
+        TotalCount += Spans[SpanIndex].Count;
+    }
+    
+    Job.TotalCount = TotalCount;
+    Job.BlockCount = (TotalCount + SUM_BLOCK_COUNT - 1) / SUM_BLOCK_COUNT;
+    if(Job.BlockCount == 0)
+    {
+        *Sum = 0;
+        return true;
+    }
+    
+    temp_arena Temp = BeginTemp(Arena);
+    Job.BlockSums = PushArray(Arena, Job.BlockCount, sum_part);
+    Job.SpanStarts = PushArray(Arena, SpanCount, u64);
+    if(!Job.BlockSums || !Job.SpanStarts)
+    {
+        fprintf(stderr, "ERROR: Unable to allocate space to sum %llu values.\n", TotalCount);
+        EndTemp(Temp);
+        return false;
+    }
+    
+    u64 SpanStart = 0;
+    for(u32 SpanIndex = 0; SpanIndex < SpanCount; ++SpanIndex)
+    {
+        Job.SpanStarts[SpanIndex] = SpanStart;
+        SpanStart += Spans[SpanIndex].Count;
+    }
+    
+    if(ThreadCount < 1)
+    {
+        ThreadCount = 1;
+    }
+    if(ThreadCount > SUM_MAX_THREADS)
+    {
+        ThreadCount = SUM_MAX_THREADS;
+    }
+    if(ThreadCount > Job.BlockCount)
+    {
+        ThreadCount = (u32)Job.BlockCount;
+    }
+    Job.ThreadCount = ThreadCount;
+    
+    // NOTE(agent): The calling thread does the first share of the blocks itself, and any share whose thread
+    // couldn't be started
+    os_thread Threads[SUM_MAX_THREADS];
+    sum_thread Params[SUM_MAX_THREADS];
+    b32 Started[SUM_MAX_THREADS] = {};
+    for(u32 ThreadIndex = 1; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        Params[ThreadIndex].Job = &Job;
+        Params[ThreadIndex].ThreadIndex = ThreadIndex;
+        Started[ThreadIndex] = StartThread(&Threads[ThreadIndex], SumThreadProc, &Params[ThreadIndex]);
+    }
+    
+    SumBlocks(&Job, 0);
+    
+    for(u32 ThreadIndex = 1; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        if(Started[ThreadIndex])
+        {
+            JoinThread(Threads[ThreadIndex]);
+        }
+        else
+        {
+            SumBlocks(&Job, ThreadIndex);
+        }
+    }
+    
+    sum_part *Parts = Job.BlockSums;
+    for(u64 Width = Job.BlockCount; Width > 1; Width = (Width + 1)/2)
+    {
+        for(u64 Index = 0; Index < Width/2; ++Index)
+        {
+            Parts[Index] = AddSumParts(Parts[2*Index], Parts[2*Index + 1]);
+        }
+        
+        if(Width & 1)
+        {
+            Parts[Width/2] = Parts[Width - 1];
+        }
+    }
+    
+    *Sum = Parts[0].Value + Parts[0].Error;
+    
+    EndTemp(Temp);
+    
+    return true;
+}
+
+static b32 DeterministicSum(arena *Arena, f64 *Values, u64 Count, u32 ThreadCount, f64 *Sum)
+{
+    sum_span Span = {Values, Count};
+    b32 Result = DeterministicSumSpans(Arena, &Span, 1, ThreadCount, Sum);
+    return Result;
+}
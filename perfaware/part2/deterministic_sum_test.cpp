@@ -0,0 +1,313 @@
+/* NOTE(agent): Checks that deterministic_sum.cpp gives bit-for-bit the same sum with 1, 2, 7, and 64 threads, and
+   with the values cut into spans several different ways, then times it.
+   
+   Usage: deterministic_sum_test [-count values] [-seconds count]
+   
+   There are two sets of values: "distances", which are all positive and spread over many orders of magnitude like
+   very short and very long haversine distances, and "cancelling", which has big values of both signs that mostly
+   cancel out, which is the hardest case for any summation. The spans are:
+   
+   whole:  One span with every value in it.
+   blocks: Spans exactly SUM_BLOCK_COUNT long, so no block crosses from one span into another.
+   random: Spans of random lengths from 0 to 3*SUM_BLOCK_COUNT, so most blocks do.
+   tiny:   Spans of 0 to 7 values, so every block is gathered from hundreds of them.
+   
+   Every combination has to match the first one (whole, 1 thread) exactly, or it is reported as an error and the
+   program returns 1. The error column is how far off that sum is from a reference computed in double-double
+   arithmetic, next to how far off a plain running sum is.
+   
+   The timing table is the whole span, in GB/s of values read, next to a plain running sum and a plain sum in
+   4 SSE2 lanes. The plain 4-lane sum is about as fast as reading the values can be, so it is the bandwidth the
+   deterministic sum is being compared to. Note that with more threads than processors, the threads just take
+   turns. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "random_series.cpp"
+#include "os_memory.cpp"
+#include "arena.cpp"
+#include "os_thread.cpp"
+#include "deterministic_sum.cpp"
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+enum span_layout
+{
+    SpanLayout_Whole,
+    SpanLayout_Blocks,
+    SpanLayout_Random,
+    SpanLayout_Tiny,
+    
+    SpanLayout_Count,
+};
+
+static char const *SpanLayoutNames[SpanLayout_Count] =
+{
+    "whole",
+    "blocks",
+    "random",
+    "tiny",
+};
+
+static u32 const TestThreadCounts[] = {1, 2, 7, 64};
+
+static void GenerateValues(f64 *Values, u64 Count, b32 Cancelling)
+{
+    random_series Series = Seed(Cancelling ? 2 : 1);
+    for(u64 Index = 0; Index < Count; ++Index)
+    {
+        f64 Value = RandomInRange(&Series, 0.0, 20000.0)*pow(10.0, -(f64)(RandomU64(&Series) % 12));
+        if(Cancelling)
+        {
+            // NOTE(agent): Every other value nearly cancels the one before it
+            Value = (Index & 1) ? -(Values[Index - 1]*(1.0 - 1e-9*Value)) : 1e12*Value;
+        }
+        
+        Values[Index] = Value;
+    }
+}
+
+static u32 MakeSpans(span_layout Layout, f64 *Values, u64 Count, sum_span *Spans)
+{
+    /* NOTE(agent): Spans must have room for Count + 1 spans. Zero-length spans are left in on purpose. */
+    random_series Series = Seed(Layout);
+    
+    u32 SpanCount = 0;
+    u64 Offset = 0;
+    while(Offset < Count)
+    {
+        u64 Length = Count;
+        switch(Layout)
+        {
+            case SpanLayout_Whole: {} break;
+            case SpanLayout_Blocks: {Length = SUM_BLOCK_COUNT;} break;
+            case SpanLayout_Random: {Length = RandomU64(&Series) % (3*SUM_BLOCK_COUNT + 1);} break;
+            case SpanLayout_Tiny: {Length = RandomU64(&Series) % 8;} break;
+            default: {} break;
+        }
+        
+        if(Length > (Count - Offset))
+        {
+            Length = Count - Offset;
+        }
+        
+        Spans[SpanCount].Values = Values + Offset;
+        Spans[SpanCount].Count = Length;
+        ++SpanCount;
+        
+        Offset += Length;
+    }
+    
+    return SpanCount;
+}
+
+static f64 SumDoubleDouble(f64 *Values, u64 Count)
+{
+    // NOTE(agent): The reference - every add is a TwoSum, with the lost parts kept alongside, one at a time
+    sum_part Sum = {};
+    for(u64 Index = 0; Index < Count; ++Index)
+    {
+        sum_part Value = {Values[Index], 0};
+        sum_part Next = AddSumParts(Sum, Value);
+        
+        // NOTE(agent): Renormalize, so Error never grows big enough to lose bits of its own
+        Sum.Value = Next.Value + Next.Error;
+        Sum.Error = Next.Error - (Sum.Value - Next.Value);
+    }
+    
+    f64 Result = Sum.Value + Sum.Error;
+    return Result;
+}
+
+static f64 SumPlain(f64 *Values, u64 Count)
+{
+    f64 Result = 0;
+    for(u64 Index = 0; Index < Count; ++Index)
+    {
+        Result += Values[Index];
+    }
+    
+    return Result;
+}
+
+static f64 SumPlainLanes(f64 *Values, u64 Count)
+{
+    __m128d Sum0 = _mm_setzero_pd(), Sum1 = _mm_setzero_pd(), Sum2 = _mm_setzero_pd(), Sum3 = _mm_setzero_pd();
+    
+    u64 Index = 0;
+    for(; (Index + 8) <= Count; Index += 8)
+    {
+        Sum0 = _mm_add_pd(Sum0, _mm_loadu_pd(Values + Index + 0));
+        Sum1 = _mm_add_pd(Sum1, _mm_loadu_pd(Values + Index + 2));
+        Sum2 = _mm_add_pd(Sum2, _mm_loadu_pd(Values + Index + 4));
+        Sum3 = _mm_add_pd(Sum3, _mm_loadu_pd(Values + Index + 6));
+    }
+    
+    f64 Lanes[2];
+    _mm_storeu_pd(Lanes, _mm_add_pd(_mm_add_pd(Sum0, Sum1), _mm_add_pd(Sum2, Sum3)));
+    
+    f64 Result = Lanes[0] + Lanes[1];
+    for(; Index < Count; ++Index)
+    {
+        Result += Values[Index];
+    }
+    
+    return Result;
+}
+
+static f64 RelativeError(f64 Value, f64 Reference)
+{
+    f64 Result = (Reference != 0) ? fabs((Value - Reference) / Reference) : fabs(Value);
+    return Result;
+}
+
+static void PrintTiming(char const *Name, u32 ThreadCount, repetition_tester *Tester, u64 ByteCount, f64 Sum)
+{
+    f64 Seconds = SecondsFromCPUTime((f64)Tester->Results.Min.E[RepValue_CPUTimer], Tester->CPUTimerFreq);
+    f64 Gigabyte = 1024.0*1024.0*1024.0;
+    fprintf(stdout, "%-14s %8u %10.3f %8.3f %26.17g\n", Name, ThreadCount, 1000.0*Seconds, ((f64)ByteCount / Gigabyte) / Seconds,
+            Sum);
+}
+
+int main(int ArgCount, char **Args)
+{
+    u64 Count = 10000019;
+    u32 SecondsToTry = 3;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-count") == 0))
+        {
+            Count = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else
+        {
+            Count = 0;
+            break;
+        }
+    }
+    
+    if(!Count)
+    {
+        fprintf(stderr, "USAGE: %s [-count values] [-seconds count]\n", Args[0]);
+        return 1;
+    }
+    
+    f64 *Values = (f64 *)malloc(Count*sizeof(f64));
+    sum_span *Spans = (sum_span *)malloc((Count + 1)*sizeof(sum_span));
+    if(!Values || !Spans)
+    {
+        fprintf(stderr, "ERROR: Unable to allocate space for %llu values.\n", Count);
+        return 1;
+    }
+    
+    arena Arena = {};
+    int Result = 0;
+    
+    fprintf(stdout, "Values: %llu\n", Count);
+    for(u32 Cancelling = 0; Cancelling < 2; ++Cancelling)
+    {
+        GenerateValues(Values, Count, Cancelling);
+        f64 Reference = SumDoubleDouble(Values, Count);
+        
+        fprintf(stdout, "\n%s: reference %.17g, plain sum error %.3e\n", Cancelling ? "cancelling" : "distances",
+                Reference, RelativeError(SumPlain(Values, Count), Reference));
+        fprintf(stdout, "%-8s %8s %8s %26s %10s\n", "Spans", "Count", "Threads", "Sum", "Error");
+        
+        b32 HaveFirst = false;
+        f64 First = 0;
+        for(u32 Layout = 0; Layout < SpanLayout_Count; ++Layout)
+        {
+            u32 SpanCount = MakeSpans((span_layout)Layout, Values, Count, Spans);
+            for(u32 TestIndex = 0; TestIndex < ArrayCount(TestThreadCounts); ++TestIndex)
+            {
+                u32 ThreadCount = TestThreadCounts[TestIndex];
+                
+                f64 Sum = 0;
+                if(!DeterministicSumSpans(&Arena, Spans, SpanCount, ThreadCount, &Sum))
+                {
+                    return 1;
+                }
+                
+                if(!HaveFirst)
+                {
+                    First = Sum;
+                    HaveFirst = true;
+                }
+                
+                b32 Matches = (memcmp(&Sum, &First, sizeof(f64)) == 0);
+                fprintf(stdout, "%-8s %8u %8u %26.17g %10.3e%s\n", SpanLayoutNames[Layout], SpanCount, ThreadCount,
+                        Sum, RelativeError(Sum, Reference), Matches ? "" : " MISMATCH");
+                if(!Matches)
+                {
+                    fprintf(stderr, "ERROR: %s spans with %u threads gave %.17g, but whole with 1 thread gave %.17g.\n",
+                            SpanLayoutNames[Layout], ThreadCount, Sum, First);
+                    Result = 1;
+                }
+            }
+        }
+    }
+    
+    if(SecondsToTry)
+    {
+        u64 ByteCount = Count*sizeof(f64);
+        u64 CPUTimerFreq = GetCPUTimerFreq();
+        
+        // NOTE(agent): The sum from the last run is printed with each timing, so that the compiler can't decide the
+        // sums aren't needed
+        fprintf(stdout, "\n%-14s %8s %10s %8s %26s\n", "Sum", "Threads", "ms", "GB/s", "Result");
+        
+        for(u32 Plain = 0; Plain < 2; ++Plain)
+        {
+            f64 Sum = 0;
+            repetition_tester Tester = {};
+            NewTestWave(&Tester, ByteCount, CPUTimerFreq, SecondsToTry);
+            Tester.PrintNewMinimums = false;
+            while(IsTesting(&Tester))
+            {
+                BeginTime(&Tester);
+                Sum = Plain ? SumPlainLanes(Values, Count) : SumPlain(Values, Count);
+                EndTime(&Tester);
+                CountBytes(&Tester, ByteCount);
+            }
+            PrintTiming(Plain ? "plain 4-lane" : "plain", 1, &Tester, ByteCount, Sum);
+        }
+        
+        for(u32 TestIndex = 0; TestIndex < ArrayCount(TestThreadCounts); ++TestIndex)
+        {
+            u32 ThreadCount = TestThreadCounts[TestIndex];
+            
+            f64 Sum = 0;
+            repetition_tester Tester = {};
+            NewTestWave(&Tester, ByteCount, CPUTimerFreq, SecondsToTry);
+            Tester.PrintNewMinimums = false;
+            while(IsTesting(&Tester))
+            {
+                BeginTime(&Tester);
+                DeterministicSum(&Arena, Values, Count, ThreadCount, &Sum);
+                EndTime(&Tester);
+                CountBytes(&Tester, ByteCount);
+            }
+            PrintTiming("deterministic", ThreadCount, &Tester, ByteCount, Sum);
+        }
+    }
+    
+    FreeArena(&Arena);
+    free(Spans);
+    free(Values);
+    
+    return Result;
+}
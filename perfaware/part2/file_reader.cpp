@@ -0,0 +1,863 @@
+/* NOTE(agent): Reads a file front to back in fixed-size blocks, through one of several backends, so that the
+   same consumer code can be timed against each of them:
+   
+   read:     One read() (ReadFile on Windows) per block, into the reader's own block buffers.
+   mmap:     The whole file is mapped, and each block is just a pointer into the mapping. Nothing is copied, but
+             every page of it faults the first time the consumer touches it.
+   io_uring: (Linux only) Up to QueueDepth reads are kept in flight at once, each one into its own block buffer,
+             so the disk (or the page cache copy) is working on the next blocks while the consumer is on this one.
+   
+   Blocks always come out in file order, whatever order the reads finish in. The block's Data points straight at
+   the buffer the read went into, so nothing is copied on the way to the consumer. Each block stays valid until
+   it is given back with ReleaseFileBlock, and blocks have to be released in the order they were handed out.
+   The consumer can hold at most QueueDepth blocks at once - io_uring reuses a block's buffer for a new read as
+   soon as it is released.
+   
+   FileReaderFlag_Direct opens the file with O_DIRECT (FILE_FLAG_NO_BUFFERING on Windows) for the read and
+   io_uring backends, which skips the page cache entirely. That needs the buffers, the offsets and the read sizes
+   to be aligned, which is why the buffers come from the OS's page allocator and BlockSize is always rounded up
+   to FILE_READER_ALIGNMENT (it is also capped at FILE_READER_MAX_BLOCK_SIZE). Not every file system supports it,
+   in which case opening the file fails.
+   
+   FileReaderFlag_Populate makes the mmap backend map every page of the file up front (MAP_POPULATE, or
+   PrefetchVirtualMemory on Windows), instead of faulting them in as the consumer gets to them.
+   
+   usage:
+   
+   file_reader Reader = {};
+   if(OpenFileReader(&Reader, FileName, FileRead_IOUring))
+   {
+       file_block Block;
+       while(NextFileBlock(&Reader, &Block))
+       {
+           // ... use Block.Data[0] through Block.Data[Block.Count - 1] ...
+           ReleaseFileBlock(&Reader, &Block);
+       }
+       
+       b32 Succeeded = !Reader.Failed;
+       CloseFileReader(&Reader);
+   }
+   
+   EvictFileFromCache asks the OS to drop the file from its page cache, so the next read of it has to come from
+   the disk. It only works on Linux. */
+
+#if _WIN32
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#endif
+
+#define FILE_READER_BLOCK_SIZE (1024*1024)
+#define FILE_READER_QUEUE_DEPTH 8
+#define FILE_READER_MAX_QUEUE_DEPTH 64
+
+// NOTE(agent): An io_uring read only takes a 32-bit length, so blocks are capped well below 4GB
+#define FILE_READER_MAX_BLOCK_SIZE (1024ULL*1024*1024)
+
+// NOTE(agent): Larger than any disk sector size in use, and a whole page
+#define FILE_READER_ALIGNMENT 4096
+
+enum file_read_backend
+{
+    FileRead_Read,
+    FileRead_MMap,
+    FileRead_IOUring,
+    
+    FileRead_Count,
+};
+
+enum file_reader_flags
+{
+    FileReaderFlag_Direct = 0x1,
+    FileReaderFlag_Populate = 0x2,
+};
+
+enum file_slot_state
+{
+    FileSlot_Free,
+    FileSlot_Reading,
+    FileSlot_Ready,
+    FileSlot_Held,
+};
+
+struct file_slot
+{
+    file_slot_state State;
+    u64 Offset;
+    u64 Count;
+};
+
+struct file_block
+{
+    u64 Offset;
+    u64 Count;
+    u8 *Data;
+};
+
+#if !_WIN32
+struct io_uring_queue
+{
+    int RingFD;
+    
+    u32 *SQTail;
+    u32 SQMask;
+    u32 *SQArray;
+    io_uring_sqe *SQEs;
+    
+    u32 *CQHead;
+    u32 *CQTail;
+    u32 CQMask;
+    io_uring_cqe *CQEs;
+    
+    void *SQRing;
+    u64 SQRingSize;
+    void *CQRing;
+    u64 CQRingSize;
+    u64 SQESize;
+};
+#endif
+
+struct file_reader
+{
+    file_read_backend Backend;
+    u32 Flags;
+    u64 FileSize;
+    u64 BlockSize;
+    u32 QueueDepth;
+    
+    u64 NextReadOffset;
+    u64 NextBlockOffset;
+    b32 Failed;
+    
+    // NOTE(agent): The block buffers (QueueDepth*BlockSize bytes), or for mmap, the mapped file
+    u8 *Memory;
+    u64 MemorySize;
+    
+    file_slot Slots[FILE_READER_MAX_QUEUE_DEPTH];
+
+#if _WIN32
+    HANDLE File;
+    HANDLE Mapping;
+#else
+    int File;
+    io_uring_queue Ring;
+#endif
+};
+
+static u64 AlignFileReaderSize(u64 Size)
+{
+    u64 Result = (Size + FILE_READER_ALIGNMENT - 1) & ~(u64)(FILE_READER_ALIGNMENT - 1);
+    return Result;
+}
+
+static file_slot *GetSlotFor(file_reader *Reader, u64 Offset)
+{
+    // NOTE(agent): Block N always reads into slot N % QueueDepth, which is what keeps the blocks in file order
+    u64 BlockIndex = Offset / Reader->BlockSize;
+    file_slot *Result = Reader->Slots + (BlockIndex % Reader->QueueDepth);
+    return Result;
+}
+
+static u8 *GetSlotMemory(file_reader *Reader, file_slot *Slot)
+{
+    u8 *Result = Reader->Memory + (Slot - Reader->Slots)*Reader->BlockSize;
+    return Result;
+}
+
+#if _WIN32
+
+static b32 OpenFileForReader(file_reader *Reader, char *FileName)
+{
+    DWORD Flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN;
+    if(Reader->Flags & FileReaderFlag_Direct)
+    {
+        Flags |= FILE_FLAG_NO_BUFFERING;
+    }
+    
+    Reader->File = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, Flags, 0);
+    
+    LARGE_INTEGER Size = {};
+    b32 Result = ((Reader->File != INVALID_HANDLE_VALUE) && GetFileSizeEx(Reader->File, &Size));
+    if(Result)
+    {
+        Reader->FileSize = Size.QuadPart;
+    }
+    
+    return Result;
+}
+
+static void CloseFileForReader(file_reader *Reader)
+{
+    if(Reader->Mapping)
+    {
+        CloseHandle(Reader->Mapping);
+    }
+    
+    if(Reader->File != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(Reader->File);
+    }
+}
+
+static u8 *AllocateReaderMemory(u64 Size)
+{
+    u8 *Result = (u8 *)VirtualAlloc(0, Size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    return Result;
+}
+
+static void FreeReaderMemory(u8 *Memory, u64 Size)
+{
+    VirtualFree(Memory, 0, MEM_RELEASE);
+}
+
+static u8 *MapFileForReader(file_reader *Reader)
+{
+    u8 *Result = 0;
+    
+    Reader->Mapping = CreateFileMappingA(Reader->File, 0, PAGE_READONLY, 0, 0, 0);
+    if(Reader->Mapping)
+    {
+        Result = (u8 *)MapViewOfFile(Reader->Mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    
+    if(Result && (Reader->Flags & FileReaderFlag_Populate))
+    {
+        WIN32_MEMORY_RANGE_ENTRY Range = {Result, Reader->FileSize};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &Range, 0);
+    }
+    
+    return Result;
+}
+
+static void UnmapFileForReader(u8 *Memory, u64 Size)
+{
+    UnmapViewOfFile(Memory);
+}
+
+static u64 ReadIntoSlot(file_reader *Reader, u8 *Dest, u64 Size)
+{
+    // NOTE(agent): ReadFile can't do more than 4GB at once, and can stop short of what was asked for
+    u64 Result = 0;
+    while(Result < Size)
+    {
+        u64 ChunkSize = Size - Result;
+        if(ChunkSize > 0x80000000)
+        {
+            ChunkSize = 0x80000000;
+        }
+        
+        DWORD BytesRead = 0;
+        if(!ReadFile(Reader->File, Dest + Result, (DWORD)ChunkSize, &BytesRead, 0))
+        {
+            fprintf(stderr, "ERROR: Unable to read from the file (error %lu).\n", GetLastError());
+            Reader->Failed = true;
+            break;
+        }
+        
+        if(BytesRead == 0)
+        {
+            break;
+        }
+        
+        Result += BytesRead;
+    }
+    
+    return Result;
+}
+
+static b32 EvictFileFromCache(char *FileName)
+{
+    // NOTE(agent): There's no call for this on Windows that works without administrator rights
+    return false;
+}
+
+#else
+
+static b32 OpenFileForReader(file_reader *Reader, char *FileName)
+{
+    int Flags = O_RDONLY;
+    if(Reader->Flags & FileReaderFlag_Direct)
+    {
+        Flags |= O_DIRECT;
+    }
+    
+    Reader->File = open(FileName, Flags);
+    
+    struct stat Stat;
+    b32 Result = ((Reader->File >= 0) && (fstat(Reader->File, &Stat) == 0));
+    if(Result)
+    {
+        Reader->FileSize = Stat.st_size;
+        if(!(Reader->Flags & FileReaderFlag_Direct))
+        {
+            posix_fadvise(Reader->File, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+    }
+    
+    return Result;
+}
+
+static void CloseFileForReader(file_reader *Reader)
+{
+    if(Reader->File >= 0)
+    {
+        close(Reader->File);
+    }
+}
+
+static u8 *AllocateReaderMemory(u64 Size)
+{
+    // NOTE(agent): Every byte of the block buffers is about to be written anyway, so they are faulted in up
+    // front, rather than one page at a time in the middle of the reads
+    u8 *Result = (u8 *)mmap(0, Size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_POPULATE, -1, 0);
+    if(Result == MAP_FAILED)
+    {
+        Result = 0;
+    }
+    
+    return Result;
+}
+
+static void FreeReaderMemory(u8 *Memory, u64 Size)
+{
+    munmap(Memory, Size);
+}
+
+static u8 *MapFileForReader(file_reader *Reader)
+{
+    int Flags = MAP_PRIVATE;
+    if(Reader->Flags & FileReaderFlag_Populate)
+    {
+        Flags |= MAP_POPULATE;
+    }
+    
+    u8 *Result = (u8 *)mmap(0, Reader->FileSize, PROT_READ, Flags, Reader->File, 0);
+    if(Result == MAP_FAILED)
+    {
+        Result = 0;
+    }
+    else
+    {
+        madvise(Result, Reader->FileSize, MADV_SEQUENTIAL);
+    }
+    
+    return Result;
+}
+
+static void UnmapFileForReader(u8 *Memory, u64 Size)
+{
+    munmap(Memory, Size);
+}
+
+static u64 ReadIntoSlot(file_reader *Reader, u8 *Dest, u64 Size)
+{
+    // NOTE(agent): read() can stop short of what was asked for, and can be interrupted before reading anything
+    u64 Result = 0;
+    while(Result < Size)
+    {
+        ssize_t BytesRead = read(Reader->File, Dest + Result, Size - Result);
+        if(BytesRead < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            
+            fprintf(stderr, "ERROR: Unable to read from the file (%s).\n", strerror(errno));
+            Reader->Failed = true;
+            break;
+        }
+        
+        if(BytesRead == 0)
+        {
+            break;
+        }
+        
+        Result += BytesRead;
+    }
+    
+    return Result;
+}
+
+static b32 EvictFileFromCache(char *FileName)
+{
+    // NOTE(agent): Only drops pages that aren't dirty and aren't mapped by anyone, which is every page of an
+    // input file that nobody has open
+    b32 Result = false;
+    
+    int File = open(FileName, O_RDONLY);
+    if(File >= 0)
+    {
+        Result = (posix_fadvise(File, 0, 0, POSIX_FADV_DONTNEED) == 0);
+        close(File);
+    }
+    
+    return Result;
+}
+
+static int IOUringSetup(u32 Entries, io_uring_params *Params)
+{
+    int Result = (int)syscall(__NR_io_uring_setup, Entries, Params);
+    return Result;
+}
+
+static int IOUringEnter(int RingFD, u32 SubmitCount, u32 MinComplete, u32 Flags)
+{
+    int Result = (int)syscall(__NR_io_uring_enter, RingFD, SubmitCount, MinComplete, Flags, 0, 0);
+    return Result;
+}
+
+static void CloseIOUring(io_uring_queue *Ring)
+{
+    if(Ring->SQEs)
+    {
+        munmap(Ring->SQEs, Ring->SQESize);
+    }
+    
+    if(Ring->CQRing && (Ring->CQRing != Ring->SQRing))
+    {
+        munmap(Ring->CQRing, Ring->CQRingSize);
+    }
+    
+    if(Ring->SQRing)
+    {
+        munmap(Ring->SQRing, Ring->SQRingSize);
+    }
+    
+    if(Ring->RingFD >= 0)
+    {
+        close(Ring->RingFD);
+    }
+    
+    *Ring = {};
+    Ring->RingFD = -1;
+}
+
+static b32 OpenIOUring(io_uring_queue *Ring, u32 Entries)
+{
+    /* NOTE(agent): This is the setup liburing would do. The kernel makes a submission ring (an array of
+       indices into the SQEs), and a completion ring of CQEs, and each one gets mapped into this process.
+       Newer kernels map both rings with a single mmap. */
+    
+    *Ring = {};
+    
+    io_uring_params Params = {};
+    Ring->RingFD = IOUringSetup(Entries, &Params);
+    if(Ring->RingFD < 0)
+    {
+        return false;
+    }
+    
+    Ring->SQRingSize = Params.sq_off.array + Params.sq_entries*sizeof(u32);
+    Ring->CQRingSize = Params.cq_off.cqes + Params.cq_entries*sizeof(io_uring_cqe);
+    if(Params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if(Ring->SQRingSize < Ring->CQRingSize)
+        {
+            Ring->SQRingSize = Ring->CQRingSize;
+        }
+        Ring->CQRingSize = Ring->SQRingSize;
+    }
+    
+    Ring->SQRing = mmap(0, Ring->SQRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, Ring->RingFD, IORING_OFF_SQ_RING);
+    if(Ring->SQRing == MAP_FAILED)
+    {
+        Ring->SQRing = 0;
+        CloseIOUring(Ring);
+        return false;
+    }
+    
+    if(Params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        Ring->CQRing = Ring->SQRing;
+    }
+    else
+    {
+        Ring->CQRing = mmap(0, Ring->CQRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, Ring->RingFD, IORING_OFF_CQ_RING);
+        if(Ring->CQRing == MAP_FAILED)
+        {
+            Ring->CQRing = 0;
+            CloseIOUring(Ring);
+            return false;
+        }
+    }
+    
+    Ring->SQESize = Params.sq_entries*sizeof(io_uring_sqe);
+    Ring->SQEs = (io_uring_sqe *)mmap(0, Ring->SQESize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, Ring->RingFD, IORING_OFF_SQES);
+    if(Ring->SQEs == MAP_FAILED)
+    {
+        Ring->SQEs = 0;
+        CloseIOUring(Ring);
+        return false;
+    }
+    
+    u8 *SQ = (u8 *)Ring->SQRing;
+    Ring->SQTail = (u32 *)(SQ + Params.sq_off.tail);
+    Ring->SQMask = *(u32 *)(SQ + Params.sq_off.ring_mask);
+    Ring->SQArray = (u32 *)(SQ + Params.sq_off.array);
+    
+    u8 *CQ = (u8 *)Ring->CQRing;
+    Ring->CQHead = (u32 *)(CQ + Params.cq_off.head);
+    Ring->CQTail = (u32 *)(CQ + Params.cq_off.tail);
+    Ring->CQMask = *(u32 *)(CQ + Params.cq_off.ring_mask);
+    Ring->CQEs = (io_uring_cqe *)(CQ + Params.cq_off.cqes);
+    
+    return true;
+}
+
+static void SubmitSlotRead(file_reader *Reader, file_slot *Slot)
+{
+    io_uring_queue *Ring = &Reader->Ring;
+    
+    Slot->State = FileSlot_Reading;
+    Slot->Offset = Reader->NextReadOffset;
+    Slot->Count = 0;
+    Reader->NextReadOffset += Reader->BlockSize;
+    
+    // NOTE(agent): This thread is the only one that writes the submission tail, so it can be read plainly, but
+    // the SQE has to be written before the kernel can see the new tail
+    u32 Tail = *Ring->SQTail;
+    u32 Index = Tail & Ring->SQMask;
+    
+    io_uring_sqe *SQE = Ring->SQEs + Index;
+    memset(SQE, 0, sizeof(*SQE));
+    SQE->opcode = IORING_OP_READ;
+    SQE->fd = Reader->File;
+    SQE->addr = (u64)GetSlotMemory(Reader, Slot);
+    SQE->len = (u32)Reader->BlockSize;
+    SQE->off = Slot->Offset;
+    SQE->user_data = (u64)(Slot - Reader->Slots);
+    
+    Ring->SQArray[Index] = Index;
+    __atomic_store_n(Ring->SQTail, Tail + 1, __ATOMIC_RELEASE);
+    
+    int Submitted;
+    do
+    {
+        Submitted = IOUringEnter(Ring->RingFD, 1, 0, 0);
+    } while((Submitted < 0) && (errno == EINTR));
+    
+    if(Submitted != 1)
+    {
+        // NOTE(agent): The kernel never took the SQE, so it is taken back out of the ring, and the slot goes back to
+        // free - otherwise CloseFileReader would wait forever for a read that was never started
+        fprintf(stderr, "ERROR: Unable to submit a read to io_uring (%s).\n",
+                (Submitted < 0) ? strerror(errno) : "not accepted");
+        __atomic_store_n(Ring->SQTail, Tail, __ATOMIC_RELEASE);
+        Reader->NextReadOffset = Slot->Offset;
+        Slot->State = FileSlot_Free;
+        Reader->Failed = true;
+    }
+}
+
+static void CompleteSlotRead(file_reader *Reader, file_slot *Slot, s32 ReadResult)
+{
+    if(ReadResult < 0)
+    {
+        fprintf(stderr, "ERROR: Unable to read from the file (%s).\n", strerror(-ReadResult));
+        Reader->Failed = true;
+        ReadResult = 0;
+    }
+    
+    u64 Wanted = Reader->FileSize - Slot->Offset;
+    if(Wanted > Reader->BlockSize)
+    {
+        Wanted = Reader->BlockSize;
+    }
+    
+    Slot->Count = ReadResult;
+    if(Slot->Count < Wanted)
+    {
+        // NOTE(agent): A short read that isn't at the end of the file is rare (a signal, or a file system that
+        // splits large reads), so the rest of it is just read synchronously rather than going through the ring
+        while(!Reader->Failed && (Slot->Count < Wanted))
+        {
+            ssize_t BytesRead = pread(Reader->File, GetSlotMemory(Reader, Slot) + Slot->Count,
+                                      Reader->BlockSize - Slot->Count, Slot->Offset + Slot->Count);
+            if((BytesRead < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            
+            if(BytesRead <= 0)
+            {
+                fprintf(stderr, "ERROR: Unable to read from the file (%s).\n", (BytesRead < 0) ? strerror(errno) : "unexpected end of file");
+                Reader->Failed = true;
+                break;
+            }
+            
+            Slot->Count += BytesRead;
+        }
+    }
+    
+    if(Slot->Count > Wanted)
+    {
+        Slot->Count = Wanted;
+    }
+    
+    Slot->State = FileSlot_Ready;
+}
+
+static void WaitForSlotRead(file_reader *Reader, file_slot *Slot)
+{
+    io_uring_queue *Ring = &Reader->Ring;
+    
+    while(!Reader->Failed && (Slot->State == FileSlot_Reading))
+    {
+        u32 Head = *Ring->CQHead;
+        u32 Tail = __atomic_load_n(Ring->CQTail, __ATOMIC_ACQUIRE);
+        if(Head != Tail)
+        {
+            io_uring_cqe *CQE = Ring->CQEs + (Head & Ring->CQMask);
+            file_slot *Completed = Reader->Slots + CQE->user_data;
+            s32 ReadResult = CQE->res;
+            __atomic_store_n(Ring->CQHead, Head + 1, __ATOMIC_RELEASE);
+            
+            CompleteSlotRead(Reader, Completed, ReadResult);
+        }
+        else if((IOUringEnter(Ring->RingFD, 0, 1, IORING_ENTER_GETEVENTS) < 0) && (errno != EINTR))
+        {
+            fprintf(stderr, "ERROR: Unable to wait on io_uring (%s).\n", strerror(errno));
+            Reader->Failed = true;
+        }
+    }
+}
+
+#endif
+
+static void CloseFileReader(file_reader *Reader)
+{
+#if !_WIN32
+    if(Reader->Backend == FileRead_IOUring)
+    {
+        // NOTE(agent): The kernel could still be writing into the block buffers, so they can't be freed until
+        // every read that was submitted has finished
+        for(u32 SlotIndex = 0; SlotIndex < Reader->QueueDepth; ++SlotIndex)
+        {
+            b32 Failed = Reader->Failed;
+            Reader->Failed = false;
+            WaitForSlotRead(Reader, Reader->Slots + SlotIndex);
+            Reader->Failed |= Failed;
+        }
+        
+        CloseIOUring(&Reader->Ring);
+    }
+#endif
+
+    if(Reader->Memory)
+    {
+        if(Reader->Backend == FileRead_MMap)
+        {
+            UnmapFileForReader(Reader->Memory, Reader->MemorySize);
+        }
+        else
+        {
+            FreeReaderMemory(Reader->Memory, Reader->MemorySize);
+        }
+    }
+    
+    CloseFileForReader(Reader);
+    
+    Reader->Memory = 0;
+    Reader->MemorySize = 0;
+}
+
+static b32 OpenFileReader(file_reader *Reader, char *FileName, file_read_backend Backend, u32 Flags = 0,
+                          u64 BlockSize = FILE_READER_BLOCK_SIZE, u32 QueueDepth = FILE_READER_QUEUE_DEPTH)
+{
+    *Reader = {};
+#if _WIN32
+    Reader->File = INVALID_HANDLE_VALUE;
+#else
+    Reader->File = -1;
+    Reader->Ring.RingFD = -1;
+#endif
+
+    Reader->Backend = Backend;
+    Reader->Flags = Flags;
+    Reader->BlockSize = AlignFileReaderSize(BlockSize ? BlockSize : 1);
+    if(Reader->BlockSize > FILE_READER_MAX_BLOCK_SIZE)
+    {
+        Reader->BlockSize = FILE_READER_MAX_BLOCK_SIZE;
+    }
+    Reader->QueueDepth = QueueDepth;
+    if(Reader->QueueDepth < 1)
+    {
+        Reader->QueueDepth = 1;
+    }
+    if(Reader->QueueDepth > FILE_READER_MAX_QUEUE_DEPTH)
+    {
+        Reader->QueueDepth = FILE_READER_MAX_QUEUE_DEPTH;
+    }
+
+#if _WIN32
+    if(Backend == FileRead_IOUring)
+    {
+        fprintf(stderr, "ERROR: io_uring is only available on Linux.\n");
+        return false;
+    }
+#endif
+
+    if(!OpenFileForReader(Reader, FileName))
+    {
+        fprintf(stderr, "ERROR: Unable to open \"%s\"%s.\n", FileName,
+                (Flags & FileReaderFlag_Direct) ? " for direct (unbuffered) reading" : "");
+        CloseFileReader(Reader);
+        return false;
+    }
+    
+    if(Reader->FileSize == 0)
+    {
+        // NOTE(agent): Nothing to map or read, so the reader just produces no blocks
+        return true;
+    }
+    
+    // NOTE(agent): Buffers past the end of the file would never be read into, so there's no point paying for them
+    u64 AlignedFileSize = AlignFileReaderSize(Reader->FileSize);
+    if(Reader->BlockSize > AlignedFileSize)
+    {
+        Reader->BlockSize = AlignedFileSize;
+    }
+    
+    u64 BlockCount = (Reader->FileSize + Reader->BlockSize - 1) / Reader->BlockSize;
+    if(Reader->QueueDepth > BlockCount)
+    {
+        Reader->QueueDepth = (u32)BlockCount;
+    }
+    
+    if(Backend == FileRead_MMap)
+    {
+        Reader->Memory = MapFileForReader(Reader);
+        Reader->MemorySize = Reader->FileSize;
+    }
+    else
+    {
+        Reader->MemorySize = Reader->QueueDepth*Reader->BlockSize;
+        Reader->Memory = AllocateReaderMemory(Reader->MemorySize);
+    }
+    
+    if(!Reader->Memory)
+    {
+        fprintf(stderr, "ERROR: Unable to %s \"%s\".\n",
+                (Backend == FileRead_MMap) ? "map" : "allocate block buffers for", FileName);
+        CloseFileReader(Reader);
+        return false;
+    }
+
+#if !_WIN32
+    if(Backend == FileRead_IOUring)
+    {
+        if(!OpenIOUring(&Reader->Ring, Reader->QueueDepth))
+        {
+            fprintf(stderr, "ERROR: Unable to set up io_uring (%s).\n", strerror(errno));
+            CloseFileReader(Reader);
+            return false;
+        }
+        
+        for(u32 SlotIndex = 0; (SlotIndex < Reader->QueueDepth) && (Reader->NextReadOffset < Reader->FileSize); ++SlotIndex)
+        {
+            SubmitSlotRead(Reader, Reader->Slots + SlotIndex);
+        }
+    }
+#endif
+
+    return true;
+}
+
+static b32 NextFileBlock(file_reader *Reader, file_block *Block)
+{
+    *Block = {};
+    
+    if(Reader->Failed || (Reader->NextBlockOffset >= Reader->FileSize))
+    {
+        return false;
+    }
+    
+    u64 Offset = Reader->NextBlockOffset;
+    u64 Count = Reader->FileSize - Offset;
+    if(Count > Reader->BlockSize)
+    {
+        Count = Reader->BlockSize;
+    }
+    
+    if(Reader->Backend == FileRead_MMap)
+    {
+        Block->Data = Reader->Memory + Offset;
+    }
+    else
+    {
+        file_slot *Slot = GetSlotFor(Reader, Offset);
+        if(Slot->State == FileSlot_Held)
+        {
+            fprintf(stderr, "ERROR: More than %u file blocks were held at once.\n", Reader->QueueDepth);
+            Reader->Failed = true;
+            return false;
+        }
+        
+        if(Reader->Backend == FileRead_Read)
+        {
+            // NOTE(agent): Direct reads have to ask for a whole aligned block, even at the end of the file
+            u64 ReadSize = (Reader->Flags & FileReaderFlag_Direct) ? Reader->BlockSize : Count;
+            Slot->Offset = Offset;
+            Slot->Count = ReadIntoSlot(Reader, GetSlotMemory(Reader, Slot), ReadSize);
+            if(!Reader->Failed && (Slot->Count < Count))
+            {
+                fprintf(stderr, "ERROR: The file ended early.\n");
+                Reader->Failed = true;
+            }
+        }
+#if !_WIN32
+        else
+        {
+            WaitForSlotRead(Reader, Slot);
+            if(!Reader->Failed && (Slot->State != FileSlot_Ready))
+            {
+                fprintf(stderr, "ERROR: File blocks were released out of order.\n");
+                Reader->Failed = true;
+            }
+        }
+#endif
+
+        if(Reader->Failed)
+        {
+            return false;
+        }
+        
+        Slot->State = FileSlot_Held;
+        Block->Data = GetSlotMemory(Reader, Slot);
+    }
+    
+    Block->Offset = Offset;
+    Block->Count = Count;
+    Reader->NextBlockOffset += Reader->BlockSize;
+    
+    return true;
+}
+
+static void ReleaseFileBlock(file_reader *Reader, file_block *Block)
+{
+    if(Reader->Backend != FileRead_MMap)
+    {
+        file_slot *Slot = GetSlotFor(Reader, Block->Offset);
+        Slot->State = FileSlot_Free;
+
+#if !_WIN32
+        // NOTE(agent): The block that goes into this slot next is QueueDepth blocks further on, which is
+        // exactly the next one io_uring hasn't been asked for yet
+        if((Reader->Backend == FileRead_IOUring) && !Reader->Failed && (Reader->NextReadOffset < Reader->FileSize))
+        {
+            SubmitSlotRead(Reader, Slot);
+        }
+#endif
+    }
+    
+    *Block = {};
+}
@@ -0,0 +1,225 @@
+/* NOTE(agent): Reads a file through every file_reader backend (with and without direct I/O where that applies),
+   with the file already in the OS's page cache (warm) and with it evicted before every run (cold), and reports
+   the fastest run of each in GB/s along with the page faults that run took.
+   
+   Usage: file_reader_report [-seconds count] [-block kilobytes] [-depth count] [data file]
+   
+   The consumer adds up the file as 64-bit words, so every byte really does get touched (which is what makes the
+   mmap backend pay for its page faults), and so each backend can be checked against the others: any run whose
+   sum doesn't match the first run's is reported as an error.
+   
+   Cold runs need EvictFileFromCache, which only works on Linux. Even there, a file on a virtual disk can still
+   be cached by the host, so cold numbers are only as cold as the machine underneath allows. Direct reads bypass
+   the page cache, so their warm and cold numbers should be about the same - if they're not, that is the host's
+   cache showing through. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "file_reader.cpp"
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+static char const *FileReadBackendNames[FileRead_Count] =
+{
+    "read",
+    "mmap",
+    "io_uring",
+};
+
+struct read_test
+{
+    file_read_backend Backend;
+    u32 Flags;
+};
+
+static read_test const ReadTests[] =
+{
+    {FileRead_Read, 0},
+    {FileRead_Read, FileReaderFlag_Direct},
+    {FileRead_MMap, 0},
+    {FileRead_IOUring, 0},
+    {FileRead_IOUring, FileReaderFlag_Direct},
+};
+
+static u64 SumBlock(u8 *Data, u64 Count)
+{
+    u64 Sum0 = 0;
+    u64 Sum1 = 0;
+    u64 Sum2 = 0;
+    u64 Sum3 = 0;
+    
+    u64 Index = 0;
+    for(; (Index + 32) <= Count; Index += 32)
+    {
+        u64 Words[4];
+        memcpy(Words, Data + Index, sizeof(Words));
+        Sum0 += Words[0];
+        Sum1 += Words[1];
+        Sum2 += Words[2];
+        Sum3 += Words[3];
+    }
+    
+    for(; Index < Count; ++Index)
+    {
+        Sum0 += Data[Index];
+    }
+    
+    u64 Result = Sum0 + Sum1 + Sum2 + Sum3;
+    return Result;
+}
+
+static b32 ReadAndSum(char *FileName, read_test Test, u64 BlockSize, u32 QueueDepth, u64 *Sum, u64 *ByteCount)
+{
+    // NOTE(agent): Each block is summed separately and then added, which matches no matter where the blocks split
+    *Sum = 0;
+    *ByteCount = 0;
+    
+    file_reader Reader;
+    if(!OpenFileReader(&Reader, FileName, Test.Backend, Test.Flags, BlockSize, QueueDepth))
+    {
+        return false;
+    }
+    
+    file_block Block;
+    while(NextFileBlock(&Reader, &Block))
+    {
+        *Sum += SumBlock(Block.Data, Block.Count);
+        *ByteCount += Block.Count;
+        ReleaseFileBlock(&Reader, &Block);
+    }
+    
+    b32 Result = !Reader.Failed;
+    CloseFileReader(&Reader);
+    
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    u32 SecondsToTry = 3;
+    u64 BlockSize = FILE_READER_BLOCK_SIZE;
+    u32 QueueDepth = FILE_READER_QUEUE_DEPTH;
+    char *FileName = 0;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else if(HasValue && (strcmp(Arg, "-block") == 0))
+        {
+            BlockSize = 1024*strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(HasValue && (strcmp(Arg, "-depth") == 0))
+        {
+            QueueDepth = atoi(Args[++ArgIndex]);
+        }
+        else if(!FileName)
+        {
+            FileName = Arg;
+        }
+        else
+        {
+            FileName = 0;
+            break;
+        }
+    }
+    
+    if(!FileName || (BlockSize < FILE_READER_ALIGNMENT) || (BlockSize % FILE_READER_ALIGNMENT) ||
+       (BlockSize > FILE_READER_MAX_BLOCK_SIZE) || (QueueDepth < 1) || (QueueDepth > FILE_READER_MAX_QUEUE_DEPTH))
+    {
+        fprintf(stderr, "USAGE: %s [-seconds count] [-block kilobytes, multiple of %u, up to %llu] [-depth 1 to %u] [data file]\n",
+                Args[0], FILE_READER_ALIGNMENT / 1024, FILE_READER_MAX_BLOCK_SIZE / 1024, FILE_READER_MAX_QUEUE_DEPTH);
+        return 1;
+    }
+    
+    int Result = 0;
+    
+    u64 CPUTimerFreq = GetCPUTimerFreq();
+    f64 Gigabyte = 1024.0*1024.0*1024.0;
+    
+    b32 HaveFirstSum = false;
+    u64 FirstSum = 0;
+    u64 FileSize = 0;
+    
+    fprintf(stdout, "Block size: %llukb, queue depth: %u\n\n", BlockSize / 1024, QueueDepth);
+    fprintf(stdout, "%-10s %-7s %-5s %10s %8s %10s\n", "Backend", "Direct", "Cache", "ms", "GB/s", "Faults");
+    
+    for(u32 TestIndex = 0; TestIndex < ArrayCount(ReadTests); ++TestIndex)
+    {
+        read_test Test = ReadTests[TestIndex];
+        for(u32 Cold = 0; Cold <= 1; ++Cold)
+        {
+            char const *BackendName = FileReadBackendNames[Test.Backend];
+            char const *DirectName = (Test.Flags & FileReaderFlag_Direct) ? "yes" : "no";
+            char const *CacheName = Cold ? "cold" : "warm";
+            
+            // NOTE(agent): A throwaway run first, both to see whether this backend works here at all, and so
+            // the warm runs really do start with the file in the page cache
+            u64 Sum = 0;
+            if(!ReadAndSum(FileName, Test, BlockSize, QueueDepth, &Sum, &FileSize))
+            {
+                fprintf(stdout, "%-10s %-7s %-5s %10s\n", BackendName, DirectName, CacheName, "(failed)");
+                break;
+            }
+            
+            if(Cold && !EvictFileFromCache(FileName))
+            {
+                fprintf(stdout, "%-10s %-7s %-5s %10s\n", BackendName, DirectName, CacheName, "(no evict)");
+                continue;
+            }
+            
+            repetition_tester Tester = {};
+            NewTestWave(&Tester, FileSize, CPUTimerFreq, SecondsToTry);
+            Tester.PrintNewMinimums = false;
+            while(IsTesting(&Tester))
+            {
+                if(Cold)
+                {
+                    EvictFileFromCache(FileName);
+                }
+                
+                u64 ByteCount = 0;
+                BeginTime(&Tester);
+                b32 Succeeded = ReadAndSum(FileName, Test, BlockSize, QueueDepth, &Sum, &ByteCount);
+                EndTime(&Tester);
+                CountBytes(&Tester, ByteCount);
+                
+                if(!Succeeded)
+                {
+                    Result = 1;
+                    break;
+                }
+                
+                if(!HaveFirstSum)
+                {
+                    FirstSum = Sum;
+                    HaveFirstSum = true;
+                }
+                else if(Sum != FirstSum)
+                {
+                    fprintf(stderr, "ERROR: %s%s read a different file than the first run did.\n",
+                            BackendName, (Test.Flags & FileReaderFlag_Direct) ? " (direct)" : "");
+                    Result = 1;
+                    break;
+                }
+            }
+            
+            repetition_value Min = Tester.Results.Min;
+            f64 Seconds = SecondsFromCPUTime((f64)Min.E[RepValue_CPUTimer], CPUTimerFreq);
+            fprintf(stdout, "%-10s %-7s %-5s %10.2f %8.3f %10llu\n", BackendName, DirectName, CacheName,
+                    1000.0*Seconds, ((f64)FileSize / Gigabyte) / Seconds, Min.E[RepValue_PageFaults]);
+        }
+    }
+    
+    return Result;
+}
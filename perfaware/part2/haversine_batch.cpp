@@ -0,0 +1,395 @@
+/* NOTE(agent): HaversineBatch computes the same thing as ReferenceHaversine (with an EarthRadius of EARTH_RADIUS),
+   for Count pairs at once, 2, 4, or 8 pairs at a time with SSE2, AVX2, or AVX-512. The widest one the CPU supports
+   is picked at runtime, and the environment variable HAVERSINE_ISA can be set to sse2 or avx2 to limit it.
+   
+   Instead of calling sin, cos, and asin, it uses the same polynomials and range reductions as CustomSin, CustomCos,
+   and CustomASin in haversine_math.cpp (which has to be included first), which vectorize trivially. The
+   polynomials are evaluated with FMAs on AVX2 and AVX-512, and with separate multiplies and adds on SSE2, so
+   the last bit can differ between them.
+   
+   HaversineBatchF32 is the same thing for f32 coordinates, with twice as many lanes per instruction, and shorter
+   polynomials (SinCoefficientsF32 and ASinCoefficientsF32). f32 only has 24 bits, though, so it can't just be the
+   f64 version with the types changed - the places where that version relies on f64 having bits to spare are
+   where f32 runs out:
+   
+   - The folds are done in degrees, before converting to radians: 90 - |lat| and 180 - |dLon| are exact in f32
+     for the inputs where it matters (close to the poles, and close to the antimeridian), while the same folds
+     in radians round Pi/2 and Pi first.
+   - dLon is computed as (180 - |lon1|) + (180 - |lon2|) for pairs across the antimeridian, instead of as
+     360 - |lon2 - lon1|, since lon2 - lon1 rounds there (it's close to 360) and a short distance is what's left.
+   - Close to antipodal, a is close to 1, where asin(sqrt(a)) is so steep that a's rounding error alone is
+     kilometers. So it also computes the haversine for the antipode of the second point, which is 1 - a without
+     the rounding, and uses Pi/2 - asin(sqrt(1 - a)) whenever that's the smaller one. That costs two more sin
+     polynomials, but it means the asin input is never more than about sqrt(0.5).
+   
+   Even so, the coordinates themselves only have about a meter of precision in f32 (a degree of longitude close to
+   180 is only good to 1.5e-5), so that is the least error to expect. haversine_f32_report measures how close it
+   actually gets to ReferenceHaversine. */
+
+#include <immintrin.h>
+
+#include "../part1/cpu_features.cpp"
+
+#if _MSC_VER
+#define HAVERSINE_TARGET_AVX2
+#define HAVERSINE_TARGET_AVX512
+#else
+#define HAVERSINE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define HAVERSINE_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+#ifndef EARTH_RADIUS
+#define EARTH_RADIUS 6372.8
+#endif
+
+//
+// NOTE(agent): SSE2
+//
+
+#define WIDE_NAME(Name) Name##SSE2
+#define WIDE_TARGET
+#define WIDE_WIDTH 2
+#define wide __m128d
+#define wide_mask __m128d
+#define WideLoad(Source) _mm_loadu_pd(Source)
+#define WideStore(Dest, A) _mm_storeu_pd(Dest, A)
+#define WideSet1(A) _mm_set1_pd(A)
+#define WideAdd(A, B) _mm_add_pd(A, B)
+#define WideSub(A, B) _mm_sub_pd(A, B)
+#define WideMul(A, B) _mm_mul_pd(A, B)
+#define WideMulAdd(A, B, C) _mm_add_pd(_mm_mul_pd(A, B), C)
+#define WideSqrt(A) _mm_sqrt_pd(A)
+#define WideMin(A, B) _mm_min_pd(A, B)
+#define WideAbs(A) _mm_andnot_pd(_mm_set1_pd(-0.0), A)
+#define WideGreaterThan(A, B) _mm_cmpgt_pd(A, B)
+#define WideSelect(Mask, A, B) _mm_or_pd(_mm_and_pd(Mask, A), _mm_andnot_pd(Mask, B))
+#include "haversine_batch.inl"
+#undef WIDE_NAME
+#undef WIDE_TARGET
+#undef WIDE_WIDTH
+#undef wide
+#undef wide_mask
+#undef WideLoad
+#undef WideStore
+#undef WideSet1
+#undef WideAdd
+#undef WideSub
+#undef WideMul
+#undef WideMulAdd
+#undef WideSqrt
+#undef WideMin
+#undef WideAbs
+#undef WideGreaterThan
+#undef WideSelect
+
+//
+// NOTE(agent): AVX2
+//
+
+#define WIDE_NAME(Name) Name##AVX2
+#define WIDE_TARGET HAVERSINE_TARGET_AVX2
+#define WIDE_WIDTH 4
+#define wide __m256d
+#define wide_mask __m256d
+#define WideLoad(Source) _mm256_loadu_pd(Source)
+#define WideStore(Dest, A) _mm256_storeu_pd(Dest, A)
+#define WideSet1(A) _mm256_set1_pd(A)
+#define WideAdd(A, B) _mm256_add_pd(A, B)
+#define WideSub(A, B) _mm256_sub_pd(A, B)
+#define WideMul(A, B) _mm256_mul_pd(A, B)
+#define WideMulAdd(A, B, C) _mm256_fmadd_pd(A, B, C)
+#define WideSqrt(A) _mm256_sqrt_pd(A)
+#define WideMin(A, B) _mm256_min_pd(A, B)
+#define WideAbs(A) _mm256_andnot_pd(_mm256_set1_pd(-0.0), A)
+#define WideGreaterThan(A, B) _mm256_cmp_pd(A, B, _CMP_GT_OQ)
+#define WideSelect(Mask, A, B) _mm256_blendv_pd(B, A, Mask)
+#include "haversine_batch.inl"
+#undef WIDE_NAME
+#undef WIDE_TARGET
+#undef WIDE_WIDTH
+#undef wide
+#undef wide_mask
+#undef WideLoad
+#undef WideStore
+#undef WideSet1
+#undef WideAdd
+#undef WideSub
+#undef WideMul
+#undef WideMulAdd
+#undef WideSqrt
+#undef WideMin
+#undef WideAbs
+#undef WideGreaterThan
+#undef WideSelect
+
+//
+// NOTE(agent): AVX-512
+//
+
+#define WIDE_NAME(Name) Name##AVX512
+#define WIDE_TARGET HAVERSINE_TARGET_AVX512
+#define WIDE_WIDTH 8
+#define wide __m512d
+#define wide_mask __mmask8
+#define WideLoad(Source) _mm512_loadu_pd(Source)
+#define WideStore(Dest, A) _mm512_storeu_pd(Dest, A)
+#define WideSet1(A) _mm512_set1_pd(A)
+#define WideAdd(A, B) _mm512_add_pd(A, B)
+#define WideSub(A, B) _mm512_sub_pd(A, B)
+#define WideMul(A, B) _mm512_mul_pd(A, B)
+#define WideMulAdd(A, B, C) _mm512_fmadd_pd(A, B, C)
+#define WideSqrt(A) _mm512_sqrt_pd(A)
+#define WideMin(A, B) _mm512_min_pd(A, B)
+#define WideAbs(A) _mm512_abs_pd(A)
+#define WideGreaterThan(A, B) _mm512_cmp_pd_mask(A, B, _CMP_GT_OQ)
+#define WideSelect(Mask, A, B) _mm512_mask_blend_pd(Mask, B, A)
+#include "haversine_batch.inl"
+#undef WIDE_NAME
+#undef WIDE_TARGET
+#undef WIDE_WIDTH
+#undef wide
+#undef wide_mask
+#undef WideLoad
+#undef WideStore
+#undef WideSet1
+#undef WideAdd
+#undef WideSub
+#undef WideMul
+#undef WideMulAdd
+#undef WideSqrt
+#undef WideMin
+#undef WideAbs
+#undef WideGreaterThan
+#undef WideSelect
+
+//
+// NOTE(agent): SSE2, f32
+//
+
+#define WIDE_NAME(Name) Name##SSE2
+#define WIDE_TARGET
+#define WIDE_WIDTH 4
+#define wide __m128
+#define wide_mask __m128
+#define WideLoad(Source) _mm_loadu_ps(Source)
+#define WideStore(Dest, A) _mm_storeu_ps(Dest, A)
+#define WideSet1(A) _mm_set1_ps(A)
+#define WideAdd(A, B) _mm_add_ps(A, B)
+#define WideSub(A, B) _mm_sub_ps(A, B)
+#define WideMul(A, B) _mm_mul_ps(A, B)
+#define WideMulAdd(A, B, C) _mm_add_ps(_mm_mul_ps(A, B), C)
+#define WideSqrt(A) _mm_sqrt_ps(A)
+#define WideAbs(A) _mm_andnot_ps(_mm_set1_ps(-0.0f), A)
+#define WideGreaterThan(A, B) _mm_cmpgt_ps(A, B)
+#define WideSelect(Mask, A, B) _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B))
+#include "haversine_batch_f32.inl"
+#undef WIDE_NAME
+#undef WIDE_TARGET
+#undef WIDE_WIDTH
+#undef wide
+#undef wide_mask
+#undef WideLoad
+#undef WideStore
+#undef WideSet1
+#undef WideAdd
+#undef WideSub
+#undef WideMul
+#undef WideMulAdd
+#undef WideSqrt
+#undef WideAbs
+#undef WideGreaterThan
+#undef WideSelect
+
+//
+// NOTE(agent): AVX2, f32
+//
+
+#define WIDE_NAME(Name) Name##AVX2
+#define WIDE_TARGET HAVERSINE_TARGET_AVX2
+#define WIDE_WIDTH 8
+#define wide __m256
+#define wide_mask __m256
+#define WideLoad(Source) _mm256_loadu_ps(Source)
+#define WideStore(Dest, A) _mm256_storeu_ps(Dest, A)
+#define WideSet1(A) _mm256_set1_ps(A)
+#define WideAdd(A, B) _mm256_add_ps(A, B)
+#define WideSub(A, B) _mm256_sub_ps(A, B)
+#define WideMul(A, B) _mm256_mul_ps(A, B)
+#define WideMulAdd(A, B, C) _mm256_fmadd_ps(A, B, C)
+#define WideSqrt(A) _mm256_sqrt_ps(A)
+#define WideAbs(A) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), A)
+#define WideGreaterThan(A, B) _mm256_cmp_ps(A, B, _CMP_GT_OQ)
+#define WideSelect(Mask, A, B) _mm256_blendv_ps(B, A, Mask)
+#include "haversine_batch_f32.inl"
+#undef WIDE_NAME
+#undef WIDE_TARGET
+#undef WIDE_WIDTH
+#undef wide
+#undef wide_mask
+#undef WideLoad
+#undef WideStore
+#undef WideSet1
+#undef WideAdd
+#undef WideSub
+#undef WideMul
+#undef WideMulAdd
+#undef WideSqrt
+#undef WideAbs
+#undef WideGreaterThan
+#undef WideSelect
+
+//
+// NOTE(agent): AVX-512, f32
+//
+
+#define WIDE_NAME(Name) Name##AVX512
+#define WIDE_TARGET HAVERSINE_TARGET_AVX512
+#define WIDE_WIDTH 16
+#define wide __m512
+#define wide_mask __mmask16
+#define WideLoad(Source) _mm512_loadu_ps(Source)
+#define WideStore(Dest, A) _mm512_storeu_ps(Dest, A)
+#define WideSet1(A) _mm512_set1_ps(A)
+#define WideAdd(A, B) _mm512_add_ps(A, B)
+#define WideSub(A, B) _mm512_sub_ps(A, B)
+#define WideMul(A, B) _mm512_mul_ps(A, B)
+#define WideMulAdd(A, B, C) _mm512_fmadd_ps(A, B, C)
+#define WideSqrt(A) _mm512_sqrt_ps(A)
+#define WideAbs(A) _mm512_abs_ps(A)
+#define WideGreaterThan(A, B) _mm512_cmp_ps_mask(A, B, _CMP_GT_OQ)
+#define WideSelect(Mask, A, B) _mm512_mask_blend_ps(Mask, B, A)
+#include "haversine_batch_f32.inl"
+#undef WIDE_NAME
+#undef WIDE_TARGET
+#undef WIDE_WIDTH
+#undef wide
+#undef wide_mask
+#undef WideLoad
+#undef WideStore
+#undef WideSet1
+#undef WideAdd
+#undef WideSub
+#undef WideMul
+#undef WideMulAdd
+#undef WideSqrt
+#undef WideAbs
+#undef WideGreaterThan
+#undef WideSelect
+
+//
+// NOTE(agent): Dispatch
+//
+
+enum haversine_isa
+{
+    HaversineISA_SSE2,
+    HaversineISA_AVX2,
+    HaversineISA_AVX512,
+    
+    HaversineISA_Count,
+};
+
+static char const *HaversineISANames[HaversineISA_Count] =
+{
+    "sse2",
+    "avx2",
+    "avx512",
+};
+
+typedef void haversine_batch_function(u64 Count, f64 *X0, f64 *Y0, f64 *X1, f64 *Y1, f64 *Out);
+
+static haversine_batch_function *HaversineBatchFunctions[HaversineISA_Count] =
+{
+    HaversineBatchSSE2,
+    HaversineBatchAVX2,
+    HaversineBatchAVX512,
+};
+
+typedef void haversine_batch_f32_function(u64 Count, f32 *X0, f32 *Y0, f32 *X1, f32 *Y1, f32 *Out);
+
+static haversine_batch_f32_function *HaversineBatchF32Functions[HaversineISA_Count] =
+{
+    HaversineBatchF32SSE2,
+    HaversineBatchF32AVX2,
+    HaversineBatchF32AVX512,
+};
+
+static haversine_isa GetSupportedHaversineISA(void)
+{
+    // NOTE(agent): The AVX2 kernels use FMAs, so they need both
+    haversine_isa Result = HaversineISA_SSE2;
+    
+    cpu_features Features = GetCPUFeatures();
+    if(Features.AVX2 && Features.FMA)
+    {
+        Result = HaversineISA_AVX2;
+        
+        if(Features.AVX512F)
+        {
+            Result = HaversineISA_AVX512;
+        }
+    }
+    
+    return Result;
+}
+
+static haversine_isa GetHaversineISA(void)
+{
+    haversine_isa Result = GetSupportedHaversineISA();
+    
+    char const *Override = getenv("HAVERSINE_ISA");
+    if(Override)
+    {
+        for(u32 ISA = 0; ISA < HaversineISA_Count; ++ISA)
+        {
+            if((strcmp(Override, HaversineISANames[ISA]) == 0) && (ISA < (u32)Result))
+            {
+                Result = (haversine_isa)ISA;
+            }
+        }
+    }
+    
+    return Result;
+}
+
+// NOTE(agent): SSE2 (which every x64 CPU has) until InitHaversineBatch is called
+static haversine_batch_function *HaversineBatchFunction = HaversineBatchFunctions[HaversineISA_SSE2];
+static haversine_batch_f32_function *HaversineBatchF32Function = HaversineBatchF32Functions[HaversineISA_SSE2];
+
+static void InitHaversineBatch(void)
+{
+    /* NOTE(agent): Picks the widest implementations available. This has to be called before any threads that
+       call HaversineBatch or HaversineBatchF32 are started - it is the only thing that ever writes their function
+       pointers, so after it, any number of threads can call them at once. */
+    haversine_isa ISA = GetHaversineISA();
+    HaversineBatchFunction = HaversineBatchFunctions[ISA];
+    HaversineBatchF32Function = HaversineBatchF32Functions[ISA];
+}
+
+static void HaversineBatch(u64 Count, f64 *X0, f64 *Y0, f64 *X1, f64 *Y1, f64 *Out)
+{
+    HaversineBatchFunction(Count, X0, Y0, X1, Y1, Out);
+}
+
+static void HaversineBatchF32(u64 Count, f32 *X0, f32 *Y0, f32 *X1, f32 *Y1, f32 *Out)
+{
+    HaversineBatchF32Function(Count, X0, Y0, X1, Y1, Out);
+}
+
+static void HaversineBatchReference(u64 Count, f64 *X0, f64 *Y0, f64 *X1, f64 *Y1, f64 *Out)
+{
+    // NOTE(agent): The same interface, but just calling ReferenceHaversine for each pair, for comparison
+    for(u64 Index = 0; Index < Count; ++Index)
+    {
+        Out[Index] = ReferenceHaversine(X0[Index], Y0[Index], X1[Index], Y1[Index], EARTH_RADIUS);
+    }
+}
+
+static void HaversineBatchCustom(u64 Count, f64 *X0, f64 *Y0, f64 *X1, f64 *Y1, f64 *Out)
+{
+    // NOTE(agent): One pair at a time, with the scalar versions of the same math
+    for(u64 Index = 0; Index < Count; ++Index)
+    {
+        Out[Index] = CustomHaversine(X0[Index], Y0[Index], X1[Index], Y1[Index], EARTH_RADIUS);
+    }
+}
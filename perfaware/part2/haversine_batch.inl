@@ -0,0 +1,120 @@
+/* NOTE(agent): This is the body of HaversineBatch, written once in terms of the WIDE_ macros, and included by
+   haversine_batch.cpp once for each instruction set with the macros set to that instruction set's intrinsics.
+   See haversine_batch.cpp for what the math is doing. */
+
+WIDE_TARGET static inline wide WIDE_NAME(SinPolynomial)(wide X)
+{
+    // NOTE(agent): 0 <= X <= Pi/2
+    f64 const *C = SinCoefficients;
+    wide X2 = WideMul(X, X);
+    
+    wide P = WideSet1(C[8]);
+    P = WideMulAdd(P, X2, WideSet1(C[7]));
+    P = WideMulAdd(P, X2, WideSet1(C[6]));
+    P = WideMulAdd(P, X2, WideSet1(C[5]));
+    P = WideMulAdd(P, X2, WideSet1(C[4]));
+    P = WideMulAdd(P, X2, WideSet1(C[3]));
+    P = WideMulAdd(P, X2, WideSet1(C[2]));
+    P = WideMulAdd(P, X2, WideSet1(C[1]));
+    
+    wide Result = WideMulAdd(X, WideMul(X2, P), X);
+    return Result;
+}
+
+WIDE_TARGET static inline wide WIDE_NAME(Cos)(wide X)
+{
+    // NOTE(agent): -Pi/2 <= X <= Pi/2
+    wide Folded = WideAdd(WideSub(WideSet1(HALF_PI_HI), WideAbs(X)), WideSet1(HALF_PI_LO));
+    wide Result = WIDE_NAME(SinPolynomial)(Folded);
+    return Result;
+}
+
+WIDE_TARGET static inline wide WIDE_NAME(ASin)(wide X)
+{
+    // NOTE(agent): 0 <= X <= 1
+    wide_mask IsLarge = WideGreaterThan(X, WideSet1(0.5));
+    wide Folded = WideSqrt(WideMul(WideSub(WideSet1(1.0), X), WideSet1(0.5)));
+    wide U = WideSelect(IsLarge, Folded, X);
+    
+    f64 const *C = ASinCoefficients;
+    wide U2 = WideMul(U, U);
+    
+    wide P = WideSet1(C[12]);
+    P = WideMulAdd(P, U2, WideSet1(C[11]));
+    P = WideMulAdd(P, U2, WideSet1(C[10]));
+    P = WideMulAdd(P, U2, WideSet1(C[9]));
+    P = WideMulAdd(P, U2, WideSet1(C[8]));
+    P = WideMulAdd(P, U2, WideSet1(C[7]));
+    P = WideMulAdd(P, U2, WideSet1(C[6]));
+    P = WideMulAdd(P, U2, WideSet1(C[5]));
+    P = WideMulAdd(P, U2, WideSet1(C[4]));
+    P = WideMulAdd(P, U2, WideSet1(C[3]));
+    P = WideMulAdd(P, U2, WideSet1(C[2]));
+    P = WideMulAdd(P, U2, WideSet1(C[1]));
+    
+    wide Tail = WideMul(U, WideMul(U2, P));
+    wide Small = WideAdd(U, Tail);
+    wide Large = WideAdd(WideSub(WideSet1(HALF_PI_HI), WideAdd(U, U)), WideSub(WideSet1(HALF_PI_LO), WideAdd(Tail, Tail)));
+    wide Result = WideSelect(IsLarge, Large, Small);
+    return Result;
+}
+
+WIDE_TARGET static inline void WIDE_NAME(HaversineLanes)(f64 *X0, f64 *Y0, f64 *X1, f64 *Y1, f64 *Out)
+{
+    wide HalfRadiansPerDegree = WideSet1(0.5*RADIANS_PER_DEGREE);
+    wide RadiansPerDegree = WideSet1(RADIANS_PER_DEGREE);
+    
+    wide Lat1 = WideLoad(Y0);
+    wide Lat2 = WideLoad(Y1);
+    wide Lon1 = WideLoad(X0);
+    wide Lon2 = WideLoad(X1);
+    
+    // NOTE(agent): |HalfDLat| <= Pi/2, so it can go straight to the quarter wave
+    wide HalfDLat = WideAbs(WideMul(WideSub(Lat2, Lat1), HalfRadiansPerDegree));
+    wide SinHalfDLat = WIDE_NAME(SinPolynomial)(HalfDLat);
+    
+    // NOTE(agent): |HalfDLon| <= Pi, and |sin(x)| = sin(Pi - x), so it is folded over first
+    wide HalfDLon = WideAbs(WideMul(WideSub(Lon2, Lon1), HalfRadiansPerDegree));
+    wide FoldedDLon = WideAdd(WideSub(WideSet1(PI_HI), HalfDLon), WideSet1(PI_LO));
+    HalfDLon = WideSelect(WideGreaterThan(HalfDLon, WideSet1(HALF_PI)), FoldedDLon, HalfDLon);
+    wide SinHalfDLon = WIDE_NAME(SinPolynomial)(HalfDLon);
+    
+    wide CosLat1 = WIDE_NAME(Cos)(WideMul(Lat1, RadiansPerDegree));
+    wide CosLat2 = WIDE_NAME(Cos)(WideMul(Lat2, RadiansPerDegree));
+    
+    wide A = WideMulAdd(WideMul(CosLat1, CosLat2), WideMul(SinHalfDLon, SinHalfDLon), WideMul(SinHalfDLat, SinHalfDLat));
+    A = WideMin(A, WideSet1(1.0));
+    
+    wide C = WIDE_NAME(ASin)(WideSqrt(A));
+    WideStore(Out, WideMul(C, WideSet1(2.0*EARTH_RADIUS)));
+}
+
+WIDE_TARGET static void WIDE_NAME(HaversineBatch)(u64 Count, f64 *X0, f64 *Y0, f64 *X1, f64 *Y1, f64 *Out)
+{
+    u64 Index = 0;
+    for(; (Index + WIDE_WIDTH) <= Count; Index += WIDE_WIDTH)
+    {
+        WIDE_NAME(HaversineLanes)(X0 + Index, Y0 + Index, X1 + Index, Y1 + Index, Out + Index);
+    }
+    
+    if(Index < Count)
+    {
+        // NOTE(agent): The last few pairs go through the same lanes as everything else, padded out with zeros
+        f64 Pad[5][WIDE_WIDTH] = {};
+        u64 Remaining = Count - Index;
+        for(u64 Lane = 0; Lane < Remaining; ++Lane)
+        {
+            Pad[0][Lane] = X0[Index + Lane];
+            Pad[1][Lane] = Y0[Index + Lane];
+            Pad[2][Lane] = X1[Index + Lane];
+            Pad[3][Lane] = Y1[Index + Lane];
+        }
+        
+        WIDE_NAME(HaversineLanes)(Pad[0], Pad[1], Pad[2], Pad[3], Pad[4]);
+        
+        for(u64 Lane = 0; Lane < Remaining; ++Lane)
+        {
+            Out[Index + Lane] = Pad[4][Lane];
+        }
+    }
+}
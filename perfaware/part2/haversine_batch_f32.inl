@@ -0,0 +1,110 @@
+/* NOTE(agent): This is the body of HaversineBatchF32, written once in terms of the WIDE_ macros (set to the f32
+   intrinsics), and included by haversine_batch.cpp once for each instruction set. See haversine_batch.cpp for
+   what the math is doing, and why it is different from haversine_batch.inl. */
+
+WIDE_TARGET static inline wide WIDE_NAME(SinPolynomialF32)(wide X)
+{
+    // NOTE(agent): 0 <= X <= Pi/2
+    f32 const *C = SinCoefficientsF32;
+    wide X2 = WideMul(X, X);
+    
+    wide P = WideSet1(C[4]);
+    P = WideMulAdd(P, X2, WideSet1(C[3]));
+    P = WideMulAdd(P, X2, WideSet1(C[2]));
+    P = WideMulAdd(P, X2, WideSet1(C[1]));
+    
+    wide Result = WideMulAdd(X, WideMul(X2, P), X);
+    return Result;
+}
+
+WIDE_TARGET static inline wide WIDE_NAME(ASinF32)(wide X)
+{
+    // NOTE(agent): 0 <= X <= 1, although here it's never much more than sqrt(0.5)
+    wide_mask IsLarge = WideGreaterThan(X, WideSet1(0.5f));
+    wide Folded = WideSqrt(WideMul(WideSub(WideSet1(1.0f), X), WideSet1(0.5f)));
+    wide U = WideSelect(IsLarge, Folded, X);
+    
+    f32 const *C = ASinCoefficientsF32;
+    wide U2 = WideMul(U, U);
+    
+    wide P = WideSet1(C[5]);
+    P = WideMulAdd(P, U2, WideSet1(C[4]));
+    P = WideMulAdd(P, U2, WideSet1(C[3]));
+    P = WideMulAdd(P, U2, WideSet1(C[2]));
+    P = WideMulAdd(P, U2, WideSet1(C[1]));
+    
+    wide Tail = WideMul(U, WideMul(U2, P));
+    wide Small = WideAdd(U, Tail);
+    wide Large = WideSub(WideSet1((f32)HALF_PI), WideAdd(WideAdd(U, U), WideAdd(Tail, Tail)));
+    wide Result = WideSelect(IsLarge, Large, Small);
+    return Result;
+}
+
+WIDE_TARGET static inline void WIDE_NAME(HaversineLanesF32)(f32 *X0, f32 *Y0, f32 *X1, f32 *Y1, f32 *Out)
+{
+    wide HalfRadiansPerDegree = WideSet1((f32)(0.5*RADIANS_PER_DEGREE));
+    wide RadiansPerDegree = WideSet1((f32)RADIANS_PER_DEGREE);
+    wide Ninety = WideSet1(90.0f);
+    wide OneEighty = WideSet1(180.0f);
+    
+    wide Lat1 = WideLoad(Y0);
+    wide Lat2 = WideLoad(Y1);
+    wide Lon1 = WideLoad(X0);
+    wide Lon2 = WideLoad(X1);
+    
+    // NOTE(agent): Across the antimeridian, the short way around is 360 - |dLon|, which is summed from each side's
+    // distance to 180 instead, since those are exact and 360 - |dLon| wouldn't be
+    wide DLon = WideAbs(WideSub(Lon2, Lon1));
+    wide WrappedDLon = WideAdd(WideSub(OneEighty, WideAbs(Lon1)), WideSub(OneEighty, WideAbs(Lon2)));
+    DLon = WideSelect(WideGreaterThan(DLon, OneEighty), WrappedDLon, DLon);
+    
+    wide SinHalfDLat = WIDE_NAME(SinPolynomialF32)(WideMul(WideAbs(WideSub(Lat2, Lat1)), HalfRadiansPerDegree));
+    wide SinHalfSLat = WIDE_NAME(SinPolynomialF32)(WideMul(WideAbs(WideAdd(Lat2, Lat1)), HalfRadiansPerDegree));
+    wide SinHalfDLon = WIDE_NAME(SinPolynomialF32)(WideMul(DLon, HalfRadiansPerDegree));
+    wide CosHalfDLon = WIDE_NAME(SinPolynomialF32)(WideMul(WideSub(OneEighty, DLon), HalfRadiansPerDegree));
+    
+    // NOTE(agent): cos(lat) = sin(90 - |lat|), folded in degrees, where it's exact near the poles
+    wide CosLat1 = WIDE_NAME(SinPolynomialF32)(WideMul(WideSub(Ninety, WideAbs(Lat1)), RadiansPerDegree));
+    wide CosLat2 = WIDE_NAME(SinPolynomialF32)(WideMul(WideSub(Ninety, WideAbs(Lat2)), RadiansPerDegree));
+    wide CosLat12 = WideMul(CosLat1, CosLat2);
+    
+    // NOTE(agent): A is the haversine of the distance, and Antipodal is the haversine of the distance from the first
+    // point to the opposite side of the earth from the second point, which is 1 - A, but without the rounding
+    wide A = WideMulAdd(CosLat12, WideMul(SinHalfDLon, SinHalfDLon), WideMul(SinHalfDLat, SinHalfDLat));
+    wide Antipodal = WideMulAdd(CosLat12, WideMul(CosHalfDLon, CosHalfDLon), WideMul(SinHalfSLat, SinHalfSLat));
+    
+    wide_mask IsFar = WideGreaterThan(A, Antipodal);
+    wide C = WIDE_NAME(ASinF32)(WideSqrt(WideSelect(IsFar, Antipodal, A)));
+    C = WideSelect(IsFar, WideSub(WideSet1((f32)HALF_PI), C), C);
+    
+    WideStore(Out, WideMul(C, WideSet1((f32)(2.0*EARTH_RADIUS))));
+}
+
+WIDE_TARGET static void WIDE_NAME(HaversineBatchF32)(u64 Count, f32 *X0, f32 *Y0, f32 *X1, f32 *Y1, f32 *Out)
+{
+    u64 Index = 0;
+    for(; (Index + WIDE_WIDTH) <= Count; Index += WIDE_WIDTH)
+    {
+        WIDE_NAME(HaversineLanesF32)(X0 + Index, Y0 + Index, X1 + Index, Y1 + Index, Out + Index);
+    }
+    
+    if(Index < Count)
+    {
+        f32 Pad[5][WIDE_WIDTH] = {};
+        u64 Remaining = Count - Index;
+        for(u64 Lane = 0; Lane < Remaining; ++Lane)
+        {
+            Pad[0][Lane] = X0[Index + Lane];
+            Pad[1][Lane] = Y0[Index + Lane];
+            Pad[2][Lane] = X1[Index + Lane];
+            Pad[3][Lane] = Y1[Index + Lane];
+        }
+        
+        WIDE_NAME(HaversineLanesF32)(Pad[0], Pad[1], Pad[2], Pad[3], Pad[4]);
+        
+        for(u64 Lane = 0; Lane < Remaining; ++Lane)
+        {
+            Out[Index + Lane] = Pad[4][Lane];
+        }
+    }
+}
@@ -0,0 +1,174 @@
+/* NOTE(agent): Checks every HaversineBatch implementation this CPU can run (and the scalar CustomHaversine)
+   against ReferenceHaversine, over all the pairs in a haversine_generator JSON file, and then times each of them
+   (and the reference) with the repetition tester.
+   
+   Usage: haversine_batch_report [-seconds count] [data_<count>_flex.json]
+   
+   The error columns are the largest difference from the reference over all the pairs, both in ulps (units in the
+   last place of the reference distance) and in km, along with the pair it happened on. The reference has its own
+   rounding error, which is around the same size, so a few ulps here doesn't mean the batch version is the
+   less accurate of the two.
+   
+   Throughput is pairs per CPU timer tick, which may not be the same as core clocks (see platform_metrics.cpp),
+   using the fastest run the repetition tester saw. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "profiler.cpp"
+#include "listing_0065_haversine_formula.cpp"
+#include "os_memory.cpp"
+#include "arena.cpp"
+#include "haversine_json.cpp"
+#include "haversine_math.cpp"
+#include "haversine_batch.cpp"
+#include "haversine_batch_timing.cpp"
+
+struct batch_error
+{
+    u64 MaxULP;
+    u64 MaxULPIndex;
+    f64 MaxError;
+    u64 MaxErrorIndex;
+};
+
+static u64 OrderedBits(f64 Value)
+{
+    // NOTE(agent): Maps f64s onto u64s so that adjacent f64s are adjacent integers, negative numbers included
+    u64 Bits;
+    memcpy(&Bits, &Value, sizeof(Bits));
+    
+    u64 Result = (Bits & (1ULL << 63)) ? ~Bits : (Bits | (1ULL << 63));
+    return Result;
+}
+
+static u64 ULPDistance(f64 A, f64 B)
+{
+    u64 OrderedA = OrderedBits(A);
+    u64 OrderedB = OrderedBits(B);
+    
+    u64 Result = (OrderedA > OrderedB) ? (OrderedA - OrderedB) : (OrderedB - OrderedA);
+    return Result;
+}
+
+static batch_error CompareDistances(u64 Count, f64 *Distances, f64 *Reference)
+{
+    batch_error Result = {};
+    
+    for(u64 Index = 0; Index < Count; ++Index)
+    {
+        u64 ULP = ULPDistance(Distances[Index], Reference[Index]);
+        if(Result.MaxULP < ULP)
+        {
+            Result.MaxULP = ULP;
+            Result.MaxULPIndex = Index;
+        }
+        
+        f64 Error = fabs(Distances[Index] - Reference[Index]);
+        if(Result.MaxError < Error)
+        {
+            Result.MaxError = Error;
+            Result.MaxErrorIndex = Index;
+        }
+    }
+    
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    InitHaversineBatch();
+    
+    u32 SecondsToTry = 3;
+    char *JSONFileName = 0;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else if(!JSONFileName)
+        {
+            JSONFileName = Arg;
+        }
+        else
+        {
+            JSONFileName = 0;
+            break;
+        }
+    }
+    
+    if(!JSONFileName)
+    {
+        fprintf(stderr, "USAGE: %s [-seconds count] [haversine_input.json]\n", Args[0]);
+        return 1;
+    }
+    
+    int Result = 1;
+    
+    buffer InputJSON = ReadEntireFile(JSONFileName);
+    haversine_pairs Pairs = AllocatePairs(GetMaxPairCount(InputJSON.Count));
+    if(InputJSON.Data && Pairs.Memory.Data && ParseHaversinePairs(InputJSON, &Pairs) && Pairs.Count)
+    {
+        f64 *Reference = (f64 *)malloc(Pairs.Count*sizeof(f64));
+        f64 *Distances = (f64 *)malloc(Pairs.Count*sizeof(f64));
+        if(Reference && Distances)
+        {
+            HaversineBatchReference(Pairs.Count, Pairs.X0, Pairs.Y0, Pairs.X1, Pairs.Y1, Reference);
+            
+            haversine_isa SupportedISA = GetHaversineISA();
+            
+            fprintf(stdout, "Pair count: %llu\n\n", Pairs.Count);
+            fprintf(stdout, "%-10s %10s %10s %14s %10s %12s %8s\n",
+                    "Kernel", "Max ulp", "(pair)", "Max error km", "(pair)", "Pairs/tick", "x");
+            
+            f64 ReferencePairsPerTick = TimeBatch(HaversineBatchReference, Pairs, Distances, SecondsToTry);
+            fprintf(stdout, "%-10s %10s %10s %14s %10s %12.4f %8.2f\n",
+                    "reference", "-", "-", "-", "-", ReferencePairsPerTick, 1.0);
+            
+            for(u32 RowIndex = 0; RowIndex <= ((u32)SupportedISA + 1); ++RowIndex)
+            {
+                // NOTE(agent): The first row is the scalar custom math, and the rest are the HaversineBatch kernels
+                haversine_batch_function *Function = RowIndex ? HaversineBatchFunctions[RowIndex - 1] : HaversineBatchCustom;
+                char const *Name = RowIndex ? HaversineISANames[RowIndex - 1] : "custom";
+                
+                Function(Pairs.Count, Pairs.X0, Pairs.Y0, Pairs.X1, Pairs.Y1, Distances);
+                batch_error Error = CompareDistances(Pairs.Count, Distances, Reference);
+                
+                f64 PairsPerTick = TimeBatch(Function, Pairs, Distances, SecondsToTry);
+                fprintf(stdout, "%-10s %10llu %10llu %14.3e %10llu %12.4f %8.2f\n",
+                        Name, Error.MaxULP, Error.MaxULPIndex, Error.MaxError, Error.MaxErrorIndex,
+                        PairsPerTick, PairsPerTick / ReferencePairsPerTick);
+            }
+            
+            Result = 0;
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Unable to allocate space for the distances.\n");
+        }
+        
+        free(Reference);
+        free(Distances);
+    }
+    else if(InputJSON.Data && Pairs.Memory.Data)
+    {
+        fprintf(stderr, "ERROR: No pairs in \"%s\".\n", JSONFileName);
+    }
+    
+    FreePairs(&Pairs);
+    FreeBuffer(&InputJSON);
+    
+    return Result;
+}
+
+ProfilerEndOfCompilationUnit;
@@ -0,0 +1,24 @@
+/* NOTE(agent): Repetition-tester timing for a HaversineBatch function, shared by haversine_batch_report and
+   haversine_f32_report. Include it after repetition_tester.cpp and haversine_batch.cpp.
+   
+   It returns pairs per CPU timer tick for the fastest run the tester saw, and counts the four input coordinates
+   of every pair as the bytes touched. */
+
+static f64 TimeBatch(haversine_batch_function *Function, haversine_pairs Pairs, f64 *Out, u32 SecondsToTry)
+{
+    u64 ByteCount = Pairs.Count*4*sizeof(f64);
+    
+    repetition_tester Tester = {};
+    NewTestWave(&Tester, ByteCount, GetCPUTimerFreq(), SecondsToTry);
+    Tester.PrintNewMinimums = false;
+    while(IsTesting(&Tester))
+    {
+        BeginTime(&Tester);
+        Function(Pairs.Count, Pairs.X0, Pairs.Y0, Pairs.X1, Pairs.Y1, Out);
+        EndTime(&Tester);
+        CountBytes(&Tester, ByteCount);
+    }
+    
+    f64 Result = (f64)Pairs.Count / (f64)Tester.Results.Min.E[RepValue_CPUTimer];
+    return Result;
+}
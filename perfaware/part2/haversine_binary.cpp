@@ -0,0 +1,193 @@
+/* NOTE(agent): A binary file of haversine pairs, laid out exactly the way the kernels want them in memory, so that
+   a file that has already been parsed (and checked) once never has to be parsed again:
+   
+   [haversine_binary_header, 64 bytes]
+   [x0 array: PairCount f64s, zero padded to ArraySize bytes]
+   [y0 array: same]
+   [x1 array: same]
+   [y1 array: same]
+   
+   ArraySize is a multiple of 64, so every array starts on a cache line (the file is mapped on a page boundary).
+   OpenHaversineBinary maps the file and points a haversine_pairs straight at the arrays in the mapping, so
+   nothing is copied or converted - the kernels read the OS's page cache directly. The mapping is read-only, so
+   those pairs can't be parsed into or written to, and they must not be passed to FreePairs (which is harmless,
+   since their Memory is empty, but pointless).
+   
+   The checksum covers everything after the header, padding included. It is four independent Fletcher-style
+   lanes (a running sum, and a running sum of that running sum, so the position of each word matters) that are
+   mixed together at the end. That's only a few adds per 8 bytes, none of them waiting on a multiply, which is
+   what lets it keep up with memory bandwidth. It is there to catch truncated, damaged, or stale files - it is
+   not a cryptographic hash.
+   
+   Needs haversine_json.cpp, os_memory.cpp and file_reader.cpp included first. */
+
+// NOTE(agent): "HAVPAIRS" in little-endian order
+#define HAVERSINE_BINARY_MAGIC 0x5352494150564148ull
+#define HAVERSINE_BINARY_VERSION 1
+
+struct haversine_binary_header
+{
+    u64 Magic;
+    u32 Version;
+    u32 HeaderSize;
+    
+    u64 PairCount;
+    u64 ArraySize;
+    u64 Checksum;
+    
+    u64 Reserved[3];
+};
+
+struct haversine_binary
+{
+    file_reader Reader;
+    haversine_binary_header *Header;
+    haversine_pairs Pairs;
+};
+
+static u64 GetHaversineArraySize(u64 PairCount)
+{
+    // NOTE(agent): PairCount has to be one that could fit in a file, or this overflows - OpenHaversineBinary checks
+    // the count against the file size before it gets here
+    u64 Result = ((PairCount*sizeof(f64)) + 63) & ~63ull;
+    return Result;
+}
+
+static u64 ChecksumHaversineArrays(u8 *Data, u64 Size)
+{
+    // NOTE(agent): Size is always a multiple of 64 here (4 arrays of ArraySize bytes)
+    u64 A0 = 0, A1 = 0, A2 = 0, A3 = 0;
+    u64 B0 = 0, B1 = 0, B2 = 0, B3 = 0;
+    
+    for(u64 Offset = 0; Offset < Size; Offset += 32)
+    {
+        u64 Words[4];
+        memcpy(Words, Data + Offset, sizeof(Words));
+        
+        A0 += Words[0]; B0 += A0;
+        A1 += Words[1]; B1 += A1;
+        A2 += Words[2]; B2 += A2;
+        A3 += Words[3]; B3 += A3;
+    }
+    
+    // NOTE(agent): FNV-1a over the lanes (a 64-bit word at a time), so that swapping lanes changes the result
+    u64 Lanes[] = {A0, A1, A2, A3, B0, B1, B2, B3, Size};
+    u64 Result = 0xcbf29ce484222325ull;
+    for(u32 LaneIndex = 0; LaneIndex < (sizeof(Lanes)/sizeof(Lanes[0])); ++LaneIndex)
+    {
+        Result ^= Lanes[LaneIndex];
+        Result *= 0x100000001b3ull;
+    }
+    
+    return Result;
+}
+
+static b32 WriteHaversineBinary(char *FileName, haversine_pairs Pairs)
+{
+    b32 Result = false;
+    
+    // NOTE(agent): The pairs' own arrays are spaced for MaxCount, not Count, so the file's layout is built in
+    // memory first, which is also what the checksum has to run over
+    u64 ArraySize = GetHaversineArraySize(Pairs.Count);
+    os_memory Image = AllocateOSMemory(4*ArraySize, GetDefaultMemoryPolicy());
+    if(Image.Data)
+    {
+        f64 *Arrays[] = {Pairs.X0, Pairs.Y0, Pairs.X1, Pairs.Y1};
+        for(u32 ArrayIndex = 0; ArrayIndex < 4; ++ArrayIndex)
+        {
+            memcpy(Image.Data + ArrayIndex*ArraySize, Arrays[ArrayIndex], Pairs.Count*sizeof(f64));
+        }
+        
+        haversine_binary_header Header = {};
+        Header.Magic = HAVERSINE_BINARY_MAGIC;
+        Header.Version = HAVERSINE_BINARY_VERSION;
+        Header.HeaderSize = sizeof(Header);
+        Header.PairCount = Pairs.Count;
+        Header.ArraySize = ArraySize;
+        Header.Checksum = ChecksumHaversineArrays(Image.Data, 4*ArraySize);
+        
+        FILE *File = fopen(FileName, "wb");
+        if(File)
+        {
+            Result = ((fwrite(&Header, sizeof(Header), 1, File) == 1) &&
+                      (!ArraySize || (fwrite(Image.Data, 4*ArraySize, 1, File) == 1)));
+            Result = ((fclose(File) == 0) && Result);
+            if(!Result)
+            {
+                fprintf(stderr, "ERROR: Unable to write \"%s\".\n", FileName);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Unable to open \"%s\" for writing.\n", FileName);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate space to build \"%s\".\n", FileName);
+    }
+    
+    FreeOSMemory(&Image);
+    
+    return Result;
+}
+
+static void CloseHaversineBinary(haversine_binary *Binary)
+{
+    CloseFileReader(&Binary->Reader);
+    *Binary = {};
+}
+
+static b32 OpenHaversineBinary(haversine_binary *Binary, char *FileName, b32 VerifyChecksum = true)
+{
+    *Binary = {};
+    
+    // NOTE(agent): Verifying reads every page of the file, so it might as well all be mapped in one go
+    u32 Flags = VerifyChecksum ? FileReaderFlag_Populate : 0;
+    if(!OpenFileReader(&Binary->Reader, FileName, FileRead_MMap, Flags))
+    {
+        return false;
+    }
+    
+    u8 *File = Binary->Reader.Memory;
+    u64 FileSize = Binary->Reader.FileSize;
+    haversine_binary_header *Header = (haversine_binary_header *)File;
+    
+    char const *Error = 0;
+    if((FileSize < sizeof(haversine_binary_header)) || (Header->Magic != HAVERSINE_BINARY_MAGIC))
+    {
+        Error = "is not a haversine binary file";
+    }
+    else if((Header->Version != HAVERSINE_BINARY_VERSION) || (Header->HeaderSize != sizeof(haversine_binary_header)))
+    {
+        Error = "is a different version of the haversine binary format";
+    }
+    else if((Header->PairCount > ((FileSize - sizeof(haversine_binary_header)) / (4*sizeof(f64)))) ||
+            (Header->ArraySize != GetHaversineArraySize(Header->PairCount)) ||
+            (FileSize != (sizeof(haversine_binary_header) + 4*Header->ArraySize)))
+    {
+        Error = "is the wrong size for the number of pairs it says it has";
+    }
+    else if(VerifyChecksum && (ChecksumHaversineArrays(File + Header->HeaderSize, 4*Header->ArraySize) != Header->Checksum))
+    {
+        Error = "failed its checksum";
+    }
+    
+    if(Error)
+    {
+        fprintf(stderr, "ERROR: \"%s\" %s.\n", FileName, Error);
+        CloseHaversineBinary(Binary);
+        return false;
+    }
+    
+    u8 *Arrays = File + Header->HeaderSize;
+    Binary->Header = Header;
+    Binary->Pairs.Count = Header->PairCount;
+    Binary->Pairs.MaxCount = Header->PairCount;
+    Binary->Pairs.X0 = (f64 *)(Arrays + 0*Header->ArraySize);
+    Binary->Pairs.Y0 = (f64 *)(Arrays + 1*Header->ArraySize);
+    Binary->Pairs.X1 = (f64 *)(Arrays + 2*Header->ArraySize);
+    Binary->Pairs.Y1 = (f64 *)(Arrays + 3*Header->ArraySize);
+    
+    return true;
+}
@@ -0,0 +1,239 @@
+/* NOTE(agent): Converts a haversine_generator JSON file into the binary format in haversine_binary.cpp, then opens
+   the binary file it wrote and checks that every coordinate in it is bit-for-bit what the JSON parse produced,
+   and that the kernels get the same average from either one.
+   
+   Usage: haversine_convert [-seconds count] [data_<count>_flex.json] [data_<count>.hvp]
+   
+   It then times, with the repetition tester:
+   
+   json parse:  ParseHaversinePairs on the JSON, already in memory.
+   binary open: OpenHaversineBinary with the checksum verified (mapping and unmapping included).
+   checksum:    Just ChecksumHaversineArrays, over the already-mapped arrays.
+   sum:         Adding up the same bytes as u64s, which is about the least work a pass over them can do, so it
+                is the memory bandwidth the checksum is competing with.
+   
+   -seconds 0 skips the timing. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "profiler.cpp"
+#include "listing_0065_haversine_formula.cpp"
+#include "os_memory.cpp"
+#include "arena.cpp"
+#include "haversine_json.cpp"
+#include "haversine_math.cpp"
+#include "haversine_batch.cpp"
+#include "file_reader.cpp"
+#include "haversine_binary.cpp"
+
+static f64 AverageHaversineDistance(haversine_pairs Pairs, f64 *Distances)
+{
+    HaversineBatch(Pairs.Count, Pairs.X0, Pairs.Y0, Pairs.X1, Pairs.Y1, Distances);
+    
+    f64 Sum = 0;
+    for(u64 PairIndex = 0; PairIndex < Pairs.Count; ++PairIndex)
+    {
+        Sum += Distances[PairIndex];
+    }
+    
+    f64 Result = Pairs.Count ? (Sum / (f64)Pairs.Count) : 0;
+    return Result;
+}
+
+static b32 SamePairs(haversine_pairs A, haversine_pairs B)
+{
+    u64 Size = A.Count*sizeof(f64);
+    b32 Result = ((A.Count == B.Count) &&
+                  (memcmp(A.X0, B.X0, Size) == 0) && (memcmp(A.Y0, B.Y0, Size) == 0) &&
+                  (memcmp(A.X1, B.X1, Size) == 0) && (memcmp(A.Y1, B.Y1, Size) == 0));
+    return Result;
+}
+
+static u64 SumWords(u8 *Data, u64 Size)
+{
+    u64 Sum0 = 0, Sum1 = 0, Sum2 = 0, Sum3 = 0;
+    for(u64 Offset = 0; Offset < Size; Offset += 32)
+    {
+        u64 Words[4];
+        memcpy(Words, Data + Offset, sizeof(Words));
+        Sum0 += Words[0];
+        Sum1 += Words[1];
+        Sum2 += Words[2];
+        Sum3 += Words[3];
+    }
+    
+    u64 Result = Sum0 + Sum1 + Sum2 + Sum3;
+    return Result;
+}
+
+static void PrintTiming(char const *Name, repetition_tester *Tester, u64 ByteCount)
+{
+    f64 Seconds = SecondsFromCPUTime((f64)Tester->Results.Min.E[RepValue_CPUTimer], Tester->CPUTimerFreq);
+    f64 Gigabyte = 1024.0*1024.0*1024.0;
+    fprintf(stdout, "%-12s %12llu %10.3f %8.3f\n", Name, ByteCount, 1000.0*Seconds, ((f64)ByteCount / Gigabyte) / Seconds);
+}
+
+int main(int ArgCount, char **Args)
+{
+    InitHaversineBatch();
+    
+    u32 SecondsToTry = 3;
+    char *JSONFileName = 0;
+    char *BinaryFileName = 0;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else if(!JSONFileName)
+        {
+            JSONFileName = Arg;
+        }
+        else if(!BinaryFileName)
+        {
+            BinaryFileName = Arg;
+        }
+        else
+        {
+            JSONFileName = 0;
+            break;
+        }
+    }
+    
+    if(!JSONFileName || !BinaryFileName)
+    {
+        fprintf(stderr, "USAGE: %s [-seconds count] [haversine_input.json] [haversine_output.hvp]\n", Args[0]);
+        return 1;
+    }
+    
+    int Result = 1;
+    
+    buffer InputJSON = ReadEntireFile(JSONFileName);
+    haversine_pairs Pairs = AllocatePairs(GetMaxPairCount(InputJSON.Count));
+    if(InputJSON.Data && Pairs.Memory.Data && ParseHaversinePairs(InputJSON, &Pairs) &&
+       WriteHaversineBinary(BinaryFileName, Pairs))
+    {
+        haversine_binary Binary;
+        f64 *Distances = (f64 *)malloc((Pairs.Count + 1)*sizeof(f64));
+        if(Distances && OpenHaversineBinary(&Binary, BinaryFileName))
+        {
+            u64 ArrayByteCount = 4*Binary.Header->ArraySize;
+            u64 BinaryByteCount = Binary.Header->HeaderSize + ArrayByteCount;
+            
+            f64 JSONAverage = AverageHaversineDistance(Pairs, Distances);
+            f64 BinaryAverage = AverageHaversineDistance(Binary.Pairs, Distances);
+            
+            fprintf(stdout, "Pair count: %llu\n", Binary.Pairs.Count);
+            fprintf(stdout, "JSON size: %llu\n", InputJSON.Count);
+            fprintf(stdout, "Binary size: %llu\n", BinaryByteCount);
+            fprintf(stdout, "Checksum: %016llx\n", Binary.Header->Checksum);
+            fprintf(stdout, "JSON average: %.16f\n", JSONAverage);
+            fprintf(stdout, "Binary average: %.16f\n", BinaryAverage);
+            
+            if(!SamePairs(Pairs, Binary.Pairs) || (memcmp(&JSONAverage, &BinaryAverage, sizeof(f64)) != 0))
+            {
+                fprintf(stderr, "ERROR: \"%s\" does not match \"%s\".\n", BinaryFileName, JSONFileName);
+            }
+            else
+            {
+                Result = 0;
+            }
+            
+            if(SecondsToTry && (Result == 0))
+            {
+                u64 CPUTimerFreq = GetCPUTimerFreq();
+                
+                fprintf(stdout, "\n%-12s %12s %10s %8s\n", "Test", "Bytes", "ms", "GB/s");
+                
+                repetition_tester ParseTester = {};
+                NewTestWave(&ParseTester, InputJSON.Count, CPUTimerFreq, SecondsToTry);
+                ParseTester.PrintNewMinimums = false;
+                while(IsTesting(&ParseTester))
+                {
+                    BeginTime(&ParseTester);
+                    ParseHaversinePairs(InputJSON, &Pairs);
+                    EndTime(&ParseTester);
+                    CountBytes(&ParseTester, InputJSON.Count);
+                }
+                PrintTiming("json parse", &ParseTester, InputJSON.Count);
+                
+                repetition_tester OpenTester = {};
+                NewTestWave(&OpenTester, BinaryByteCount, CPUTimerFreq, SecondsToTry);
+                OpenTester.PrintNewMinimums = false;
+                while(IsTesting(&OpenTester))
+                {
+                    haversine_binary Reopened;
+                    BeginTime(&OpenTester);
+                    b32 Opened = OpenHaversineBinary(&Reopened, BinaryFileName);
+                    CloseHaversineBinary(&Reopened);
+                    EndTime(&OpenTester);
+                    CountBytes(&OpenTester, Opened ? BinaryByteCount : 0);
+                }
+                PrintTiming("binary open", &OpenTester, BinaryByteCount);
+                
+                u8 *Arrays = (u8 *)Binary.Pairs.X0;
+                
+                repetition_tester ChecksumTester = {};
+                NewTestWave(&ChecksumTester, ArrayByteCount, CPUTimerFreq, SecondsToTry);
+                ChecksumTester.PrintNewMinimums = false;
+                while(IsTesting(&ChecksumTester))
+                {
+                    BeginTime(&ChecksumTester);
+                    u64 Checksum = ChecksumHaversineArrays(Arrays, ArrayByteCount);
+                    EndTime(&ChecksumTester);
+                    CountBytes(&ChecksumTester, ArrayByteCount);
+                    
+                    if(Checksum != Binary.Header->Checksum)
+                    {
+                        Error(&ChecksumTester, "Checksum does not match the header");
+                        Result = 1;
+                    }
+                }
+                PrintTiming("checksum", &ChecksumTester, ArrayByteCount);
+                
+                // NOTE(agent): Every run has to come out the same as the first, which keeps the sums from being thrown away
+                u64 ExpectedSum = SumWords(Arrays, ArrayByteCount);
+                
+                repetition_tester SumTester = {};
+                NewTestWave(&SumTester, ArrayByteCount, CPUTimerFreq, SecondsToTry);
+                SumTester.PrintNewMinimums = false;
+                while(IsTesting(&SumTester))
+                {
+                    BeginTime(&SumTester);
+                    u64 Sum = SumWords(Arrays, ArrayByteCount);
+                    EndTime(&SumTester);
+                    CountBytes(&SumTester, ArrayByteCount);
+                    
+                    if(Sum != ExpectedSum)
+                    {
+                        Error(&SumTester, "Sum changed between runs");
+                        Result = 1;
+                    }
+                }
+                PrintTiming("sum", &SumTester, ArrayByteCount);
+            }
+            
+            CloseHaversineBinary(&Binary);
+        }
+        
+        free(Distances);
+    }
+    
+    FreePairs(&Pairs);
+    FreeBuffer(&InputJSON);
+    
+    return Result;
+}
+
+ProfilerEndOfCompilationUnit;
@@ -0,0 +1,419 @@
+/* NOTE(agent): Measures how much distance accuracy HaversineBatchF32 gives up compared to ReferenceHaversine, and
+   how much faster it is than HaversineBatch.
+   
+   Usage: haversine_f32_report [-seconds count] [-count pairs] [data_<count>_flex.json]
+   
+   The error table is over sets of -count generated pairs, each picked to stress a different part of the math:
+   
+   uniform:      Anywhere on the sphere, like haversine_generator's uniform mode.
+   short:        Anywhere, but the two points are within 0.01 degrees (about 1km) of each other.
+   north pole:   Both points within 0.5 degrees of the north pole, at any longitude.
+   south pole:   The same at the south pole.
+   antimeridian: Both points within 0.5 degrees of longitude 180, on either side of it, and within 0.5 degrees
+                 of latitude of each other.
+   antipodal:    The second point within 0.5 degrees of the opposite side of the earth from the first.
+   
+   If a JSON file is given, its pairs are one more set (parsed both with ParseHaversinePairs and with
+   ParseHaversinePairsF32), and both parses are timed too.
+   
+   For each set, the reference is ReferenceHaversine on the f64 coordinates. The columns are:
+   
+   f32 km:    The largest difference between HaversineBatchF32 (on the f32 coordinates) and the reference.
+   distance:  The reference distance of the pair that happened on.
+   relative:  The largest difference relative to the reference distance.
+   inputs km: The largest difference that just rounding the coordinates to f32 makes - ReferenceHaversine on the f32
+              coordinates, in f64. HaversineBatchF32 can't do better than this by much, since it never sees
+              anything more precise.
+   libm km:   The largest difference for ReferenceHaversine written in f32, with the CRT's f32 functions, to show
+              what the reductions in HaversineBatchF32 are buying.
+   avg km:    The difference between the average distance from HaversineBatchF32 and the reference average, which
+              is what haversine_processor reports.
+   
+   The reference has errors of its own, up to about 0.1m for antipodal pairs (where it has the same problem as
+   f32, just in 53 bits), so differences that small aren't meaningful.
+   
+   The throughput table is HaversineBatch and HaversineBatchF32 on the uniform set, for each instruction set the CPU
+   supports, in pairs per CPU timer tick (which may not be the same as core clocks, see platform_metrics.cpp). */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "profiler.cpp"
+#include "listing_0065_haversine_formula.cpp"
+#include "random_series.cpp"
+#include "os_memory.cpp"
+#include "arena.cpp"
+#include "haversine_json.cpp"
+#include "haversine_math.cpp"
+#include "haversine_batch.cpp"
+#include "haversine_batch_timing.cpp"
+
+enum pair_set
+{
+    PairSet_Uniform,
+    PairSet_Short,
+    PairSet_NorthPole,
+    PairSet_SouthPole,
+    PairSet_Antimeridian,
+    PairSet_Antipodal,
+    
+    PairSet_Count,
+};
+
+static char const *PairSetNames[PairSet_Count] =
+{
+    "uniform",
+    "short",
+    "north pole",
+    "south pole",
+    "antimeridian",
+    "antipodal",
+};
+
+struct f32_error
+{
+    f64 MaxError;
+    f64 MaxErrorDistance;
+    f64 MaxRelative;
+    f64 MaxInputError;
+    f64 MaxNaiveError;
+    f64 AverageError;
+};
+
+static f64 WrapLongitude(f64 X)
+{
+    f64 Result = (X > 180.0) ? (X - 360.0) : ((X < -180.0) ? (X + 360.0) : X);
+    return Result;
+}
+
+static f64 ClampLatitude(f64 Y)
+{
+    f64 Result = (Y > 90.0) ? 90.0 : ((Y < -90.0) ? -90.0 : Y);
+    return Result;
+}
+
+static void GeneratePairs(pair_set Set, haversine_pairs *Pairs, u64 Count)
+{
+    random_series Series = Seed(0x5eed0000 + Set);
+    
+    for(u64 Index = 0; Index < Count; ++Index)
+    {
+        f64 X0 = RandomInRange(&Series, -180.0, 180.0);
+        f64 Y0 = RandomInRange(&Series, -90.0, 90.0);
+        f64 X1 = RandomInRange(&Series, -180.0, 180.0);
+        f64 Y1 = RandomInRange(&Series, -90.0, 90.0);
+        
+        switch(Set)
+        {
+            case PairSet_Uniform: {} break;
+            
+            case PairSet_Short:
+            {
+                X1 = WrapLongitude(X0 + RandomInRange(&Series, -0.01, 0.01));
+                Y1 = ClampLatitude(Y0 + RandomInRange(&Series, -0.01, 0.01));
+            } break;
+            
+            case PairSet_NorthPole:
+            case PairSet_SouthPole:
+            {
+                f64 Sign = (Set == PairSet_NorthPole) ? 1.0 : -1.0;
+                Y0 = Sign*(90.0 - RandomInRange(&Series, 0.0, 0.5));
+                Y1 = Sign*(90.0 - RandomInRange(&Series, 0.0, 0.5));
+            } break;
+            
+            case PairSet_Antimeridian:
+            {
+                X0 = ((RandomU64(&Series) & 1) ? 1.0 : -1.0)*(180.0 - RandomInRange(&Series, 0.0, 0.5));
+                X1 = ((RandomU64(&Series) & 1) ? 1.0 : -1.0)*(180.0 - RandomInRange(&Series, 0.0, 0.5));
+                Y0 = RandomInRange(&Series, -80.0, 80.0);
+                Y1 = Y0 + RandomInRange(&Series, -0.5, 0.5);
+            } break;
+            
+            case PairSet_Antipodal:
+            {
+                X1 = WrapLongitude(X0 + 180.0 + RandomInRange(&Series, -0.5, 0.5));
+                Y1 = ClampLatitude(-Y0 + RandomInRange(&Series, -0.5, 0.5));
+            } break;
+            
+            default: {} break;
+        }
+        
+        Pairs->X0[Index] = X0;
+        Pairs->Y0[Index] = Y0;
+        Pairs->X1[Index] = X1;
+        Pairs->Y1[Index] = Y1;
+    }
+    
+    Pairs->Count = Count;
+}
+
+static void RoundPairsToF32(haversine_pairs *Pairs, haversine_pairs_f32 *PairsF32)
+{
+    for(u64 Index = 0; Index < Pairs->Count; ++Index)
+    {
+        PairsF32->X0[Index] = (f32)Pairs->X0[Index];
+        PairsF32->Y0[Index] = (f32)Pairs->Y0[Index];
+        PairsF32->X1[Index] = (f32)Pairs->X1[Index];
+        PairsF32->Y1[Index] = (f32)Pairs->Y1[Index];
+    }
+    
+    PairsF32->Count = Pairs->Count;
+}
+
+static f32 NaiveHaversineF32(f32 X0, f32 Y0, f32 X1, f32 Y1, f32 EarthRadius)
+{
+    // NOTE(agent): ReferenceHaversine with every f64 made an f32. a is clamped to 1, since in f32 it regularly
+    // rounds past it for antipodal pairs, and asinf of more than 1 is NaN.
+    f32 RadiansPerDegree = (f32)RADIANS_PER_DEGREE;
+    f32 dLat = RadiansPerDegree*(Y1 - Y0);
+    f32 dLon = RadiansPerDegree*(X1 - X0);
+    f32 lat1 = RadiansPerDegree*Y0;
+    f32 lat2 = RadiansPerDegree*Y1;
+    
+    f32 SinHalfDLat = sinf(dLat/2.0f);
+    f32 SinHalfDLon = sinf(dLon/2.0f);
+    f32 a = SinHalfDLat*SinHalfDLat + cosf(lat1)*cosf(lat2)*SinHalfDLon*SinHalfDLon;
+    f32 c = 2.0f*asinf(sqrtf(fminf(a, 1.0f)));
+    
+    f32 Result = EarthRadius*c;
+    return Result;
+}
+
+static f32_error MeasureF32Error(haversine_pairs Pairs, haversine_pairs_f32 PairsF32, f64 *Reference, f32 *Distances)
+{
+    f32_error Result = {};
+    
+    HaversineBatchReference(Pairs.Count, Pairs.X0, Pairs.Y0, Pairs.X1, Pairs.Y1, Reference);
+    HaversineBatchF32(PairsF32.Count, PairsF32.X0, PairsF32.Y0, PairsF32.X1, PairsF32.Y1, Distances);
+    
+    f64 ReferenceSum = 0;
+    f64 F32Sum = 0;
+    for(u64 Index = 0; Index < Pairs.Count; ++Index)
+    {
+        f64 Expected = Reference[Index];
+        f64 Error = fabs((f64)Distances[Index] - Expected);
+        if(Result.MaxError < Error)
+        {
+            Result.MaxError = Error;
+            Result.MaxErrorDistance = Expected;
+        }
+        
+        if(Expected > 0)
+        {
+            f64 Relative = Error / Expected;
+            Result.MaxRelative = (Result.MaxRelative < Relative) ? Relative : Result.MaxRelative;
+        }
+        
+        f32 X0 = PairsF32.X0[Index];
+        f32 Y0 = PairsF32.Y0[Index];
+        f32 X1 = PairsF32.X1[Index];
+        f32 Y1 = PairsF32.Y1[Index];
+        
+        f64 InputError = fabs(ReferenceHaversine(X0, Y0, X1, Y1, EARTH_RADIUS) - Expected);
+        Result.MaxInputError = (Result.MaxInputError < InputError) ? InputError : Result.MaxInputError;
+        
+        f64 NaiveError = fabs((f64)NaiveHaversineF32(X0, Y0, X1, Y1, (f32)EARTH_RADIUS) - Expected);
+        Result.MaxNaiveError = (Result.MaxNaiveError < NaiveError) ? NaiveError : Result.MaxNaiveError;
+        
+        ReferenceSum += Expected;
+        F32Sum += Distances[Index];
+    }
+    
+    if(Pairs.Count)
+    {
+        Result.AverageError = fabs(F32Sum - ReferenceSum) / (f64)Pairs.Count;
+    }
+    
+    return Result;
+}
+
+static void PrintF32Error(char const *Name, f32_error Error)
+{
+    fprintf(stdout, "%-13s %10.6f %10.3f %10.3e %10.6f %10.6f %12.3e\n", Name,
+            Error.MaxError, Error.MaxErrorDistance, Error.MaxRelative,
+            Error.MaxInputError, Error.MaxNaiveError, Error.AverageError);
+}
+
+static f64 TimeBatchF32(haversine_batch_f32_function *Function, haversine_pairs_f32 Pairs, f32 *Out, u32 SecondsToTry)
+{
+    u64 ByteCount = Pairs.Count*4*sizeof(f32);
+    
+    repetition_tester Tester = {};
+    NewTestWave(&Tester, ByteCount, GetCPUTimerFreq(), SecondsToTry);
+    Tester.PrintNewMinimums = false;
+    while(IsTesting(&Tester))
+    {
+        BeginTime(&Tester);
+        Function(Pairs.Count, Pairs.X0, Pairs.Y0, Pairs.X1, Pairs.Y1, Out);
+        EndTime(&Tester);
+        CountBytes(&Tester, ByteCount);
+    }
+    
+    f64 Result = (f64)Pairs.Count / (f64)Tester.Results.Min.E[RepValue_CPUTimer];
+    return Result;
+}
+
+static b32 ReportJSON(char *JSONFileName, u32 SecondsToTry)
+{
+    b32 Result = false;
+    
+    buffer InputJSON = ReadEntireFile(JSONFileName);
+    u64 MaxPairCount = GetMaxPairCount(InputJSON.Count);
+    haversine_pairs Pairs = AllocatePairs(MaxPairCount);
+    haversine_pairs_f32 PairsF32 = AllocatePairsF32(MaxPairCount);
+    if(InputJSON.Data && Pairs.Memory.Data && PairsF32.Memory.Data &&
+       ParseHaversinePairs(InputJSON, &Pairs) && ParseHaversinePairsF32(InputJSON, &PairsF32))
+    {
+        f64 *Reference = (f64 *)malloc((Pairs.Count + 1)*sizeof(f64));
+        f32 *Distances = (f32 *)malloc((Pairs.Count + 1)*sizeof(f32));
+        if(Reference && Distances && (Pairs.Count == PairsF32.Count))
+        {
+            PrintF32Error("json", MeasureF32Error(Pairs, PairsF32, Reference, Distances));
+            
+            if(SecondsToTry)
+            {
+                f64 Seconds[2];
+                for(u32 Precision = 0; Precision < 2; ++Precision)
+                {
+                    repetition_tester Tester = {};
+                    NewTestWave(&Tester, InputJSON.Count, GetCPUTimerFreq(), SecondsToTry);
+                    Tester.PrintNewMinimums = false;
+                    while(IsTesting(&Tester))
+                    {
+                        BeginTime(&Tester);
+                        b32 Parsed = Precision ? ParseHaversinePairsF32(InputJSON, &PairsF32) : ParseHaversinePairs(InputJSON, &Pairs);
+                        EndTime(&Tester);
+                        CountBytes(&Tester, Parsed ? InputJSON.Count : 0);
+                    }
+                    
+                    Seconds[Precision] = SecondsFromCPUTime((f64)Tester.Results.Min.E[RepValue_CPUTimer], Tester.CPUTimerFreq);
+                }
+                
+                fprintf(stdout, "\nJSON parse: %.3fms (f64), %.3fms (f32)\n", 1000.0*Seconds[0], 1000.0*Seconds[1]);
+            }
+            
+            Result = true;
+        }
+        else if(Reference && Distances)
+        {
+            fprintf(stderr, "ERROR: The f32 parse of \"%s\" found %llu pairs, but the f64 parse found %llu.\n",
+                    JSONFileName, PairsF32.Count, Pairs.Count);
+        }
+        else
+        {
+            fprintf(stderr, "ERROR: Unable to allocate space for the distances.\n");
+        }
+        
+        free(Reference);
+        free(Distances);
+    }
+    
+    FreePairsF32(&PairsF32);
+    FreePairs(&Pairs);
+    FreeBuffer(&InputJSON);
+    
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    InitHaversineBatch();
+    
+    u32 SecondsToTry = 3;
+    u64 PairCount = 1000000;
+    char *JSONFileName = 0;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else if(HasValue && (strcmp(Arg, "-count") == 0))
+        {
+            PairCount = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(!JSONFileName)
+        {
+            JSONFileName = Arg;
+        }
+        else
+        {
+            PairCount = 0;
+            break;
+        }
+    }
+    
+    if(!PairCount)
+    {
+        fprintf(stderr, "USAGE: %s [-seconds count] [-count pairs] [haversine_input.json]\n", Args[0]);
+        return 1;
+    }
+    
+    int Result = 1;
+    
+    haversine_pairs Pairs = AllocatePairs(PairCount);
+    haversine_pairs_f32 PairsF32 = AllocatePairsF32(PairCount);
+    f64 *Reference = (f64 *)malloc(PairCount*sizeof(f64));
+    f32 *Distances = (f32 *)malloc(PairCount*sizeof(f32));
+    if(Pairs.Memory.Data && PairsF32.Memory.Data && Reference && Distances)
+    {
+        fprintf(stdout, "Pair count: %llu\n\n", PairCount);
+        fprintf(stdout, "%-13s %10s %10s %10s %10s %10s %12s\n",
+                "Set", "f32 km", "distance", "relative", "inputs km", "libm km", "avg km");
+        
+        for(u32 Set = 0; Set < PairSet_Count; ++Set)
+        {
+            GeneratePairs((pair_set)Set, &Pairs, PairCount);
+            RoundPairsToF32(&Pairs, &PairsF32);
+            PrintF32Error(PairSetNames[Set], MeasureF32Error(Pairs, PairsF32, Reference, Distances));
+        }
+        
+        Result = 0;
+        if(JSONFileName && !ReportJSON(JSONFileName, SecondsToTry))
+        {
+            Result = 1;
+        }
+        
+        if(SecondsToTry)
+        {
+            GeneratePairs(PairSet_Uniform, &Pairs, PairCount);
+            RoundPairsToF32(&Pairs, &PairsF32);
+            
+            // NOTE(agent): The f64 results need somewhere to go too, and Reference isn't needed anymore
+            f64 *Distances64 = Reference;
+            
+            fprintf(stdout, "\n%-10s %12s %12s %8s\n", "Kernel", "f64/tick", "f32/tick", "x");
+            
+            haversine_isa SupportedISA = GetHaversineISA();
+            for(u32 ISA = 0; ISA <= (u32)SupportedISA; ++ISA)
+            {
+                f64 PairsPerTick = TimeBatch(HaversineBatchFunctions[ISA], Pairs, Distances64, SecondsToTry);
+                f64 PairsPerTickF32 = TimeBatchF32(HaversineBatchF32Functions[ISA], PairsF32, Distances, SecondsToTry);
+                fprintf(stdout, "%-10s %12.4f %12.4f %8.2f\n", HaversineISANames[ISA],
+                        PairsPerTick, PairsPerTickF32, PairsPerTickF32 / PairsPerTick);
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate space for %llu pairs.\n", PairCount);
+    }
+    
+    free(Reference);
+    free(Distances);
+    FreePairsF32(&PairsF32);
+    FreePairs(&Pairs);
+    
+    return Result;
+}
+
+ProfilerEndOfCompilationUnit;
@@ -0,0 +1,160 @@
+/* NOTE(agent): Generates input for the haversine homework. Usage:
+
+   haversine_generator [uniform/cluster] [random seed] [number of coordinate pairs to generate]
+   
+   This writes two files:
+   
+   data_<count>_flex.json - The pairs, as {"pairs":[{"x0":...,"y0":...,"x1":...,"y1":...}, ...]}
+   data_<count>_haveranswer.f64 - The ReferenceHaversine distance for each pair, in the same order, as raw f64s,
+                                  followed by one more f64 that is the expected average of all of them.
+   
+   Uniform mode picks every coordinate from the whole globe. That makes the distances average out to about the
+   same number no matter how many pairs there are, which makes it hard to tell whether a sum is actually right,
+   so cluster mode instead picks a random region of the globe for every batch of pairs, and all the points in
+   the batch come from that region.
+   
+   Everything is written as it is generated, through the C runtime's file buffering, so memory use doesn't depend
+   on the pair count at all. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "random_series.cpp"
+#include "listing_0065_haversine_formula.cpp"
+
+#define EARTH_RADIUS 6372.8
+
+static f64 RandomDegree(random_series *Series, f64 Center, f64 Radius, f64 MaxAllowed)
+{
+    f64 MinVal = Center - Radius;
+    if(MinVal < -MaxAllowed)
+    {
+        MinVal = -MaxAllowed;
+    }
+    
+    f64 MaxVal = Center + Radius;
+    if(MaxVal > MaxAllowed)
+    {
+        MaxVal = MaxAllowed;
+    }
+    
+    f64 Result = RandomInRange(Series, MinVal, MaxVal);
+    return Result;
+}
+
+static FILE *Open(u64 PairCount, char const *Label, char const *Extension)
+{
+    char Temp[256];
+    sprintf(Temp, "data_%llu_%s.%s", PairCount, Label, Extension);
+    FILE *Result = fopen(Temp, "wb");
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Unable to open \"%s\" for writing.\n", Temp);
+    }
+    
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    if(ArgCount != 4)
+    {
+        fprintf(stderr, "USAGE: %s [uniform/cluster] [random seed] [number of coordinate pairs to generate]\n", Args[0]);
+        return 1;
+    }
+    
+    u64 ClusterCountLeft = (u64)-1;
+    f64 MaxAllowedX = 180;
+    f64 MaxAllowedY = 90;
+    
+    f64 XCenter = 0;
+    f64 YCenter = 0;
+    f64 XRadius = MaxAllowedX;
+    f64 YRadius = MaxAllowedY;
+    
+    char const *MethodName = Args[1];
+    if(strcmp(MethodName, "cluster") == 0)
+    {
+        ClusterCountLeft = 0;
+    }
+    else if(strcmp(MethodName, "uniform") != 0)
+    {
+        MethodName = "uniform";
+        fprintf(stderr, "WARNING: Unrecognized method name. Using 'uniform'.\n");
+    }
+    
+    u64 SeedValue = strtoull(Args[2], 0, 10);
+    random_series Series = Seed(SeedValue);
+    
+    u64 MaxPairCount = (1ULL << 34);
+    u64 PairCount = strtoull(Args[3], 0, 10);
+    if(PairCount >= MaxPairCount)
+    {
+        fprintf(stderr, "ERROR: To avoid accidentally generating massive files, number of pairs must be less than %llu.\n", MaxPairCount);
+        return 1;
+    }
+    
+    FILE *FlexJSON = Open(PairCount, "flex", "json");
+    FILE *HaverAnswers = Open(PairCount, "haveranswer", "f64");
+    if(!FlexJSON || !HaverAnswers)
+    {
+        return 1;
+    }
+    
+    // NOTE(agent): Bigger than the default, so the many small writes below go out to the OS in big blocks
+    setvbuf(FlexJSON, 0, _IOFBF, 1024*1024);
+    setvbuf(HaverAnswers, 0, _IOFBF, 1024*1024);
+    
+    u64 ClusterCountMax = 1 + (PairCount / 64);
+    f64 Sum = 0;
+    f64 SumCoef = 1.0 / (f64)PairCount;
+    
+    fprintf(FlexJSON, "{\"pairs\":[\n");
+    for(u64 PairIndex = 0; PairIndex < PairCount; ++PairIndex)
+    {
+        if(ClusterCountLeft-- == 0)
+        {
+            ClusterCountLeft = ClusterCountMax;
+            XCenter = RandomInRange(&Series, -MaxAllowedX, MaxAllowedX);
+            YCenter = RandomInRange(&Series, -MaxAllowedY, MaxAllowedY);
+            XRadius = RandomInRange(&Series, 0, MaxAllowedX);
+            YRadius = RandomInRange(&Series, 0, MaxAllowedY);
+        }
+        
+        f64 X0 = RandomDegree(&Series, XCenter, XRadius, MaxAllowedX);
+        f64 Y0 = RandomDegree(&Series, YCenter, YRadius, MaxAllowedY);
+        f64 X1 = RandomDegree(&Series, XCenter, XRadius, MaxAllowedX);
+        f64 Y1 = RandomDegree(&Series, YCenter, YRadius, MaxAllowedY);
+        
+        f64 HaversineDistance = ReferenceHaversine(X0, Y0, X1, Y1, EARTH_RADIUS);
+        Sum += SumCoef*HaversineDistance;
+        
+        char const *JSONSep = (PairIndex == (PairCount - 1)) ? "\n" : ",\n";
+        fprintf(FlexJSON, "    {\"x0\":%.16f, \"y0\":%.16f, \"x1\":%.16f, \"y1\":%.16f}%s", X0, Y0, X1, Y1, JSONSep);
+        
+        fwrite(&HaversineDistance, sizeof(HaversineDistance), 1, HaverAnswers);
+    }
+    fprintf(FlexJSON, "]}\n");
+    fwrite(&Sum, sizeof(Sum), 1, HaverAnswers);
+    
+    b32 WriteError = (ferror(FlexJSON) || ferror(HaverAnswers));
+    WriteError |= (fclose(FlexJSON) != 0);
+    WriteError |= (fclose(HaverAnswers) != 0);
+    if(WriteError)
+    {
+        fprintf(stderr, "ERROR: Unable to write all of the output (is the disk full?)\n");
+        return 1;
+    }
+    
+    fprintf(stdout, "Method: %s\n", MethodName);
+    fprintf(stdout, "Random seed: %llu\n", SeedValue);
+    fprintf(stdout, "Pair count: %llu\n", PairCount);
+    fprintf(stdout, "Expected average: %.16f\n", Sum);
+    
+    return 0;
+}
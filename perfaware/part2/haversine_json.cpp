@@ -0,0 +1,1011 @@
+/* NOTE(agent): A JSON reader that only reads one thing: the {"pairs":[{"x0":...,"y0":...,"x1":...,"y1":...}, ...]}
+   files made by haversine_generator. Because it knows exactly what it is reading, it never builds a tree and never
+   allocates anything per value - the numbers go straight into the x0/y0/x1/y1 arrays of a haversine_pairs.
+   Whitespace can be anywhere JSON allows it, and the four keys can be in any order, but anything else (other
+   keys, nested values, strings as values) is reported as an error.
+   
+   It works in two layers:
+   
+   1) The structural scan looks at 64 bytes at a time with SSE2, and makes a 64-bit mask of where the quotes and
+      the : , { } [ ] characters are. Any of those inside a string are masked out by working out which bytes
+      are between quotes (a "prefix xor" of the quote mask), so a key can't trip up the parser. Escapes are not
+      handled, but since the only keys allowed are x0/y0/x1/y1, any key with an escape in it is an error anyway.
+   
+   2) The parser walks the structural characters in order, checking that everything between them is either
+      whitespace, a key, or a number, as the grammar requires.
+   
+   Numbers are parsed exactly: the digits go into a 64-bit integer, the power of ten is applied with a single
+   64x64->128 multiply or 128/64 divide, and the result is rounded once to the nearest f64 (ties to even). That is
+   the correctly rounded result - the same thing strtod produces - for any number with 19 or fewer significant
+   digits and a power of ten between 10^-19 and 10^19, which covers everything the generator writes. Anything
+   else falls back to strtod. A number too big for an f64 (1e400, say) is an error, not an infinity.
+   
+   ReadEntireFile is here too, since everything that parses a file has to read it first. It times the read with
+   profiler.cpp, so that has to be included before this. */
+
+#include <math.h>
+#include <sys/stat.h>
+#include <emmintrin.h>
+
+// NOTE(agent): The answers file has the distances to 16 decimal places of input, so they won't match to the last bit
+#define MAX_DISTANCE_ERROR 1e-6
+
+struct buffer
+{
+    u64 Count;
+    u8 *Data;
+};
+
+struct haversine_pairs
+{
+    u64 Count;
+    u64 MaxCount;
+    
+    f64 *X0;
+    f64 *Y0;
+    f64 *X1;
+    f64 *Y1;
+    
+    os_memory Memory;
+};
+
+struct haversine_pairs_f32
+{
+    u64 Count;
+    u64 MaxCount;
+    
+    f32 *X0;
+    f32 *Y0;
+    f32 *X1;
+    f32 *Y1;
+    
+    os_memory Memory;
+};
+
+static buffer AllocateBuffer(u64 Count)
+{
+    buffer Result = {};
+    Result.Data = (u8 *)malloc(Count);
+    if(Result.Data)
+    {
+        Result.Count = Count;
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate %llu bytes.\n", Count);
+    }
+    
+    return Result;
+}
+
+static void FreeBuffer(buffer *Buffer)
+{
+    if(Buffer->Data)
+    {
+        free(Buffer->Data);
+    }
+    *Buffer = {};
+}
+
+static u64 GetMaxPairCount(u64 JSONByteCount)
+{
+    // NOTE(agent): The smallest a pair can be is {"x0":0,"y0":0,"x1":0,"y1":0} - 29 bytes - plus a comma
+    u64 MinPairByteCount = 30;
+    u64 Result = (JSONByteCount / MinPairByteCount) + 1;
+    return Result;
+}
+
+static u64 GetPairArraySize(u64 MaxCount, u64 ElementSize)
+{
+    u64 Result = ((MaxCount*ElementSize) + 63) & ~63ull;
+    return Result;
+}
+
+static os_memory AllocatePairArrays(u64 MaxCount, u64 ElementSize, memory_policy Policy, u8 **Arrays)
+{
+    /* NOTE(agent): All four arrays come from one allocation (see os_memory.cpp), each starting on its own cache
+       line. MaxCount is usually a generous upper bound (see GetMaxPairCount). With the lazy policy, the OS doesn't
+       actually give a program pages it has never touched, so the unused part at the end of each array costs
+       address space, not memory - but the other policies fault in all of it up front. */
+    u64 ArraySize = GetPairArraySize(MaxCount, ElementSize);
+    os_memory Result = AllocateOSMemory(4*ArraySize, Policy);
+    if(Result.Data)
+    {
+        for(u32 ArrayIndex = 0; ArrayIndex < 4; ++ArrayIndex)
+        {
+            Arrays[ArrayIndex] = Result.Data + ArrayIndex*ArraySize;
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate space for %llu pairs.\n", MaxCount);
+    }
+    
+    return Result;
+}
+
+static haversine_pairs AllocatePairs(u64 MaxCount, memory_policy Policy = GetDefaultMemoryPolicy())
+{
+    haversine_pairs Result = {};
+    
+    u8 *Arrays[4];
+    Result.Memory = AllocatePairArrays(MaxCount, sizeof(f64), Policy, Arrays);
+    if(Result.Memory.Data)
+    {
+        Result.MaxCount = MaxCount;
+        Result.X0 = (f64 *)Arrays[0];
+        Result.Y0 = (f64 *)Arrays[1];
+        Result.X1 = (f64 *)Arrays[2];
+        Result.Y1 = (f64 *)Arrays[3];
+    }
+    
+    return Result;
+}
+
+static haversine_pairs_f32 AllocatePairsF32(u64 MaxCount, memory_policy Policy = GetDefaultMemoryPolicy())
+{
+    haversine_pairs_f32 Result = {};
+    
+    u8 *Arrays[4];
+    Result.Memory = AllocatePairArrays(MaxCount, sizeof(f32), Policy, Arrays);
+    if(Result.Memory.Data)
+    {
+        Result.MaxCount = MaxCount;
+        Result.X0 = (f32 *)Arrays[0];
+        Result.Y0 = (f32 *)Arrays[1];
+        Result.X1 = (f32 *)Arrays[2];
+        Result.Y1 = (f32 *)Arrays[3];
+    }
+    
+    return Result;
+}
+
+static buffer PushBuffer(arena *Arena, u64 Count)
+{
+    buffer Result = {};
+    Result.Data = (u8 *)PushSize(Arena, Count, 64);
+    if(Result.Data)
+    {
+        Result.Count = Count;
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate %llu bytes.\n", Count);
+    }
+    
+    return Result;
+}
+
+static haversine_pairs PushPairs(arena *Arena, u64 MaxCount)
+{
+    /* NOTE(agent): The same four arrays as AllocatePairs, out of an arena. Their Memory is left empty, since they
+       go away when the arena is popped, not with FreePairs. Check X0 to see if they were allocated. Pushing
+       them in a fresh block (see arena.cpp) keeps the lazy-page behavior of AllocatePairs, but a reused block
+       has already had its pages faulted in. */
+    haversine_pairs Result = {};
+    
+    u64 ArraySize = GetPairArraySize(MaxCount, sizeof(f64));
+    u8 *Data = (u8 *)PushSize(Arena, 4*ArraySize, 64);
+    if(Data)
+    {
+        Result.MaxCount = MaxCount;
+        Result.X0 = (f64 *)(Data + 0*ArraySize);
+        Result.Y0 = (f64 *)(Data + 1*ArraySize);
+        Result.X1 = (f64 *)(Data + 2*ArraySize);
+        Result.Y1 = (f64 *)(Data + 3*ArraySize);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate space for %llu pairs.\n", MaxCount);
+    }
+    
+    return Result;
+}
+
+static void FreePairs(haversine_pairs *Pairs)
+{
+    FreeOSMemory(&Pairs->Memory);
+    *Pairs = {};
+}
+
+static void FreePairsF32(haversine_pairs_f32 *Pairs)
+{
+    FreeOSMemory(&Pairs->Memory);
+    *Pairs = {};
+}
+
+//
+// NOTE(agent): File reading
+//
+
+static b32 GetFileSize(char *FileName, u64 *Size)
+{
+#if _WIN32
+    struct __stat64 Stat;
+    b32 Result = (_stat64(FileName, &Stat) == 0);
+#else
+    struct stat Stat;
+    b32 Result = (stat(FileName, &Stat) == 0);
+#endif
+
+    *Size = Result ? (u64)Stat.st_size : 0;
+    if(!Result)
+    {
+        fprintf(stderr, "ERROR: Unable to get the size of \"%s\".\n", FileName);
+    }
+    
+    return Result;
+}
+
+static buffer ReadEntireFile(arena *Arena, char *FileName)
+{
+    // NOTE(agent): The buffer is pushed on Arena, or if there isn't one, comes from AllocateBuffer and has to be
+    // given back with FreeBuffer
+    buffer Result = {};
+    
+    u64 Size = 0;
+    FILE *File = fopen(FileName, "rb");
+    if(!File)
+    {
+        fprintf(stderr, "ERROR: Unable to open \"%s\".\n", FileName);
+    }
+    else if(GetFileSize(FileName, &Size))
+    {
+        // NOTE(agent): The whole file is one read, straight into place, so the FILE doesn't need a buffer of its own
+        setvbuf(File, 0, _IONBF, 0);
+        
+        Result = Arena ? PushBuffer(Arena, Size) : AllocateBuffer(Size);
+        if(Result.Data)
+        {
+            TimeBandwidth("fread", Result.Count);
+            if(fread(Result.Data, Result.Count, 1, File) != 1)
+            {
+                fprintf(stderr, "ERROR: Unable to read \"%s\".\n", FileName);
+                if(Arena)
+                {
+                    Result = {};
+                }
+                else
+                {
+                    FreeBuffer(&Result);
+                }
+            }
+        }
+    }
+    
+    if(File)
+    {
+        fclose(File);
+    }
+    
+    return Result;
+}
+
+static buffer ReadEntireFile(char *FileName)
+{
+    buffer Result = ReadEntireFile(0, FileName);
+    return Result;
+}
+
+//
+// NOTE(agent): Structural scan
+//
+
+struct json_scanner
+{
+    u8 *Data;
+    u64 Size;
+    
+    u64 BlockAt; // NOTE(agent): Offset of the 64-byte block Mask came from
+    u64 Mask; // NOTE(agent): Structural characters in that block that haven't been returned yet
+    u64 InStringCarry; // NOTE(agent): All ones if the block before this one ended inside a string
+};
+
+inline u32 CountTrailingZeros64(u64 Value)
+{
+#if _MSC_VER
+    unsigned long Index;
+    _BitScanForward64(&Index, Value);
+    u32 Result = Index;
+#else
+    u32 Result = __builtin_ctzll(Value);
+#endif
+    return Result;
+}
+
+inline u32 CountLeadingZeros64(u64 Value)
+{
+#if _MSC_VER
+    unsigned long Index;
+    _BitScanReverse64(&Index, Value);
+    u32 Result = 63 - Index;
+#else
+    u32 Result = __builtin_clzll(Value);
+#endif
+    return Result;
+}
+
+static u64 GetStructuralMask(u8 *Block, u64 *InStringCarry)
+{
+    __m128i Quote = _mm_set1_epi8('"');
+    __m128i Colon = _mm_set1_epi8(':');
+    __m128i Comma = _mm_set1_epi8(',');
+    __m128i OpenBrace = _mm_set1_epi8('{');
+    __m128i CloseBrace = _mm_set1_epi8('}');
+    __m128i CaseBit = _mm_set1_epi8(0x20);
+    
+    u64 Quotes = 0;
+    u64 Operators = 0;
+    for(u32 Part = 0; Part < 4; ++Part)
+    {
+        __m128i Chars = _mm_loadu_si128((__m128i *)(Block + 16*Part));
+        
+        // NOTE(agent): [ and ] are { and } without the 0x20 bit, so one compare against the "lowercased" byte finds both
+        __m128i Lowered = _mm_or_si128(Chars, CaseBit);
+        __m128i IsOperator = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Chars, Colon), _mm_cmpeq_epi8(Chars, Comma)),
+                                          _mm_or_si128(_mm_cmpeq_epi8(Lowered, OpenBrace), _mm_cmpeq_epi8(Lowered, CloseBrace)));
+        
+        Quotes |= (u64)(u16)_mm_movemask_epi8(_mm_cmpeq_epi8(Chars, Quote)) << (16*Part);
+        Operators |= (u64)(u16)_mm_movemask_epi8(IsOperator) << (16*Part);
+    }
+    
+    // NOTE(agent): After the prefix xor, each bit is set if there are an odd number of quotes at or before it - ie.,
+    // it is inside a string (counting the opening quote, but not the closing one)
+    u64 InString = Quotes;
+    InString ^= InString << 1;
+    InString ^= InString << 2;
+    InString ^= InString << 4;
+    InString ^= InString << 8;
+    InString ^= InString << 16;
+    InString ^= InString << 32;
+    InString ^= *InStringCarry;
+    
+    *InStringCarry = (InString >> 63) ? ~0ull : 0;
+    
+    u64 Result = (Operators & ~InString) | Quotes;
+    return Result;
+}
+
+static json_scanner BeginScan(buffer Source)
+{
+    json_scanner Result = {};
+    Result.Data = Source.Data;
+    Result.Size = Source.Count;
+    Result.BlockAt = (u64)-64;
+    return Result;
+}
+
+static u64 NextStructural(json_scanner *Scanner)
+{
+    // NOTE(agent): Returns the offset of the next structural character, or Size if there are no more
+    while(!Scanner->Mask)
+    {
+        Scanner->BlockAt += 64;
+        if(Scanner->BlockAt >= Scanner->Size)
+        {
+            Scanner->BlockAt = Scanner->Size;
+            return Scanner->Size;
+        }
+        
+        u8 *Block = Scanner->Data + Scanner->BlockAt;
+        u64 Remaining = Scanner->Size - Scanner->BlockAt;
+        
+        u8 Tail[64];
+        if(Remaining < 64)
+        {
+            // NOTE(agent): The last partial block is padded out with spaces, so nothing is read past the end
+            memset(Tail, ' ', sizeof(Tail));
+            memcpy(Tail, Block, Remaining);
+            Block = Tail;
+        }
+        
+        Scanner->Mask = GetStructuralMask(Block, &Scanner->InStringCarry);
+    }
+    
+    u64 Result = Scanner->BlockAt + CountTrailingZeros64(Scanner->Mask);
+    Scanner->Mask &= Scanner->Mask - 1;
+    
+    return Result;
+}
+
+//
+// NOTE(agent): Number parsing
+//
+
+static u64 const PowersOfTen[20] =
+{
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+    10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+    10000000000000000000ull,
+};
+
+inline u64 Multiply64To128(u64 A, u64 B, u64 *High)
+{
+#if _MSC_VER
+    u64 Result = _umul128(A, B, High);
+#else
+    unsigned __int128 Product = (unsigned __int128)A * B;
+    *High = (u64)(Product >> 64);
+    u64 Result = (u64)Product;
+#endif
+    return Result;
+}
+
+inline u64 Divide128By64(u64 High, u64 Low, u64 Divisor, u64 *Remainder)
+{
+    // NOTE(agent): High must be less than Divisor, so the quotient fits in 64 bits and this is a single divide instruction
+#if _MSC_VER
+    u64 Result = _udiv128(High, Low, Divisor, Remainder);
+#else
+    u64 Result;
+    __asm__("divq %[Divisor]" : "=a" (Result), "=d" (*Remainder) : [Divisor] "rm" (Divisor), "a" (Low), "d" (High));
+#endif
+    return Result;
+}
+
+static f64 RoundToF64(u64 Bits, b32 Sticky, s32 BinaryExponent)
+{
+    /* NOTE(agent): Returns (Bits + a little more if Sticky) * 2^BinaryExponent, rounded to the nearest f64. The top
+       bit of Bits must be set, and the result must be a normal number, both of which are guaranteed by how
+       ComposeF64 calls it. */
+    u64 Mantissa = Bits >> 11;
+    u64 Rem = Bits & 0x7ff;
+    u64 Half = 0x400;
+    
+    s32 Exponent = BinaryExponent + 11;
+    if((Rem > Half) || ((Rem == Half) && (Sticky || (Mantissa & 1))))
+    {
+        ++Mantissa;
+        if(Mantissa == (1ull << 53))
+        {
+            Mantissa >>= 1;
+            ++Exponent;
+        }
+    }
+    
+    u64 BiasedExponent = (u64)(Exponent + 52 + 1023);
+    u64 F64Bits = (BiasedExponent << 52) | (Mantissa & ((1ull << 52) - 1));
+    
+    f64 Result;
+    memcpy(&Result, &F64Bits, sizeof(Result));
+    return Result;
+}
+
+static f64 ComposeF64(u64 Digits, s32 Exponent10)
+{
+    // NOTE(agent): Digits * 10^Exponent10, for nonzero Digits and -19 <= Exponent10 <= 19
+    f64 Result;
+    if(Exponent10 >= 0)
+    {
+        // NOTE(agent): The product is exact, so it just has to be cut down to its top 64 bits
+        u64 High;
+        u64 Low = Multiply64To128(Digits, PowersOfTen[Exponent10], &High);
+        if(High)
+        {
+            u32 Shift = CountLeadingZeros64(High);
+            u64 Bits = Shift ? ((High << Shift) | (Low >> (64 - Shift))) : High;
+            Result = RoundToF64(Bits, (Low << Shift) != 0, 64 - (s32)Shift);
+        }
+        else
+        {
+            u32 Shift = CountLeadingZeros64(Low);
+            Result = RoundToF64(Low << Shift, false, -(s32)Shift);
+        }
+    }
+    else
+    {
+        /* NOTE(agent): Both numbers are shifted up so their top bits are set, and then the numerator is shifted up
+           another 63 or 64 bits, whichever makes the quotient exactly 64 bits. The remainder says whether anything
+           was cut off below that. */
+        u32 DigitShift = CountLeadingZeros64(Digits);
+        u64 Numerator = Digits << DigitShift;
+        
+        u64 Denominator = PowersOfTen[-Exponent10];
+        u32 DenominatorShift = CountLeadingZeros64(Denominator);
+        Denominator <<= DenominatorShift;
+        
+        u64 Remainder;
+        u64 Quotient;
+        s32 Extra;
+        if(Numerator < Denominator)
+        {
+            Quotient = Divide128By64(Numerator, 0, Denominator, &Remainder);
+            Extra = 64;
+        }
+        else
+        {
+            Quotient = Divide128By64(Numerator >> 1, Numerator << 63, Denominator, &Remainder);
+            Extra = 63;
+        }
+        
+        Result = RoundToF64(Quotient, (Remainder != 0), (s32)DenominatorShift - (s32)DigitShift - Extra);
+    }
+    
+    return Result;
+}
+
+inline b32 IsDigit(u8 C)
+{
+    b32 Result = ((C >= '0') && (C <= '9'));
+    return Result;
+}
+
+inline b32 IsJSONWhitespace(u8 C)
+{
+    b32 Result = ((C == ' ') || (C == '\n') || (C == '\r') || (C == '\t'));
+    return Result;
+}
+
+static b32 IsWhitespaceSpan(u8 *At, u8 *End)
+{
+    while((At < End) && IsJSONWhitespace(*At))
+    {
+        ++At;
+    }
+    
+    b32 Result = (At == End);
+    return Result;
+}
+
+inline u8 *ParseDigitRun(u8 *At, u8 *End, u64 *Digits, u32 *DigitCount)
+{
+    /* NOTE(agent): Adds the run of digits at At onto the end of *Digits, and returns where the run stopped. As long
+       as there is room to load 8 bytes before End, it does 8 digits at a time with integer math (a "SWAR" parse),
+       which avoids the unpredictable branch on every digit. Only the first 19 digits can fit in a u64, so it stops
+       accumulating after that, but *DigitCount still counts them all so the caller can tell. */
+    u64 Value = *Digits;
+    u32 Count = *DigitCount;
+    
+    while((At + 8) <= End)
+    {
+        u64 Chars;
+        memcpy(&Chars, At, 8);
+        
+        // NOTE(agent): A byte is a digit if its high nibble is 3 and its low nibble is less than 10
+        u64 Low = Chars & 0x0f0f0f0f0f0f0f0full;
+        u64 NotDigit = ((Chars & 0xf0f0f0f0f0f0f0f0ull) ^ 0x3030303030303030ull) | ((Low + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull);
+        u32 RunCount = NotDigit ? (CountTrailingZeros64(NotDigit) / 8) : 8;
+        
+        if(RunCount)
+        {
+            // NOTE(agent): Shifting the digits to the top of the u64 makes the bytes below them leading zeros
+            Low <<= 8*(8 - RunCount);
+            Low = (Low*10) + (Low >> 8);
+            Low = (((Low & 0x000000ff000000ffull) * (100 + (1000000ull << 32))) +
+                   (((Low >> 16) & 0x000000ff000000ffull) * (1 + (10000ull << 32)))) >> 32;
+            
+            if((Count + RunCount) <= 19)
+            {
+                Value = Value*PowersOfTen[RunCount] + Low;
+            }
+            Count += RunCount;
+            At += RunCount;
+        }
+        
+        if(RunCount < 8)
+        {
+            *Digits = Value;
+            *DigitCount = Count;
+            return At;
+        }
+    }
+    
+    while((At < End) && IsDigit(*At))
+    {
+        if(Count < 19)
+        {
+            Value = Value*10 + (*At - '0');
+        }
+        ++Count;
+        ++At;
+    }
+    
+    *Digits = Value;
+    *DigitCount = Count;
+    return At;
+}
+
+static b32 ParseF64(u8 *At, u8 *End, f64 *Dest)
+{
+    /* NOTE(agent): Parses a JSON number that runs from At to End, allowing whitespace before and after it.
+       Returns false if the span is anything other than exactly one valid JSON number. */
+    while((At < End) && IsJSONWhitespace(*At)) ++At;
+    while((At < End) && IsJSONWhitespace(End[-1])) --End;
+    
+    u8 *Start = At;
+    
+    b32 Negative = ((At < End) && (*At == '-'));
+    At += Negative;
+    
+    u64 Digits = 0;
+    u32 DigitCount = 0;
+    
+    // NOTE(agent): JSON doesn't allow leading zeros, so the integer part is either just "0" or starts with 1-9
+    u8 *IntegerStart = At;
+    At = ParseDigitRun(At, End, &Digits, &DigitCount);
+    if((At == IntegerStart) || ((*IntegerStart == '0') && ((At - IntegerStart) > 1)))
+    {
+        return false;
+    }
+    
+    s32 Exponent10 = 0;
+    if((At < End) && (*At == '.'))
+    {
+        ++At;
+        
+        u8 *FractionStart = At;
+        At = ParseDigitRun(At, End, &Digits, &DigitCount);
+        if(At == FractionStart)
+        {
+            return false;
+        }
+        
+        Exponent10 = -(s32)(At - FractionStart);
+    }
+    
+    if((At < End) && ((*At == 'e') || (*At == 'E')))
+    {
+        ++At;
+        
+        b32 NegativeExponent = false;
+        if((At < End) && ((*At == '+') || (*At == '-')))
+        {
+            NegativeExponent = (*At == '-');
+            ++At;
+        }
+        
+        if((At == End) || !IsDigit(*At))
+        {
+            return false;
+        }
+        
+        s32 ExplicitExponent = 0;
+        while((At < End) && IsDigit(*At))
+        {
+            if(ExplicitExponent < 100000)
+            {
+                ExplicitExponent = ExplicitExponent*10 + (*At - '0');
+            }
+            ++At;
+        }
+        
+        Exponent10 += NegativeExponent ? -ExplicitExponent : ExplicitExponent;
+    }
+    
+    if(At != End)
+    {
+        return false;
+    }
+    
+    if((DigitCount <= 19) && (Exponent10 >= -19) && (Exponent10 <= 19))
+    {
+        f64 Result = Digits ? ComposeF64(Digits, Exponent10) : 0.0;
+        *Dest = Negative ? -Result : Result;
+    }
+    else
+    {
+        /* NOTE(agent): Too many digits (leading zeros count here, to keep the fast path simple), or too big an
+           exponent, to do exactly with 64-bit integers. This never happens for generator output. */
+        char Temp[512];
+        u64 Length = End - Start;
+        if(Length >= sizeof(Temp))
+        {
+            return false;
+        }
+        
+        memcpy(Temp, Start, Length);
+        Temp[Length] = 0;
+        *Dest = strtod(Temp, 0);
+        
+        // NOTE(agent): strtod gives back infinity for anything past the largest f64, which would only turn into a
+        // NaN average later on
+        if(!isfinite(*Dest))
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+//
+// NOTE(agent): Parser
+//
+
+struct pair_output
+{
+    // NOTE(agent): Where parsed pairs go - either the f64 arrays or the f32 ones are set, in x0, y0, x1, y1 order
+    u64 Count;
+    u64 MaxCount;
+    
+    f64 *F64[4];
+    f32 *F32[4];
+};
+
+struct json_parser
+{
+    json_scanner Scanner;
+    u64 LastAt; // NOTE(agent): One past the structural character most recently returned
+    
+    char const *Error;
+    u64 ErrorAt;
+};
+
+static void ParseError(json_parser *Parser, u64 At, char const *Message)
+{
+    if(!Parser->Error)
+    {
+        Parser->Error = Message;
+        Parser->ErrorAt = At;
+    }
+}
+
+static u64 NextToken(json_parser *Parser, u8 Expected, b32 AllowSpan)
+{
+    /* NOTE(agent): Moves to the next structural character and checks that it is Expected. If AllowSpan is false,
+       there must be nothing but whitespace between it and the previous one. If AllowSpan is true, whatever is
+       in between is left for the caller to check. */
+    json_scanner *Scanner = &Parser->Scanner;
+    u64 At = NextStructural(Scanner);
+    
+    if(At >= Scanner->Size)
+    {
+        ParseError(Parser, At, "Unexpected end of input");
+    }
+    else if(Scanner->Data[At] != Expected)
+    {
+        ParseError(Parser, At, "Unexpected character");
+    }
+    else if(!AllowSpan && !IsWhitespaceSpan(Scanner->Data + Parser->LastAt, Scanner->Data + At))
+    {
+        ParseError(Parser, Parser->LastAt, "Unexpected value");
+    }
+    
+    Parser->LastAt = At + 1;
+    return At;
+}
+
+static u8 NextOf(json_parser *Parser, u8 A, u8 B, b32 AllowSpan)
+{
+    // NOTE(agent): Like NextToken, but either of two characters is allowed, and the one found is returned
+    json_scanner *Scanner = &Parser->Scanner;
+    u64 At = NextStructural(Scanner);
+    
+    u8 Result = 0;
+    if(At >= Scanner->Size)
+    {
+        ParseError(Parser, At, "Unexpected end of input");
+    }
+    else if((Scanner->Data[At] != A) && (Scanner->Data[At] != B))
+    {
+        ParseError(Parser, At, "Unexpected character");
+    }
+    else
+    {
+        Result = Scanner->Data[At];
+        if(!AllowSpan && !IsWhitespaceSpan(Scanner->Data + Parser->LastAt, Scanner->Data + At))
+        {
+            ParseError(Parser, Parser->LastAt, "Unexpected value");
+        }
+    }
+    
+    Parser->LastAt = At + 1;
+    return Result;
+}
+
+static u64 ParseKey(json_parser *Parser, u64 *KeyLength)
+{
+    // NOTE(agent): Returns the offset of the first character of the key, and checks the : after it
+    u64 Open = NextToken(Parser, '"', false);
+    u64 Close = NextToken(Parser, '"', true);
+    NextToken(Parser, ':', false);
+    
+    *KeyLength = Close - (Open + 1);
+    return Open + 1;
+}
+
+static void ParsePair(json_parser *Parser, pair_output *Output)
+{
+    u8 *Data = Parser->Scanner.Data;
+    
+    f64 Values[4];
+    u32 SeenMask = 0;
+    
+    u8 Terminator = ',';
+    while(!Parser->Error && (Terminator == ','))
+    {
+        u64 KeyLength;
+        u64 KeyAt = ParseKey(Parser, &KeyLength);
+        
+        u32 KeyIndex = 4;
+        if(KeyLength == 2)
+        {
+            u8 Axis = Data[KeyAt];
+            u8 Which = Data[KeyAt + 1];
+            if(((Axis == 'x') || (Axis == 'y')) && ((Which == '0') || (Which == '1')))
+            {
+                KeyIndex = ((Which - '0') << 1) | (Axis - 'x');
+            }
+        }
+        
+        u64 ValueAt = Parser->LastAt;
+        Terminator = NextOf(Parser, ',', '}', true);
+        
+        if(!Parser->Error)
+        {
+            if(KeyIndex == 4)
+            {
+                ParseError(Parser, KeyAt, "Unknown key (expected x0, y0, x1, or y1)");
+            }
+            else if(SeenMask & (1 << KeyIndex))
+            {
+                ParseError(Parser, KeyAt, "Duplicate key");
+            }
+            else if(!ParseF64(Data + ValueAt, Data + Parser->LastAt - 1, &Values[KeyIndex]))
+            {
+                ParseError(Parser, ValueAt, "Invalid number");
+            }
+        }
+        
+        SeenMask |= (1 << KeyIndex);
+    }
+    
+    if(!Parser->Error && (SeenMask != 0xf))
+    {
+        ParseError(Parser, Parser->LastAt, "Pair is missing one of x0, y0, x1, or y1");
+    }
+    
+    if(!Parser->Error)
+    {
+        // NOTE(agent): Rounding the correctly rounded f64 to f32 can, very rarely, be off from rounding the decimal
+        // straight to f32 by one ulp (when the f64 lands exactly halfway between two f32s), which is far below
+        // anything f32 distances can resolve anyway
+        u64 PairIndex = Output->Count;
+        for(u32 KeyIndex = 0; KeyIndex < 4; ++KeyIndex)
+        {
+            if(Output->F32[KeyIndex])
+            {
+                Output->F32[KeyIndex][PairIndex] = (f32)Values[KeyIndex];
+            }
+            else
+            {
+                Output->F64[KeyIndex][PairIndex] = Values[KeyIndex];
+            }
+        }
+    }
+}
+
+static b32 ParsePairRange(buffer Source, u64 Start, u64 End, pair_output *Output)
+{
+    /* NOTE(agent): Parses only the pairs whose opening { is at an offset in [Start, End), which is how several
+       threads split up one file. Source has to extend past End far enough to hold all of the last of those pairs,
+       plus the , or ] after it (or to the end of the file). The range starting at 0 also checks the {"pairs":[
+       at the start of the file, and the range with the last pair in it checks the ]} at the end, so if every
+       range of a file parses, the whole file was valid.
+       
+       A range that doesn't start at 0 begins at the first { at or after Start, which is only sure to be the start
+       of a pair because a { can't appear anywhere else in a valid file. (If it does appear somewhere else, it's
+       inside a pair that the range before this one will report as invalid.) So ranges must be longer than any
+       one pair, and longer than the {"pairs":[ at the start.
+       
+       Output must already have room for GetMaxPairCount(End - Start) pairs. On success, Output->Count is the
+       number of pairs read. On failure, an error is printed and false is returned. */
+    json_parser Parser = {};
+    Output->Count = 0;
+    
+    u64 Base = Start;
+    u8 Next = 0;
+    if(Start == 0)
+    {
+        Parser.Scanner = BeginScan(Source);
+        
+        NextToken(&Parser, '{', false);
+        
+        u64 KeyLength;
+        u64 KeyAt = ParseKey(&Parser, &KeyLength);
+        if(!Parser.Error && ((KeyLength != 5) || (memcmp(Source.Data + KeyAt, "pairs", 5) != 0)))
+        {
+            ParseError(&Parser, KeyAt, "Expected \"pairs\"");
+        }
+        
+        NextToken(&Parser, '[', false);
+        
+        Next = NextOf(&Parser, '{', ']', false);
+        if((Next == '{') && ((Parser.LastAt - 1) >= End))
+        {
+            // NOTE(agent): The first pair belongs to the next range
+            Next = 0;
+        }
+    }
+    else
+    {
+        u8 *FirstPair = (Start < End) ? (u8 *)memchr(Source.Data + Start, '{', End - Start) : 0;
+        if(FirstPair)
+        {
+            Base = FirstPair - Source.Data;
+            
+            buffer Rest = {Source.Count - Base, FirstPair};
+            Parser.Scanner = BeginScan(Rest);
+            NextToken(&Parser, '{', false);
+            Next = '{';
+        }
+    }
+    
+    while(!Parser.Error && (Next == '{'))
+    {
+        if(Output->Count < Output->MaxCount)
+        {
+            ParsePair(&Parser, Output);
+            ++Output->Count;
+        }
+        else
+        {
+            ParseError(&Parser, Parser.LastAt, "More pairs than there is room for");
+        }
+        
+        if(!Parser.Error)
+        {
+            Next = NextOf(&Parser, ',', ']', false);
+            if(Next == ',')
+            {
+                u64 At = NextToken(&Parser, '{', false);
+                Next = ((Base + At) < End) ? '{' : 0;
+            }
+        }
+    }
+    
+    if(!Parser.Error && (Next == ']'))
+    {
+        NextToken(&Parser, '}', false);
+        
+        u64 Size = Parser.Scanner.Size;
+        if(!Parser.Error)
+        {
+            if(NextStructural(&Parser.Scanner) < Size)
+            {
+                ParseError(&Parser, Parser.LastAt, "Unexpected data after the end of the JSON");
+            }
+            else if(!IsWhitespaceSpan(Parser.Scanner.Data + Parser.LastAt, Parser.Scanner.Data + Size))
+            {
+                ParseError(&Parser, Parser.LastAt, "Unexpected data after the end of the JSON");
+            }
+        }
+    }
+    
+    if(Parser.Error)
+    {
+        fprintf(stderr, "ERROR: JSON parse failed at byte %llu: %s.\n", Base + Parser.ErrorAt, Parser.Error);
+    }
+    
+    b32 Result = (Parser.Error == 0);
+    return Result;
+}
+
+static b32 ParseHaversinePairRange(buffer Source, u64 Start, u64 End, haversine_pairs *Pairs)
+{
+    // NOTE(agent): See ParsePairRange
+    pair_output Output = {0, Pairs->MaxCount, {Pairs->X0, Pairs->Y0, Pairs->X1, Pairs->Y1}, {}};
+    b32 Result = ParsePairRange(Source, Start, End, &Output);
+    Pairs->Count = Output.Count;
+    
+    return Result;
+}
+
+static b32 ParseHaversinePairs(buffer Source, haversine_pairs *Pairs)
+{
+    /* NOTE(agent): Pairs must already have room for GetMaxPairCount(Source.Count) pairs. On success, Pairs->Count
+       is the number of pairs read. On failure, an error is printed and false is returned. */
+    b32 Result = ParseHaversinePairRange(Source, 0, Source.Count, Pairs);
+    return Result;
+}
+
+static b32 ParseHaversinePairsF32(buffer Source, haversine_pairs_f32 *Pairs)
+{
+    // NOTE(agent): The same, but each coordinate is rounded to f32 as it is stored
+    pair_output Output = {0, Pairs->MaxCount, {}, {Pairs->X0, Pairs->Y0, Pairs->X1, Pairs->Y1}};
+    b32 Result = ParsePairRange(Source, 0, Source.Count, &Output);
+    Pairs->Count = Output.Count;
+    
+    return Result;
+}
@@ -0,0 +1,167 @@
+/* NOTE(agent): Replacements for the sin, cos, asin, and sqrt calls in ReferenceHaversine. They are only valid
+   over the inputs the haversine formula actually produces, which is what lets them be so much simpler than the
+   CRT versions:
+   
+   CustomSin: -Pi <= X <= Pi (dLat/2 is within [-Pi/2, Pi/2], and dLon/2 is within [-Pi, Pi]).
+   CustomCos: -Pi/2 <= X <= Pi/2 (latitudes).
+   CustomASin: 0 <= X <= 1 (sqrt(a), and a is within [0, 1]).
+   CustomSqrt: X >= 0. This is just the sqrtsd instruction, which is already correctly rounded.
+   
+   Each one first reduces its input to a small range, and then evaluates a polynomial. The polynomials are
+   minimax fits (Remez exchange, done in 60-digit arithmetic) over exactly that range: sin(x)/x as a degree 8
+   polynomial in x^2 over [0, Pi/2], and asin(x)/x as a degree 12 polynomial in x^2 over [0, 0.5]. Their maximum
+   errors before rounding the coefficients to f64 are 2e-19 and 1.5e-17, so what is left is the rounding error of
+   the f64 arithmetic itself. The reductions are:
+   
+   sin: sin(-x) = -sin(x), and sin(x) = sin(Pi - x), so [-Pi, Pi] folds into [0, Pi/2]. Pi - x is done as
+        (PI_HI - x) + PI_LO, where PI_HI - x is exact for x >= Pi/2, so the fold doesn't lose the low bits of
+        the result when x is close to Pi.
+   cos: cos(x) = sin(Pi/2 - |x|), done the same way as the sin fold. HALF_PI_HI - |x| is only exact above Pi/4,
+        but below that the result is close to 1, where sin is flat enough to hide the rounding. A separate cos
+        polynomial would only be accurate to about 1e-16 in absolute terms, which is a lot of ulps close to the
+        poles, where cos(lat) is tiny, and fixing that by switching to sin above Pi/4 costs a second polynomial
+        in the vector versions.
+   asin: Above 0.5, asin(x) = Pi/2 - 2*asin(sqrt((1 - x)/2)), which keeps the polynomial's input within
+         [0, 0.5], away from the infinite slope at 1. (1 - x) is exact for x >= 0.5.
+   
+   Each polynomial's leading x is added on last, by itself, which roughly halves the error compared to rounding
+   it along with everything else. The polynomials are written out rather than looped over, since not every
+   compiler will unroll the loop, and it matters here.
+   
+   HaversineBatch (haversine_batch.cpp) uses these same tables and reductions, just several lanes at a time.
+   haversine_math_report measures how accurate and how fast the scalar versions are. */
+
+#include <emmintrin.h>
+
+#define PI 3.14159265358979323846
+#define HALF_PI 1.57079632679489661923
+#define RADIANS_PER_DEGREE 0.01745329251994329577
+
+// NOTE(agent): PI_HI is Pi rounded to f64, and PI_LO is the part of Pi that rounding lost (likewise for Pi/2)
+#define PI_HI 3.141592653589793116
+#define PI_LO 1.2246467991473532072e-16
+#define HALF_PI_HI 1.570796326794896558
+#define HALF_PI_LO 6.123233995736766036e-17
+
+// NOTE(agent): sin(x)/x as a polynomial in x^2, for 0 <= x <= Pi/2
+static f64 const SinCoefficients[] =
+{
+    1, -0.16666666666666666, 0.0083333333333331875, -0.00019841269841208763, 2.7557319211243463e-06,
+    -2.5052106891767694e-08, 1.6058940935873569e-10, -7.6430279891879182e-13, 2.7215894431114289e-15,
+};
+
+// NOTE(agent): asin(x)/x as a polynomial in x^2, for 0 <= x <= 0.5
+static f64 const ASinCoefficients[] =
+{
+    1, 0.16666666666664731, 0.075000000004254955, 0.044642856775805553, 0.030381960865914097,
+    0.022371723076326143, 0.017360165087279871, 0.013881175186356919, 0.0121934128299961,
+    0.0064317717630583224, 0.019772600447760243, -0.016582846412428187, 0.032143616245262394,
+};
+
+/* NOTE(agent): The same two fits for f32 (used by HaversineBatchF32), as short as they can be while staying under
+   f32's own rounding error: sin(x)/x to degree 4 in x^2 (maximum error 6e-9) and asin(x)/x to degree 5 in x^2
+   (5e-9), each rounded to f32. */
+static f32 const SinCoefficientsF32[] =
+{
+    1, -0.166666597f, 0.00833306648f, -0.000198096022f, 2.60578054e-06f,
+};
+
+static f32 const ASinCoefficientsF32[] =
+{
+    1, 0.166667521f, 0.0749529749f, 0.0454703756f, 0.0241795145f, 0.0421663076f,
+};
+
+static f64 CustomSqrt(f64 X)
+{
+    f64 Result = _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(X)));
+    return Result;
+}
+
+static f64 SinPolynomial(f64 X)
+{
+    // NOTE(agent): 0 <= X <= Pi/2
+    f64 const *C = SinCoefficients;
+    f64 X2 = X*X;
+    
+    f64 P = C[8];
+    P = P*X2 + C[7];
+    P = P*X2 + C[6];
+    P = P*X2 + C[5];
+    P = P*X2 + C[4];
+    P = P*X2 + C[3];
+    P = P*X2 + C[2];
+    P = P*X2 + C[1];
+    
+    f64 Result = X + X*(X2*P);
+    return Result;
+}
+
+static f64 CustomSin(f64 X)
+{
+    f64 AbsX = fabs(X);
+    f64 R = (AbsX > HALF_PI) ? ((PI_HI - AbsX) + PI_LO) : AbsX;
+    
+    f64 Result = SinPolynomial(R);
+    Result = (X < 0) ? -Result : Result;
+    
+    return Result;
+}
+
+static f64 CustomCos(f64 X)
+{
+    f64 AbsX = fabs(X);
+    f64 Result = SinPolynomial((HALF_PI_HI - AbsX) + HALF_PI_LO);
+    return Result;
+}
+
+static f64 CustomASin(f64 X)
+{
+    // NOTE(agent): The sqrt is done either way, so that this can compile to selects instead of a branch that
+    // mispredicts on mixed inputs
+    b32 IsLarge = (X > 0.5);
+    f64 Folded = CustomSqrt((1.0 - X)*0.5);
+    f64 U = IsLarge ? Folded : X;
+    
+    f64 const *C = ASinCoefficients;
+    f64 U2 = U*U;
+    
+    f64 P = C[12];
+    P = P*U2 + C[11];
+    P = P*U2 + C[10];
+    P = P*U2 + C[9];
+    P = P*U2 + C[8];
+    P = P*U2 + C[7];
+    P = P*U2 + C[6];
+    P = P*U2 + C[5];
+    P = P*U2 + C[4];
+    P = P*U2 + C[3];
+    P = P*U2 + C[2];
+    P = P*U2 + C[1];
+    
+    // NOTE(agent): asin(U) = U + Tail, and the U part is kept separate as long as possible, like in SinPolynomial
+    f64 Tail = U*(U2*P);
+    f64 Result = IsLarge ? ((HALF_PI_HI - 2.0*U) + (HALF_PI_LO - 2.0*Tail)) : (U + Tail);
+    
+    return Result;
+}
+
+static f64 CustomHaversine(f64 X0, f64 Y0, f64 X1, f64 Y1, f64 EarthRadius)
+{
+    // NOTE(agent): Exactly ReferenceHaversine, with the custom functions swapped in
+    f64 lat1 = Y0;
+    f64 lat2 = Y1;
+    f64 lon1 = X0;
+    f64 lon2 = X1;
+    
+    f64 dLat = RadiansFromDegrees(lat2 - lat1);
+    f64 dLon = RadiansFromDegrees(lon2 - lon1);
+    lat1 = RadiansFromDegrees(lat1);
+    lat2 = RadiansFromDegrees(lat2);
+    
+    f64 a = Square(CustomSin(dLat/2.0)) + CustomCos(lat1)*CustomCos(lat2)*Square(CustomSin(dLon/2));
+    f64 c = 2.0*CustomASin(CustomSqrt(a));
+    
+    f64 Result = EarthRadius * c;
+    
+    return Result;
+}
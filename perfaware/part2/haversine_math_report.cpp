@@ -0,0 +1,381 @@
+/* NOTE(agent): Measures the functions in haversine_math.cpp. For each one, it sweeps the whole input range that
+   function is valid for, evenly, and compares every result against a higher-precision reference, reporting the
+   largest error (in absolute terms and in ulps of the correct result) and the input it happened at. The CRT
+   versions are run through the same sweep, to show what the custom versions are being compared to. Then each
+   function, custom and CRT, is timed with the repetition tester.
+   
+   Usage: haversine_math_report [-samples count] [-seconds count]
+   
+   The reference can't just be the CRT functions in long double, because on Windows long double is the same as
+   double. Instead it is computed in double-double arithmetic (an unevaluated sum of two f64s, good for about
+   106 bits), with Taylor series for sin and cos, and Newton's method on sin for asin. That is far more precise
+   than an f64 result needs, so an error of 0.5 ulps here means the result was correctly rounded.
+   
+   Times are CPU timer ticks per call, which may not be the same as core clocks (see platform_metrics.cpp), over
+   inputs spread across the same range as the sweep. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "listing_0065_haversine_formula.cpp"
+#include "haversine_math.cpp"
+
+// NOTE(agent): What PI_HI + PI_LO and HALF_PI_HI + HALF_PI_LO still leave out of Pi and Pi/2
+#define PI_LO_LO -2.9947698097183397e-33
+#define HALF_PI_LO_LO -1.4973849048591698e-33
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+#define TIMING_INPUT_COUNT 4096
+
+struct dd
+{
+    // NOTE(agent): Hi + Lo, with |Lo| <= half an ulp of Hi
+    f64 Hi;
+    f64 Lo;
+};
+
+typedef f64 math_function(f64 X);
+typedef dd reference_function(f64 X);
+typedef void apply_function(u32 Count, f64 *Input, f64 *Output);
+
+struct math_error
+{
+    f64 MaxError;
+    f64 MaxErrorAt;
+    f64 MaxULP;
+    f64 MaxULPAt;
+};
+
+static dd QuickTwoSum(f64 A, f64 B)
+{
+    // NOTE(agent): Only valid when |A| >= |B|
+    dd Result;
+    Result.Hi = A + B;
+    Result.Lo = B - (Result.Hi - A);
+    return Result;
+}
+
+static dd TwoSum(f64 A, f64 B)
+{
+    dd Result;
+    Result.Hi = A + B;
+    f64 BPart = Result.Hi - A;
+    Result.Lo = (A - (Result.Hi - BPart)) + (B - BPart);
+    return Result;
+}
+
+static dd DDAdd(dd A, dd B)
+{
+    dd Sum = TwoSum(A.Hi, B.Hi);
+    dd Result = QuickTwoSum(Sum.Hi, Sum.Lo + A.Lo + B.Lo);
+    return Result;
+}
+
+static dd DDNegate(dd A)
+{
+    dd Result = {-A.Hi, -A.Lo};
+    return Result;
+}
+
+static dd DDMul(dd A, dd B)
+{
+    f64 Product = A.Hi*B.Hi;
+    f64 ProductError = fma(A.Hi, B.Hi, -Product);
+    dd Result = QuickTwoSum(Product, ProductError + (A.Hi*B.Lo + A.Lo*B.Hi));
+    return Result;
+}
+
+static dd DDDiv(dd A, f64 B)
+{
+    f64 Quotient = A.Hi / B;
+    f64 Product = Quotient*B;
+    f64 ProductError = fma(Quotient, B, -Product);
+    f64 Remainder = ((A.Hi - Product) - ProductError) + A.Lo;
+    dd Result = QuickTwoSum(Quotient, Remainder / B);
+    return Result;
+}
+
+static dd SinTaylor(dd X)
+{
+    // NOTE(agent): Only used for |X| <= Pi/2, where the terms shrink quickly
+    dd X2 = DDMul(X, X);
+    dd Term = X;
+    dd Result = X;
+    for(u32 N = 2; fabs(Term.Hi) > 1e-40; N += 2)
+    {
+        Term = DDNegate(DDDiv(DDMul(Term, X2), (f64)(N*(N + 1))));
+        Result = DDAdd(Result, Term);
+    }
+    
+    return Result;
+}
+
+static dd CosTaylor(dd X)
+{
+    // NOTE(agent): Only used for |X| <= Pi/2, where the terms shrink quickly
+    dd X2 = DDMul(X, X);
+    dd Term = {1.0, 0.0};
+    dd Result = Term;
+    for(u32 N = 1; fabs(Term.Hi) > 1e-40; N += 2)
+    {
+        Term = DDNegate(DDDiv(DDMul(Term, X2), (f64)(N*(N + 1))));
+        Result = DDAdd(Result, Term);
+    }
+    
+    return Result;
+}
+
+static dd ReferenceSin(f64 X)
+{
+    dd R = {fabs(X), 0.0};
+    if(R.Hi > HALF_PI)
+    {
+        // NOTE(agent): PI_HI - |X| is exact here, so Pi - |X| is as precise as the three parts of Pi
+        R = DDAdd(TwoSum(PI_HI - R.Hi, PI_LO), {PI_LO_LO, 0.0});
+    }
+    
+    dd Result = SinTaylor(R);
+    if(X < 0)
+    {
+        Result = DDNegate(Result);
+    }
+    
+    return Result;
+}
+
+static dd ReferenceCos(f64 X)
+{
+    dd Result = CosTaylor({X, 0.0});
+    return Result;
+}
+
+static dd ReferenceSqrt(f64 X)
+{
+    // NOTE(agent): One Newton step from the f64 answer, done as X - Root^2 exactly with an FMA
+    dd Result = {sqrt(X), 0.0};
+    if(Result.Hi > 0)
+    {
+        f64 Residual = fma(-Result.Hi, Result.Hi, X);
+        Result = QuickTwoSum(Result.Hi, Residual / (2.0*Result.Hi));
+    }
+    
+    return Result;
+}
+
+static dd ASinNewton(dd X)
+{
+    // NOTE(agent): Newton's method on sin(Y) - X = 0, starting from the CRT's answer. Each step squares the error,
+    // and X <= 0.5 keeps sin's slope away from 0, so two steps are plenty.
+    dd Result = {asin(X.Hi), 0.0};
+    for(u32 Step = 0; Step < 2; ++Step)
+    {
+        dd Residual = DDAdd(SinTaylor(Result), DDNegate(X));
+        Result = DDAdd(Result, {-Residual.Hi / CosTaylor(Result).Hi, 0.0});
+    }
+    
+    return Result;
+}
+
+static dd ReferenceASin(f64 X)
+{
+    dd Result;
+    if(X > 0.5)
+    {
+        // NOTE(agent): Close to 1, sin is too flat for Newton's method, so this goes through
+        // asin(x) = Pi/2 - 2*asin(sqrt((1 - x)/2)) first. (1 - x)/2 is exact, so only the sqrt rounds.
+        dd Half = ASinNewton(ReferenceSqrt((1.0 - X)*0.5));
+        dd HalfPi = DDAdd(TwoSum(HALF_PI_HI, HALF_PI_LO), {HALF_PI_LO_LO, 0.0});
+        Result = DDAdd(HalfPi, DDNegate(DDAdd(Half, Half)));
+    }
+    else
+    {
+        Result = ASinNewton({X, 0.0});
+    }
+    
+    return Result;
+}
+
+static f64 CRTSin(f64 X) {return sin(X);}
+static f64 CRTCos(f64 X) {return cos(X);}
+static f64 CRTASin(f64 X) {return asin(X);}
+static f64 CRTSqrt(f64 X) {return sqrt(X);}
+
+template<math_function Function>
+static void ApplyFunction(u32 Count, f64 *Input, f64 *Output)
+{
+    for(u32 Index = 0; Index < Count; ++Index)
+    {
+        Output[Index] = Function(Input[Index]);
+    }
+}
+
+struct math_test
+{
+    char const *Name;
+    f64 Min;
+    f64 Max;
+    
+    reference_function *Reference;
+    
+    math_function *Custom;
+    math_function *CRT;
+    
+    apply_function *ApplyCustom;
+    apply_function *ApplyCRT;
+};
+
+static math_test const MathTests[] =
+{
+    {"sin", -PI, PI, ReferenceSin, CustomSin, CRTSin, ApplyFunction<CustomSin>, ApplyFunction<CRTSin>},
+    {"cos", -HALF_PI, HALF_PI, ReferenceCos, CustomCos, CRTCos, ApplyFunction<CustomCos>, ApplyFunction<CRTCos>},
+    {"asin", 0.0, 1.0, ReferenceASin, CustomASin, CRTASin, ApplyFunction<CustomASin>, ApplyFunction<CRTASin>},
+    {"sqrt", 0.0, 1.0, ReferenceSqrt, CustomSqrt, CRTSqrt, ApplyFunction<CustomSqrt>, ApplyFunction<CRTSqrt>},
+};
+
+static f64 SampleAt(math_test const *Test, u64 SampleIndex, u64 SampleCount)
+{
+    f64 t = (f64)SampleIndex / (f64)(SampleCount - 1);
+    f64 Result = (1.0 - t)*Test->Min + t*Test->Max;
+    return Result;
+}
+
+static void AccumulateError(math_error *Error, f64 X, f64 Value, dd Expected)
+{
+    f64 AbsError = fabs((Value - Expected.Hi) - Expected.Lo);
+    if(Error->MaxError < AbsError)
+    {
+        Error->MaxError = AbsError;
+        Error->MaxErrorAt = X;
+    }
+    
+    // NOTE(agent): ulps are measured against the spacing of f64s at the correct answer, so they don't exist at 0
+    if(Expected.Hi != 0)
+    {
+        f64 ULP = ldexp(1.0, ilogb(Expected.Hi) - 52);
+        f64 ULPError = AbsError / ULP;
+        if(Error->MaxULP < ULPError)
+        {
+            Error->MaxULP = ULPError;
+            Error->MaxULPAt = X;
+        }
+    }
+}
+
+static f64 TimeMathFunction(apply_function *Apply, f64 *Input, f64 *Output, u32 SecondsToTry)
+{
+    u64 ByteCount = TIMING_INPUT_COUNT*sizeof(f64);
+    
+    repetition_tester Tester = {};
+    NewTestWave(&Tester, ByteCount, GetCPUTimerFreq(), SecondsToTry);
+    Tester.PrintNewMinimums = false;
+    while(IsTesting(&Tester))
+    {
+        BeginTime(&Tester);
+        Apply(TIMING_INPUT_COUNT, Input, Output);
+        EndTime(&Tester);
+        CountBytes(&Tester, ByteCount);
+    }
+    
+    f64 Result = (f64)Tester.Results.Min.E[RepValue_CPUTimer] / (f64)TIMING_INPUT_COUNT;
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    u64 SampleCount = 1 << 22;
+    u32 SecondsToTry = 3;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-samples") == 0))
+        {
+            SampleCount = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else
+        {
+            SampleCount = 0;
+            break;
+        }
+    }
+    
+    if(SampleCount < 2)
+    {
+        fprintf(stderr, "USAGE: %s [-samples count] [-seconds count]\n", Args[0]);
+        return 1;
+    }
+    
+    fprintf(stdout, "Accuracy (%llu samples per function):\n", SampleCount);
+    fprintf(stdout, "%-5s %-22s %-7s %12s %24s %10s %24s\n",
+            "Func", "Range", "Impl", "Max error", "(at)", "Max ulp", "(at)");
+    for(u32 TestIndex = 0; TestIndex < ArrayCount(MathTests); ++TestIndex)
+    {
+        math_test const *Test = MathTests + TestIndex;
+        
+        math_error CustomError = {};
+        math_error CRTError = {};
+        for(u64 SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex)
+        {
+            f64 X = SampleAt(Test, SampleIndex, SampleCount);
+            dd Expected = Test->Reference(X);
+            AccumulateError(&CustomError, X, Test->Custom(X), Expected);
+            AccumulateError(&CRTError, X, Test->CRT(X), Expected);
+        }
+        
+        char Range[64];
+        snprintf(Range, sizeof(Range), "[%.6f, %.6f]", Test->Min, Test->Max);
+        
+        math_error *Errors[] = {&CustomError, &CRTError};
+        char const *ImplNames[] = {"custom", "crt"};
+        for(u32 ImplIndex = 0; ImplIndex < ArrayCount(Errors); ++ImplIndex)
+        {
+            math_error *Error = Errors[ImplIndex];
+            fprintf(stdout, "%-5s %-22s %-7s %12.3e %24.17f %10.3f %24.17f\n",
+                    ImplIndex ? "" : Test->Name, ImplIndex ? "" : Range, ImplNames[ImplIndex],
+                    Error->MaxError, Error->MaxErrorAt, Error->MaxULP, Error->MaxULPAt);
+        }
+    }
+    
+    f64 *Input = (f64 *)malloc(TIMING_INPUT_COUNT*sizeof(f64));
+    f64 *Output = (f64 *)malloc(TIMING_INPUT_COUNT*sizeof(f64));
+    if(!Input || !Output)
+    {
+        fprintf(stderr, "ERROR: Unable to allocate timing buffers.\n");
+        return 1;
+    }
+    
+    fprintf(stdout, "\nTime (ticks per call):\n");
+    fprintf(stdout, "%-5s %10s %10s %8s\n", "Func", "custom", "crt", "x");
+    for(u32 TestIndex = 0; TestIndex < ArrayCount(MathTests); ++TestIndex)
+    {
+        math_test const *Test = MathTests + TestIndex;
+        
+        // NOTE(agent): Scattered rather than in order, so branchy code can't just predict its way through
+        u32 Step = 2654435761u % TIMING_INPUT_COUNT;
+        for(u32 Index = 0; Index < TIMING_INPUT_COUNT; ++Index)
+        {
+            Input[Index] = SampleAt(Test, (Index*Step) % TIMING_INPUT_COUNT, TIMING_INPUT_COUNT);
+        }
+        
+        f64 CustomTicks = TimeMathFunction(Test->ApplyCustom, Input, Output, SecondsToTry);
+        f64 CRTTicks = TimeMathFunction(Test->ApplyCRT, Input, Output, SecondsToTry);
+        fprintf(stdout, "%-5s %10.2f %10.2f %8.2f\n", Test->Name, CustomTicks, CRTTicks, CRTTicks / CustomTicks);
+    }
+    
+    free(Input);
+    free(Output);
+    
+    return 0;
+}
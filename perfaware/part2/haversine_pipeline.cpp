@@ -0,0 +1,330 @@
+/* NOTE(agent): Computes the average haversine distance of a JSON file with several threads, overlapping the
+   reading of the file with the parsing and the math, instead of reading it all, then parsing it all, then
+   computing it all.
+   
+   The file is cut into fixed-size chunks. The calling thread is the reader: it reads the chunks in order, one
+   fread per chunk, straight into their place in one buffer the size of the whole file, and bumps ReadChunkCount
+   after each one. Worker threads take chunks in order too. A worker waits for its chunk and the one after it
+   to be read (since the last pair that starts in a chunk can end in the next one), parses the pairs that start
+   in its chunk with ParseHaversinePairRange, runs HaversineBatch on them, and sums the distances.
+   
+   Parsing and computing are done by the same worker, one chunk after the other, rather than by separate parser
+   and compute threads handing blocks to each other. The parsed block is at most a couple hundred KB, so it is
+   still in that core's cache when the math runs on it, and handing it to another core would just move it
+   through memory for nothing. Every stage still overlaps with the others, since each worker is on a different
+   chunk.
+   
+   Each chunk's distances are kept, in their own part of one array big enough for the most pairs every chunk
+   could have, and once everything is done they are all added up with DeterministicSumSpans (one span per
+   chunk). That sum only depends on the distances and their order, so the average is bit-for-bit the same with
+   any number of threads, any chunk size, and as reading the whole file and summing it with DeterministicSum.
+   
+   Everything a run needs - the file buffer, the chunk table, the distances, and each worker's pairs - is pushed
+   on the arena that is passed in (the workers' pairs before the workers start, since an arena is only safe to
+   use from one thread), and popped off again at the end. So with an arena that is kept from one run to the
+   next, every run after the first makes no allocation calls of its own.
+   
+   ComputeHaversineAverageSerial does the same run the simple way, on one thread - read all of the file, then
+   parse all of it, then compute all of it - with the same arena rules and the same sum, for comparison.
+   
+   Only the calling thread is instrumented with profiler.cpp (the serial run, the reads and the final sum), since
+   the profiler is single-threaded. The workers' parsing and math don't show up in a profile.
+
+   Needs arena.cpp, os_thread.cpp and deterministic_sum.cpp included first, and InitHaversineBatch called before
+   the first run, since the workers all call HaversineBatch. */
+
+#define PIPELINE_CHUNK_SIZE (2*1024*1024)
+#define MAX_PIPELINE_THREADS 256
+
+struct pipeline_chunk
+{
+    u64 PairCount;
+    b32 volatile Done;
+    b32 Failed;
+};
+
+struct haversine_pipeline
+{
+    buffer Source;
+    u64 ChunkSize;
+    u32 ChunkCount;
+    pipeline_chunk *Chunks;
+    
+    u64 MaxChunkPairCount;
+    f64 *Distances;
+    
+    u32 volatile ReadChunkCount;
+    b32 volatile ReadFailed;
+    u32 volatile NextChunkIndex;
+};
+
+struct pipeline_thread
+{
+    haversine_pipeline *Pipeline;
+    haversine_pairs Pairs;
+};
+
+struct pipeline_result
+{
+    b32 Valid;
+    u64 ByteCount;
+    u64 PairCount;
+    f64 Average;
+};
+
+static void WaitForChunks(haversine_pipeline *Pipeline, u32 ChunkCount)
+{
+    // NOTE(agent): Spins for a while first, but yields eventually, since the reader might need this processor
+    u32 SpinCount = 0;
+    while((Pipeline->ReadChunkCount < ChunkCount) && !Pipeline->ReadFailed)
+    {
+        if(SpinCount < 4096)
+        {
+            ++SpinCount;
+            _mm_pause();
+        }
+        else
+        {
+            YieldThread();
+        }
+    }
+    
+    // NOTE(agent): None of the chunk's bytes can be looked at before ReadChunkCount says they are there
+    CompilerBarrier();
+}
+
+static void ProcessChunks(haversine_pipeline *Pipeline, haversine_pairs Pairs)
+{
+    for(;;)
+    {
+        u32 ChunkIndex = AtomicIncrementU32(&Pipeline->NextChunkIndex);
+        if(ChunkIndex >= Pipeline->ChunkCount)
+        {
+            break;
+        }
+        
+        u32 NeededChunkCount = ChunkIndex + 2;
+        if(NeededChunkCount > Pipeline->ChunkCount)
+        {
+            NeededChunkCount = Pipeline->ChunkCount;
+        }
+        
+        WaitForChunks(Pipeline, NeededChunkCount);
+        
+        pipeline_chunk *Chunk = Pipeline->Chunks + ChunkIndex;
+        if(Pipeline->ReadFailed)
+        {
+            Chunk->Failed = true;
+        }
+        else
+        {
+            u64 Start = ChunkIndex*Pipeline->ChunkSize;
+            u64 End = Start + Pipeline->ChunkSize;
+            u64 Available = NeededChunkCount*Pipeline->ChunkSize;
+            if(End > Pipeline->Source.Count)
+            {
+                End = Pipeline->Source.Count;
+            }
+            if(Available > Pipeline->Source.Count)
+            {
+                Available = Pipeline->Source.Count;
+            }
+            
+            buffer Source = {Available, Pipeline->Source.Data};
+            if(ParseHaversinePairRange(Source, Start, End, &Pairs))
+            {
+                f64 *Distances = Pipeline->Distances + ChunkIndex*Pipeline->MaxChunkPairCount;
+                HaversineBatch(Pairs.Count, Pairs.X0, Pairs.Y0, Pairs.X1, Pairs.Y1, Distances);
+                Chunk->PairCount = Pairs.Count;
+            }
+            else
+            {
+                Chunk->Failed = true;
+            }
+        }
+        
+        CompilerBarrier();
+        Chunk->Done = true;
+    }
+}
+
+static THREAD_PROC(PipelineThreadProc)
+{
+    pipeline_thread *Thread = (pipeline_thread *)Param;
+    ProcessChunks(Thread->Pipeline, Thread->Pairs);
+    return 0;
+}
+
+static pipeline_result ComputeHaversineAverageSerial(arena *Arena, char *FileName)
+{
+    TimeFunction;
+    
+    pipeline_result Result = {};
+    
+    temp_arena Temp = BeginTemp(Arena);
+    
+    buffer Source = ReadEntireFile(Arena, FileName);
+    haversine_pairs Pairs = PushPairs(Arena, GetMaxPairCount(Source.Count));
+    f64 *Distances = (f64 *)PushSize(Arena, Pairs.MaxCount*sizeof(f64), 64);
+    if(Source.Data && Pairs.X0 && Distances && ParseHaversinePairs(Source, &Pairs))
+    {
+        HaversineBatch(Pairs.Count, Pairs.X0, Pairs.Y0, Pairs.X1, Pairs.Y1, Distances);
+        
+        f64 Sum = 0;
+        b32 Summed = DeterministicSum(Arena, Distances, Pairs.Count, 1, &Sum);
+        
+        Result.Valid = (Summed && (Pairs.Count != 0));
+        Result.ByteCount = Source.Count;
+        Result.PairCount = Pairs.Count;
+        Result.Average = Pairs.Count ? (Sum / (f64)Pairs.Count) : 0;
+    }
+    
+    EndTemp(Temp);
+    
+    return Result;
+}
+
+static pipeline_result ComputeHaversineAveragePipelined(arena *Arena, char *FileName, u32 ThreadCount,
+                                                        u64 ChunkSize = PIPELINE_CHUNK_SIZE)
+{
+    pipeline_result Result = {};
+    
+    FILE *File = fopen(FileName, "rb");
+    if(!File)
+    {
+        fprintf(stderr, "ERROR: Unable to open \"%s\".\n", FileName);
+        return Result;
+    }
+    
+    u64 FileSize = 0;
+    if(!GetFileSize(FileName, &FileSize))
+    {
+        fclose(File);
+        return Result;
+    }
+    
+    // NOTE(agent): Every read is a whole chunk, straight into place, so the FILE doesn't need a buffer of its own
+    setvbuf(File, 0, _IONBF, 0);
+    
+    if(ThreadCount < 1)
+    {
+        ThreadCount = 1;
+    }
+    if(ThreadCount > MAX_PIPELINE_THREADS)
+    {
+        ThreadCount = MAX_PIPELINE_THREADS;
+    }
+    
+    temp_arena Temp = BeginTemp(Arena);
+    
+    haversine_pipeline Pipeline = {};
+    Pipeline.Source = PushBuffer(Arena, FileSize);
+    Pipeline.ChunkSize = ChunkSize;
+    Pipeline.ChunkCount = (u32)((Pipeline.Source.Count + ChunkSize - 1) / ChunkSize);
+    Pipeline.Chunks = PushArrayZero(Arena, Pipeline.ChunkCount + 1, pipeline_chunk);
+    Pipeline.MaxChunkPairCount = GetMaxPairCount(ChunkSize);
+    
+    // NOTE(agent): Most of this is never touched (see PushPairs), since chunks are nowhere near all commas
+    Pipeline.Distances = (f64 *)PushSize(Arena, (Pipeline.ChunkCount + 1)*Pipeline.MaxChunkPairCount*sizeof(f64), 64);
+    
+    sum_span *Spans = PushArrayZero(Arena, Pipeline.ChunkCount + 1, sum_span);
+    
+    b32 Allocated = (Pipeline.Source.Data && Pipeline.Chunks && Pipeline.Distances && Spans);
+    
+    pipeline_thread ThreadParams[MAX_PIPELINE_THREADS];
+    for(u32 ThreadIndex = 0; Allocated && (ThreadIndex < ThreadCount); ++ThreadIndex)
+    {
+        ThreadParams[ThreadIndex].Pipeline = &Pipeline;
+        ThreadParams[ThreadIndex].Pairs = PushPairs(Arena, Pipeline.MaxChunkPairCount);
+        Allocated = (ThreadParams[ThreadIndex].Pairs.X0 != 0);
+    }
+    
+    if(Allocated)
+    {
+        os_thread Threads[MAX_PIPELINE_THREADS];
+        u32 StartedCount = 0;
+        for(u32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+        {
+            if(StartThread(&Threads[StartedCount], PipelineThreadProc, &ThreadParams[StartedCount]))
+            {
+                ++StartedCount;
+            }
+        }
+        
+        {
+            TimeBandwidth("Pipeline read", Pipeline.Source.Count);
+            for(u32 ChunkIndex = 0; ChunkIndex < Pipeline.ChunkCount; ++ChunkIndex)
+            {
+                u64 Offset = ChunkIndex*ChunkSize;
+                u64 Size = Pipeline.Source.Count - Offset;
+                if(Size > ChunkSize)
+                {
+                    Size = ChunkSize;
+                }
+                
+                if(fread(Pipeline.Source.Data + Offset, Size, 1, File) != 1)
+                {
+                    fprintf(stderr, "ERROR: Unable to read \"%s\".\n", FileName);
+                    Pipeline.ReadFailed = true;
+                    break;
+                }
+                
+                CompilerBarrier();
+                Pipeline.ReadChunkCount = ChunkIndex + 1;
+            }
+        }
+        
+        // NOTE(agent): If no threads could be started, the reader does all the work itself once it's done reading
+        if(StartedCount == 0)
+        {
+            ProcessChunks(&Pipeline, ThreadParams[0].Pairs);
+        }
+        
+        for(u32 ThreadIndex = 0; ThreadIndex < StartedCount; ++ThreadIndex)
+        {
+            JoinThread(Threads[ThreadIndex]);
+        }
+        
+        b32 Valid = !Pipeline.ReadFailed;
+        u64 PairCount = 0;
+        for(u32 ChunkIndex = 0; ChunkIndex < Pipeline.ChunkCount; ++ChunkIndex)
+        {
+            pipeline_chunk *Chunk = Pipeline.Chunks + ChunkIndex;
+            if(!Chunk->Done || Chunk->Failed)
+            {
+                Valid = false;
+            }
+            
+            Spans[ChunkIndex].Values = Pipeline.Distances + ChunkIndex*Pipeline.MaxChunkPairCount;
+            Spans[ChunkIndex].Count = Chunk->PairCount;
+            PairCount += Chunk->PairCount;
+        }
+        
+        f64 Sum = 0;
+        if(Valid)
+        {
+            TimeBandwidth("Pipeline sum", PairCount*sizeof(f64));
+            Valid = DeterministicSumSpans(Arena, Spans, Pipeline.ChunkCount, ThreadCount, &Sum);
+        }
+        
+        if(Valid && !Pipeline.ChunkCount)
+        {
+            fprintf(stderr, "ERROR: \"%s\" is empty.\n", FileName);
+            Valid = false;
+        }
+        
+        Result.Valid = Valid;
+        Result.ByteCount = Pipeline.Source.Count;
+        Result.PairCount = PairCount;
+        Result.Average = PairCount ? (Sum / (f64)PairCount) : 0;
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate memory for \"%s\".\n", FileName);
+    }
+    
+    EndTemp(Temp);
+    fclose(File);
+    
+    return Result;
+}
@@ -0,0 +1,200 @@
+/* NOTE(agent): Times a whole haversine run - from opening the JSON file to having the average - done the simple
+   way (read all of it, then parse all of it, then compute all of it) and then with the pipeline in
+   haversine_pipeline.cpp at 1, 2, 4, ... threads up to the number of processors (or -threads). Each one is run
+   through the repetition tester, and the fastest run is reported in GB/s of JSON.
+   
+   Usage: haversine_pipeline_report [-seconds count] [-threads max] [-chunk kilobytes] [data.json] [answers.f64]
+   
+   Both paths add up the distances with deterministic_sum.cpp, so every run - serial, or pipelined with any
+   number of threads and any chunk size - has to come out with exactly the same average, to the last bit, or it
+   is reported as an error. If the answers file is given, the average is also checked against the one in it.
+   
+   Every run gets its memory from one arena that lasts for the whole program (see arena.cpp), so after the first
+   run, none of them are timing allocations or page faults - only the reading, parsing and math.
+   
+   Once the file is in the OS's file cache, all of this measures reading from memory, not from the disk. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "profiler.cpp"
+#include "listing_0065_haversine_formula.cpp"
+#include "os_memory.cpp"
+#include "arena.cpp"
+#include "haversine_json.cpp"
+#include "haversine_math.cpp"
+#include "haversine_batch.cpp"
+#include "os_thread.cpp"
+#include "deterministic_sum.cpp"
+#include "haversine_pipeline.cpp"
+
+static f64 GetAnswersAverage(arena *Arena, char *FileName)
+{
+    f64 Result = 0;
+    
+    temp_arena Temp = BeginTemp(Arena);
+    buffer Answers = ReadEntireFile(Arena, FileName);
+    if(Answers.Count >= sizeof(f64))
+    {
+        memcpy(&Result, Answers.Data + Answers.Count - sizeof(f64), sizeof(f64));
+    }
+    EndTemp(Temp);
+    
+    return Result;
+}
+
+static void PrintRow(char const *Name, u32 ThreadCount, pipeline_result Run, repetition_tester *Tester,
+                     f64 SerialSeconds, char *AnswersFileName, f64 ExpectedAverage)
+{
+    u64 CPUTimerFreq = GetCPUTimerFreq();
+    f64 Seconds = (f64)Tester->Results.Min.E[RepValue_CPUTimer] / (f64)CPUTimerFreq;
+    f64 Gigabyte = 1024.0*1024.0*1024.0;
+    
+    fprintf(stdout, "%-10s %8u %10.2f %8.3f %8.2f %24.16f", Name, ThreadCount, 1000.0*Seconds,
+            ((f64)Run.ByteCount / Gigabyte) / Seconds, SerialSeconds / Seconds, Run.Average);
+    if(AnswersFileName)
+    {
+        fprintf(stdout, " %12.3e", Run.Average - ExpectedAverage);
+    }
+    fprintf(stdout, "\n");
+}
+
+int main(int ArgCount, char **Args)
+{
+    // NOTE(agent): Before any threads are started (see InitHaversineBatch)
+    InitHaversineBatch();
+    
+    BeginProfile();
+    
+    u32 SecondsToTry = 3;
+    u32 MaxThreadCount = GetProcessorCount();
+    u64 ChunkSize = PIPELINE_CHUNK_SIZE;
+    char *JSONFileName = 0;
+    char *AnswersFileName = 0;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else if(HasValue && (strcmp(Arg, "-threads") == 0))
+        {
+            MaxThreadCount = atoi(Args[++ArgIndex]);
+        }
+        else if(HasValue && (strcmp(Arg, "-chunk") == 0))
+        {
+            ChunkSize = 1024*strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(!JSONFileName)
+        {
+            JSONFileName = Arg;
+        }
+        else if(!AnswersFileName)
+        {
+            AnswersFileName = Arg;
+        }
+        else
+        {
+            JSONFileName = 0;
+            break;
+        }
+    }
+    
+    if(!JSONFileName || (MaxThreadCount < 1) || (MaxThreadCount > MAX_PIPELINE_THREADS) || (ChunkSize < 64*1024))
+    {
+        fprintf(stderr, "USAGE: %s [-seconds count] [-threads 1 to %u] [-chunk 64 or more kilobytes] [data.json] [answers.f64]\n",
+                Args[0], MAX_PIPELINE_THREADS);
+        return 1;
+    }
+    
+    arena Arena = {};
+    Arena.Policy = GetDefaultMemoryPolicy();
+    
+    f64 ExpectedAverage = AnswersFileName ? GetAnswersAverage(&Arena, AnswersFileName) : 0;
+    
+    int Result = 0;
+    
+    fprintf(stdout, "Chunk size: %llukb\n\n", ChunkSize / 1024);
+    fprintf(stdout, "%-10s %8s %10s %8s %8s %24s%s\n", "Path", "Threads", "ms", "GB/s", "x", "Average",
+            AnswersFileName ? "   Difference" : "");
+    
+    u64 CPUTimerFreq = GetCPUTimerFreq();
+    
+    pipeline_result Serial = {};
+    repetition_tester SerialTester = {};
+    NewTestWave(&SerialTester, 0, CPUTimerFreq, SecondsToTry);
+    SerialTester.PrintNewMinimums = false;
+    while(IsTesting(&SerialTester))
+    {
+        BeginTime(&SerialTester);
+        Serial = ComputeHaversineAverageSerial(&Arena, JSONFileName);
+        EndTime(&SerialTester);
+    }
+    
+    if(!Serial.Valid)
+    {
+        return 1;
+    }
+    
+    f64 SerialSeconds = (f64)SerialTester.Results.Min.E[RepValue_CPUTimer] / (f64)CPUTimerFreq;
+    PrintRow("serial", 1, Serial, &SerialTester, SerialSeconds, AnswersFileName, ExpectedAverage);
+    if(AnswersFileName && (fabs(Serial.Average - ExpectedAverage) > MAX_DISTANCE_ERROR))
+    {
+        fprintf(stderr, "ERROR: The serial average does not match the answers file.\n");
+        Result = 1;
+    }
+    
+    f64 FirstAverage = Serial.Average;
+    for(u32 ThreadCount = 1; ThreadCount <= MaxThreadCount;)
+    {
+        pipeline_result Run = {};
+        repetition_tester Tester = {};
+        NewTestWave(&Tester, 0, CPUTimerFreq, SecondsToTry);
+        Tester.PrintNewMinimums = false;
+        while(IsTesting(&Tester))
+        {
+            BeginTime(&Tester);
+            pipeline_result ThisRun = ComputeHaversineAveragePipelined(&Arena, JSONFileName, ThreadCount, ChunkSize);
+            EndTime(&Tester);
+            
+            if(!ThisRun.Valid)
+            {
+                return 1;
+            }
+            
+            if(memcmp(&ThisRun.Average, &FirstAverage, sizeof(f64)) != 0)
+            {
+                fprintf(stderr, "ERROR: %u threads gave %.17g, but the serial run gave %.17g.\n",
+                        ThreadCount, ThisRun.Average, FirstAverage);
+                Result = 1;
+            }
+            
+            Run = ThisRun;
+        }
+        
+        PrintRow("pipeline", ThreadCount, Run, &Tester, SerialSeconds, AnswersFileName, ExpectedAverage);
+        if(AnswersFileName && (fabs(Run.Average - ExpectedAverage) > MAX_DISTANCE_ERROR))
+        {
+            fprintf(stderr, "ERROR: The pipelined average does not match the answers file.\n");
+            Result = 1;
+        }
+        
+        // NOTE(agent): Powers of two, but always ending on MaxThreadCount itself
+        ThreadCount = ((ThreadCount < MaxThreadCount) && ((2*ThreadCount) > MaxThreadCount)) ? MaxThreadCount : 2*ThreadCount;
+    }
+    
+    EndAndPrintProfile(stdout);
+    
+    return Result;
+}
+
+ProfilerEndOfCompilationUnit;
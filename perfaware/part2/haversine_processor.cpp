@@ -0,0 +1,195 @@
+/* NOTE(agent): Reads a haversine_generator JSON file, computes the average haversine distance of all the pairs in
+   it, and (if given the matching answers file) checks every distance against the ones the generator computed.
+   
+   Usage: haversine_processor [-seconds count] [data_<count>_flex.json] [data_<count>_haveranswer.f64]
+   
+   The JSON parse time is always reported in MB/s. With -seconds, the parse is also run through the repetition
+   tester for that many seconds, to get a best-case number. Build with PROFILER=1 to see where the rest of the
+   time goes. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "profiler.cpp"
+#include "listing_0065_haversine_formula.cpp"
+#include "os_memory.cpp"
+#include "arena.cpp"
+#include "haversine_json.cpp"
+
+#define EARTH_RADIUS 6372.8
+
+static f64 SumHaversineDistances(haversine_pairs Pairs)
+{
+    TimeFunctionBandwidth(Pairs.Count*4*sizeof(f64));
+    
+    f64 Sum = 0;
+    
+    f64 SumCoef = 1 / (f64)Pairs.Count;
+    for(u64 PairIndex = 0; PairIndex < Pairs.Count; ++PairIndex)
+    {
+        f64 Dist = ReferenceHaversine(Pairs.X0[PairIndex], Pairs.Y0[PairIndex], Pairs.X1[PairIndex], Pairs.Y1[PairIndex],
+                                      EARTH_RADIUS);
+        Sum += SumCoef*Dist;
+    }
+    
+    return Sum;
+}
+
+static b32 Validate(haversine_pairs Pairs, f64 Average, buffer Answers)
+{
+    TimeFunction;
+    
+    b32 Result = false;
+    
+    u64 AnswerCount = Answers.Count / sizeof(f64);
+    if((AnswerCount == 0) || ((Answers.Count % sizeof(f64)) != 0))
+    {
+        fprintf(stderr, "ERROR: The answers file is not a list of f64s.\n");
+    }
+    else if((AnswerCount - 1) != Pairs.Count)
+    {
+        fprintf(stderr, "ERROR: The answers file has %llu distances, but the JSON has %llu pairs.\n", AnswerCount - 1, Pairs.Count);
+    }
+    else
+    {
+        f64 *Expected = (f64 *)Answers.Data;
+        
+        u64 MaxErrorIndex = 0;
+        f64 MaxError = 0;
+        for(u64 PairIndex = 0; PairIndex < Pairs.Count; ++PairIndex)
+        {
+            f64 Dist = ReferenceHaversine(Pairs.X0[PairIndex], Pairs.Y0[PairIndex], Pairs.X1[PairIndex], Pairs.Y1[PairIndex],
+                                          EARTH_RADIUS);
+            f64 Error = fabs(Dist - Expected[PairIndex]);
+            if(MaxError < Error)
+            {
+                MaxError = Error;
+                MaxErrorIndex = PairIndex;
+            }
+        }
+        
+        f64 ReferenceAverage = Expected[Pairs.Count];
+        
+        fprintf(stdout, "\nValidation:\n");
+        fprintf(stdout, "Reference average: %.16f\n", ReferenceAverage);
+        fprintf(stdout, "Difference: %.16f\n", Average - ReferenceAverage);
+        fprintf(stdout, "Largest distance difference: %.16f (pair %llu)\n", MaxError, MaxErrorIndex);
+        
+        Result = (MaxError <= MAX_DISTANCE_ERROR) && (fabs(Average - ReferenceAverage) <= MAX_DISTANCE_ERROR);
+        if(!Result)
+        {
+            fprintf(stderr, "ERROR: Distances do not match the answers file.\n");
+        }
+    }
+    
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    BeginProfile();
+    
+    u32 SecondsToTry = 0;
+    char *JSONFileName = 0;
+    char *AnswersFileName = 0;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else if(!JSONFileName)
+        {
+            JSONFileName = Arg;
+        }
+        else if(!AnswersFileName)
+        {
+            AnswersFileName = Arg;
+        }
+        else
+        {
+            JSONFileName = 0;
+            break;
+        }
+    }
+    
+    if(!JSONFileName)
+    {
+        fprintf(stderr, "USAGE: %s [-seconds count] [haversine_input.json] [answers.f64]\n", Args[0]);
+        return 1;
+    }
+    
+    int Result = 1;
+    
+    buffer InputJSON = ReadEntireFile(JSONFileName);
+    haversine_pairs Pairs = AllocatePairs(GetMaxPairCount(InputJSON.Count));
+    if(InputJSON.Data && Pairs.Memory.Data)
+    {
+        u64 ParseStart = ReadCPUTimer();
+        b32 Parsed;
+        {
+            TimeBandwidth("Parse", InputJSON.Count);
+            Parsed = ParseHaversinePairs(InputJSON, &Pairs);
+        }
+        u64 ParseElapsed = ReadCPUTimer() - ParseStart;
+        
+        if(Parsed)
+        {
+            f64 Average = SumHaversineDistances(Pairs);
+            
+            u64 CPUTimerFreq = GetCPUTimerFreq();
+            f64 Megabyte = 1024.0*1024.0;
+            f64 ParseSeconds = (f64)ParseElapsed / (f64)CPUTimerFreq;
+            
+            fprintf(stdout, "Input size: %llu\n", InputJSON.Count);
+            fprintf(stdout, "Pair count: %llu\n", Pairs.Count);
+            fprintf(stdout, "Haversine average: %.16f\n", Average);
+            fprintf(stdout, "Parse: %.4fms (%.2fMB/s)\n", 1000.0*ParseSeconds, ((f64)InputJSON.Count / Megabyte) / ParseSeconds);
+            
+            Result = 0;
+            
+            if(AnswersFileName)
+            {
+                buffer Answers = ReadEntireFile(AnswersFileName);
+                if(!Answers.Data || !Validate(Pairs, Average, Answers))
+                {
+                    Result = 1;
+                }
+                FreeBuffer(&Answers);
+            }
+            
+            if(SecondsToTry)
+            {
+                fprintf(stdout, "\n--- Parse (repetition tester) ---\n");
+                
+                repetition_tester Tester = {};
+                NewTestWave(&Tester, InputJSON.Count, CPUTimerFreq, SecondsToTry);
+                while(IsTesting(&Tester))
+                {
+                    BeginTime(&Tester);
+                    ParseHaversinePairs(InputJSON, &Pairs);
+                    EndTime(&Tester);
+                    CountBytes(&Tester, InputJSON.Count);
+                }
+            }
+        }
+    }
+    
+    FreePairs(&Pairs);
+    FreeBuffer(&InputJSON);
+    
+    EndAndPrintProfile(stdout);
+    
+    return Result;
+}
+
+ProfilerEndOfCompilationUnit;
@@ -0,0 +1,268 @@
+/* NOTE(agent): Large allocations straight from the OS, with a say in when (and how big) their pages get mapped.
+   A fresh allocation doesn't really have any memory behind it yet - each page gets mapped the first time it is
+   touched, and that page fault costs far more than the touch itself. A program that allocates a big buffer and
+   then times the first pass over it is mostly timing the OS. The policies are:
+   
+   lazy:     Nothing special. Pages fault in as they're touched.
+   forward:  Every page is touched once, front to back, before the memory is returned.
+   backward: The same, but back to front, which stops the OS from noticing a sequential pattern and mapping ahead.
+   populate: The OS maps every page when the memory is allocated (MAP_POPULATE), in one call instead of one
+             fault per page.
+   madvise:  Aligned to 2MB and marked with MADV_HUGEPAGE, so the OS can use transparent 2MB pages for it - one
+             fault per 2MB instead of one per 4KB, and far fewer TLB misses afterwards.
+   hugetlb:  Explicit 2MB pages (MAP_HUGETLB). These come out of a pool that has to be set up ahead of time
+             (vm.nr_hugepages on Linux), and it's usually empty.
+   
+   Not every policy exists everywhere. Windows has no MAP_POPULATE or transparent huge pages, so populate is done
+   as forward and madvise as lazy there, and its large pages need the "lock pages in memory" privilege. hugetlb
+   falls back to madvise on Linux and lazy on Windows when it can't get the pages. Either way, the os_memory
+   that comes back says which policy was really used.
+   
+   GetDefaultMemoryPolicy is what the allocators in the haversine code and sim86 use when they aren't given a
+   policy. It is lazy unless the MEMORY_POLICY environment variable is set to one of the names above. */
+
+#if _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#else
+
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << 26)
+#endif
+
+#endif
+
+#define OS_PAGE_SIZE 4096
+#define OS_HUGE_PAGE_SIZE (2*1024*1024)
+
+enum memory_policy
+{
+    MemoryPolicy_Lazy,
+    MemoryPolicy_TouchForward,
+    MemoryPolicy_TouchBackward,
+    MemoryPolicy_Populate,
+    MemoryPolicy_HugeAdvise,
+    MemoryPolicy_HugePages,
+    
+    MemoryPolicy_Count,
+};
+
+static char const *MemoryPolicyNames[] =
+{
+    "lazy",
+    "forward",
+    "backward",
+    "populate",
+    "madvise",
+    "hugetlb",
+};
+
+struct os_memory
+{
+    u8 *Data;
+    u64 Size;
+    
+    // NOTE(agent): Size rounded up to the page size that was actually used, and the policy that actually was
+    u64 MappedSize;
+    memory_policy Policy;
+};
+
+static u64 AlignOSMemorySize(u64 Size, u64 Alignment)
+{
+    u64 Result = (Size + Alignment - 1) & ~(Alignment - 1);
+    return Result;
+}
+
+static void TouchOSMemory(u8 *Data, u64 Size, b32 Backward)
+{
+    u64 PageCount = Size / OS_PAGE_SIZE;
+    for(u64 PageIndex = 0; PageIndex < PageCount; ++PageIndex)
+    {
+        u64 Page = Backward ? (PageCount - 1 - PageIndex) : PageIndex;
+        Data[Page*OS_PAGE_SIZE] = 0;
+    }
+}
+
+#if _WIN32
+
+static u8 *AllocateOSPages(u64 Size, memory_policy *Policy)
+{
+    u8 *Result = 0;
+    
+    if(*Policy == MemoryPolicy_HugePages)
+    {
+        u64 LargePageSize = GetLargePageMinimum();
+        if(LargePageSize)
+        {
+            Result = (u8 *)VirtualAlloc(0, AlignOSMemorySize(Size, LargePageSize), MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES, PAGE_READWRITE);
+        }
+        
+        if(!Result)
+        {
+            *Policy = MemoryPolicy_Lazy;
+        }
+    }
+    
+    if(*Policy == MemoryPolicy_Populate)
+    {
+        *Policy = MemoryPolicy_TouchForward;
+    }
+    
+    if(*Policy == MemoryPolicy_HugeAdvise)
+    {
+        *Policy = MemoryPolicy_Lazy;
+    }
+    
+    if(!Result)
+    {
+        Result = (u8 *)VirtualAlloc(0, Size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    }
+    
+    return Result;
+}
+
+static void FreeOSPages(u8 *Data, u64 MappedSize)
+{
+    VirtualFree(Data, 0, MEM_RELEASE);
+}
+
+#else
+
+static u8 *MapAnonymous(u64 Size, int ExtraFlags)
+{
+    u8 *Result = (u8 *)mmap(0, Size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|ExtraFlags, -1, 0);
+    if(Result == MAP_FAILED)
+    {
+        Result = 0;
+    }
+    
+    return Result;
+}
+
+static u8 *MapHugeAligned(u64 Size)
+{
+    // NOTE(agent): mmap only promises 4KB alignment, so this maps an extra 2MB and unmaps whatever sticks out
+    // on either side of the first 2MB boundary
+    u64 MapSize = Size + OS_HUGE_PAGE_SIZE;
+    u8 *Base = MapAnonymous(MapSize, 0);
+    u8 *Result = 0;
+    if(Base)
+    {
+        Result = (u8 *)AlignOSMemorySize((u64)Base, OS_HUGE_PAGE_SIZE);
+        u64 Head = Result - Base;
+        u64 Tail = MapSize - Head - Size;
+        if(Head)
+        {
+            munmap(Base, Head);
+        }
+        if(Tail)
+        {
+            munmap(Result + Size, Tail);
+        }
+    }
+    
+    return Result;
+}
+
+static u8 *AllocateOSPages(u64 Size, memory_policy *Policy)
+{
+    u8 *Result = 0;
+    
+    if(*Policy == MemoryPolicy_HugePages)
+    {
+        Result = MapAnonymous(Size, MAP_HUGETLB|MAP_HUGE_2MB);
+        if(!Result)
+        {
+            *Policy = MemoryPolicy_HugeAdvise;
+        }
+    }
+    
+    if(*Policy == MemoryPolicy_HugeAdvise)
+    {
+        Result = MapHugeAligned(Size);
+        if(Result)
+        {
+            madvise(Result, Size, MADV_HUGEPAGE);
+        }
+    }
+    else if(!Result)
+    {
+        Result = MapAnonymous(Size, (*Policy == MemoryPolicy_Populate) ? MAP_POPULATE : 0);
+    }
+    
+    return Result;
+}
+
+static void FreeOSPages(u8 *Data, u64 MappedSize)
+{
+    munmap(Data, MappedSize);
+}
+
+#endif
+
+static os_memory AllocateOSMemory(u64 Size, memory_policy Policy)
+{
+    os_memory Result = {};
+    
+    // NOTE(agent): Anything that might end up on 2MB pages is rounded up to whole 2MB pages, since that's what the
+    // OS will map anyway (and, for hugetlb, has to be unmapped in)
+    b32 MightBeHuge = ((Policy == MemoryPolicy_HugePages) || (Policy == MemoryPolicy_HugeAdvise));
+    u64 MappedSize = AlignOSMemorySize(Size ? Size : 1, MightBeHuge ? OS_HUGE_PAGE_SIZE : OS_PAGE_SIZE);
+    
+    Result.Data = AllocateOSPages(MappedSize, &Policy);
+    if(Result.Data)
+    {
+        Result.Size = Size;
+        Result.MappedSize = MappedSize;
+        Result.Policy = Policy;
+        
+        if((Policy == MemoryPolicy_TouchForward) || (Policy == MemoryPolicy_TouchBackward))
+        {
+            TouchOSMemory(Result.Data, MappedSize, (Policy == MemoryPolicy_TouchBackward));
+        }
+    }
+    
+    return Result;
+}
+
+static void FreeOSMemory(os_memory *Memory)
+{
+    if(Memory->Data)
+    {
+        FreeOSPages(Memory->Data, Memory->MappedSize);
+    }
+    
+    *Memory = {};
+}
+
+static b32 GetMemoryPolicyFromName(char const *Name, memory_policy *Policy)
+{
+    b32 Result = false;
+    for(u32 PolicyIndex = 0; PolicyIndex < MemoryPolicy_Count; ++PolicyIndex)
+    {
+        if(strcmp(Name, MemoryPolicyNames[PolicyIndex]) == 0)
+        {
+            *Policy = (memory_policy)PolicyIndex;
+            Result = true;
+        }
+    }
+    
+    return Result;
+}
+
+static memory_policy GetDefaultMemoryPolicy(void)
+{
+    memory_policy Result = MemoryPolicy_Lazy;
+    
+    char const *Name = getenv("MEMORY_POLICY");
+    if(Name && !GetMemoryPolicyFromName(Name, &Result))
+    {
+        fprintf(stderr, "ERROR: Unknown MEMORY_POLICY \"%s\" - using lazy instead.\n", Name);
+    }
+    
+    return Result;
+}
@@ -0,0 +1,90 @@
+/* NOTE(agent): The little bit of threading the haversine code needs (start threads, wait for them, bump a counter
+   atomically), straight from the OS. A thread procedure is declared with THREAD_PROC, so that the same function
+   works with both CreateThread and pthread_create, and returns 0. On Linux, older versions of glibc require
+   -pthread when linking. */
+
+#if _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef HANDLE os_thread;
+
+#define THREAD_PROC(Name) DWORD WINAPI Name(LPVOID Param)
+
+static u32 AtomicIncrementU32(u32 volatile *Value)
+{
+    u32 Result = (u32)InterlockedIncrement((LONG volatile *)Value) - 1;
+    return Result;
+}
+
+static void YieldThread(void)
+{
+    SwitchToThread();
+}
+
+static u32 GetProcessorCount(void)
+{
+    SYSTEM_INFO Info = {};
+    GetSystemInfo(&Info);
+    u32 Result = Info.dwNumberOfProcessors;
+    return Result;
+}
+
+#define CompilerBarrier() _ReadWriteBarrier()
+
+#else
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+typedef pthread_t os_thread;
+
+#define THREAD_PROC(Name) void *Name(void *Param)
+
+static u32 AtomicIncrementU32(u32 volatile *Value)
+{
+    u32 Result = __sync_fetch_and_add(Value, 1);
+    return Result;
+}
+
+static void YieldThread(void)
+{
+    sched_yield();
+}
+
+static u32 GetProcessorCount(void)
+{
+    long Count = sysconf(_SC_NPROCESSORS_ONLN);
+    u32 Result = (Count > 0) ? (u32)Count : 1;
+    return Result;
+}
+
+#define CompilerBarrier() asm volatile("" ::: "memory")
+
+#endif
+
+typedef THREAD_PROC(thread_proc);
+
+static b32 StartThread(os_thread *Thread, thread_proc *Proc, void *Param)
+{
+#if _WIN32
+    *Thread = CreateThread(0, 0, Proc, Param, 0, 0);
+    b32 Result = (*Thread != 0);
+#else
+    b32 Result = (pthread_create(Thread, 0, Proc, Param) == 0);
+#endif
+
+    return Result;
+}
+
+static void JoinThread(os_thread Thread)
+{
+#if _WIN32
+    WaitForSingleObject(Thread, INFINITE);
+    CloseHandle(Thread);
+#else
+    pthread_join(Thread, 0);
+#endif
+}
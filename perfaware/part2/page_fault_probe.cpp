@@ -0,0 +1,142 @@
+/* NOTE(agent): Allocates PageCount 4KB pages with each os_memory policy, then writes one byte to every page, and
+   reports what the allocation and the touching each cost - in time, and in page faults as the OS counts them.
+   
+   Usage: page_fault_probe [-pages count] [-runs count]
+   
+   Each policy is run -runs times (fresh memory every time), and the run with the lowest total time is the one
+   reported. The "Used" column is the policy os_memory actually ended up using, which is not always the one that
+   was asked for (see os_memory.cpp) - hugetlb in particular needs huge pages reserved ahead of time.
+   
+   The interesting comparison is the total per page: moving the faults from the touch into the allocation only
+   helps if the allocation does them more cheaply (populate, and 2MB pages), not if it just does them earlier
+   (forward and backward). Fault counts include both soft faults and hard ones (see platform_metrics.cpp). */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "os_memory.cpp"
+
+struct probe_result
+{
+    memory_policy UsedPolicy;
+    
+    u64 AllocTime;
+    u64 AllocFaults;
+    u64 TouchTime;
+    u64 TouchFaults;
+};
+
+static probe_result ProbePolicy(u64 PageCount, memory_policy Policy)
+{
+    probe_result Result = {};
+    
+    u64 StartFaults = ReadOSPageFaultCount();
+    u64 StartTime = ReadCPUTimer();
+    
+    os_memory Memory = AllocateOSMemory(PageCount*OS_PAGE_SIZE, Policy);
+    
+    u64 AllocTime = ReadCPUTimer();
+    u64 AllocFaults = ReadOSPageFaultCount();
+    
+    if(Memory.Data)
+    {
+        for(u64 PageIndex = 0; PageIndex < PageCount; ++PageIndex)
+        {
+            Memory.Data[PageIndex*OS_PAGE_SIZE] = (u8)PageIndex;
+        }
+    }
+    
+    u64 TouchTime = ReadCPUTimer();
+    u64 TouchFaults = ReadOSPageFaultCount();
+    
+    Result.UsedPolicy = Memory.Policy;
+    Result.AllocTime = AllocTime - StartTime;
+    Result.AllocFaults = AllocFaults - StartFaults;
+    Result.TouchTime = TouchTime - AllocTime;
+    Result.TouchFaults = TouchFaults - AllocFaults;
+    
+    if(!Memory.Data)
+    {
+        Result.UsedPolicy = MemoryPolicy_Count;
+    }
+    
+    FreeOSMemory(&Memory);
+    
+    return Result;
+}
+
+int main(int ArgCount, char **Args)
+{
+    u64 PageCount = 32768;
+    u32 RunCount = 10;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-pages") == 0))
+        {
+            PageCount = strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(HasValue && (strcmp(Arg, "-runs") == 0))
+        {
+            RunCount = atoi(Args[++ArgIndex]);
+        }
+        else
+        {
+            PageCount = 0;
+            break;
+        }
+    }
+    
+    if(!PageCount || !RunCount)
+    {
+        fprintf(stderr, "USAGE: %s [-pages count] [-runs count]\n", Args[0]);
+        return 1;
+    }
+    
+    u64 CPUTimerFreq = EstimateCPUTimerFreq(100);
+    f64 MillisecondsPerTick = 1000.0 / (f64)CPUTimerFreq;
+    f64 NanosecondsPerTick = 1000000000.0 / (f64)CPUTimerFreq;
+    
+    fprintf(stdout, "Pages: %llu (%llumb)\n\n", PageCount, (PageCount*OS_PAGE_SIZE) / (1024*1024));
+    fprintf(stdout, "%-9s %-9s %10s %10s %10s %10s %10s %12s\n",
+            "Policy", "Used", "Alloc ms", "Faults", "Touch ms", "Faults", "ns/page", "Faults/page");
+    
+    int Result = 0;
+    for(u32 Policy = 0; Policy < MemoryPolicy_Count; ++Policy)
+    {
+        probe_result Best = {};
+        u64 BestTotal = (u64)-1;
+        for(u32 RunIndex = 0; RunIndex < RunCount; ++RunIndex)
+        {
+            probe_result Run = ProbePolicy(PageCount, (memory_policy)Policy);
+            u64 Total = Run.AllocTime + Run.TouchTime;
+            if(BestTotal > Total)
+            {
+                BestTotal = Total;
+                Best = Run;
+            }
+        }
+        
+        if(Best.UsedPolicy == MemoryPolicy_Count)
+        {
+            fprintf(stderr, "ERROR: Unable to allocate %llu pages with the %s policy.\n", PageCount, MemoryPolicyNames[Policy]);
+            Result = 1;
+            continue;
+        }
+        
+        fprintf(stdout, "%-9s %-9s %10.3f %10llu %10.3f %10llu %10.1f %12.4f\n",
+                MemoryPolicyNames[Policy], MemoryPolicyNames[Best.UsedPolicy],
+                MillisecondsPerTick*(f64)Best.AllocTime, Best.AllocFaults,
+                MillisecondsPerTick*(f64)Best.TouchTime, Best.TouchFaults,
+                NanosecondsPerTick*(f64)BestTotal / (f64)PageCount,
+                (f64)(Best.AllocFaults + Best.TouchFaults) / (f64)PageCount);
+    }
+    
+    return Result;
+}
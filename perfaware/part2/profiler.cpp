@@ -0,0 +1,168 @@
+/* NOTE(agent): A nested block profiler. Put TimeFunction at the top of a function, or TimeBlock("Name") at the top
+   of any other scope, and the time spent in that scope is added to an anchor for that spot in the code. The
+   TimeBandwidth/TimeFunctionBandwidth versions also take how many bytes the block processes, so the report can
+   say how fast it went.
+   
+   Every anchor gets both an exclusive time (time in the block, minus the time in any blocks nested inside it)
+   and an inclusive time (time in the block including everything inside it). Recursion is handled by having each
+   block remember what its anchor's inclusive time was when it started, and overwrite it when it ends, so only
+   the outermost of several nested blocks for the same anchor ends up counting.
+   
+   Anchors are picked with __COUNTER__, so the anchor table is fixed size, there is no lookup, and nothing is
+   ever allocated. Each block costs two reads of the CPU timer and a few adds. Put ProfilerEndOfCompilationUnit
+   at the end of the program's (single) translation unit to check that the table was big enough.
+   
+   This profiler is not thread-safe - it should only be used for code that runs on one thread.
+   
+   When PROFILER is 0 (the default), all of the macros expand to nothing, so there is no cost at all, and this file
+   doesn't need anything else. When PROFILER is 1, ReadCPUTimer and EstimateCPUTimerFreq from
+   part1/platform_metrics.cpp have to be included first. BeginProfile() goes at the start of the program, and
+   EndAndPrintProfile(Dest) at the end prints the results to Dest. */
+
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#if PROFILER
+
+#define MAX_PROFILE_ANCHORS 4096
+
+struct profile_anchor
+{
+    u64 TSCElapsedExclusive; // NOTE(agent): Does NOT include children
+    u64 TSCElapsedInclusive; // NOTE(agent): DOES include children
+    u64 HitCount;
+    u64 ProcessedByteCount;
+    char const *Label;
+};
+
+struct profiler
+{
+    // NOTE(agent): Anchor 0 is never used for a block - it is the "parent" of blocks that aren't inside any other
+    profile_anchor Anchors[MAX_PROFILE_ANCHORS];
+    
+    u64 StartTSC;
+    u64 EndTSC;
+};
+
+static profiler GlobalProfiler;
+static u32 GlobalProfilerParent;
+
+struct profile_block
+{
+    profile_block(char const *Label_, u32 AnchorIndex_, u64 ByteCount)
+    {
+        ParentIndex = GlobalProfilerParent;
+        
+        AnchorIndex = AnchorIndex_;
+        Label = Label_;
+        
+        profile_anchor *Anchor = GlobalProfiler.Anchors + AnchorIndex;
+        OldTSCElapsedInclusive = Anchor->TSCElapsedInclusive;
+        Anchor->ProcessedByteCount += ByteCount;
+        
+        GlobalProfilerParent = AnchorIndex;
+        StartTSC = ReadCPUTimer();
+    }
+    
+    ~profile_block(void)
+    {
+        u64 Elapsed = ReadCPUTimer() - StartTSC;
+        GlobalProfilerParent = ParentIndex;
+        
+        profile_anchor *Parent = GlobalProfiler.Anchors + ParentIndex;
+        profile_anchor *Anchor = GlobalProfiler.Anchors + AnchorIndex;
+        
+        // NOTE(agent): The parent's exclusive time can go "negative" here, but it always ends up positive once
+        // the parent block itself ends and adds its whole elapsed time back in.
+        Parent->TSCElapsedExclusive -= Elapsed;
+        Anchor->TSCElapsedExclusive += Elapsed;
+        Anchor->TSCElapsedInclusive = OldTSCElapsedInclusive + Elapsed;
+        ++Anchor->HitCount;
+        
+        // NOTE(agent): The label is written on every hit, because C++ has no easy way to fill it in once at compile time
+        Anchor->Label = Label;
+    }
+    
+    char const *Label;
+    u64 OldTSCElapsedInclusive;
+    u64 StartTSC;
+    u32 ParentIndex;
+    u32 AnchorIndex;
+};
+
+#define NameConcat2(A, B) A##B
+#define NameConcat(A, B) NameConcat2(A, B)
+#define TimeBandwidth(Name, ByteCount) profile_block NameConcat(Block, __LINE__)(Name, __COUNTER__ + 1, ByteCount)
+#define TimeBlock(Name) TimeBandwidth(Name, 0)
+#define TimeFunctionBandwidth(ByteCount) TimeBandwidth(__func__, ByteCount)
+#define TimeFunction TimeBlock(__func__)
+
+#define ProfilerEndOfCompilationUnit \
+    static_assert(__COUNTER__ < MAX_PROFILE_ANCHORS, "Number of profile points exceeds MAX_PROFILE_ANCHORS")
+
+static void PrintTimeElapsed(u64 TotalTSCElapsed, u64 TimerFreq, profile_anchor *Anchor, FILE *Dest)
+{
+    f64 Percent = 100.0 * ((f64)Anchor->TSCElapsedExclusive / (f64)TotalTSCElapsed);
+    fprintf(Dest, "  %s[%llu]: %llu (%.2f%%", Anchor->Label, Anchor->HitCount, Anchor->TSCElapsedExclusive, Percent);
+    if(Anchor->TSCElapsedInclusive != Anchor->TSCElapsedExclusive)
+    {
+        f64 PercentWithChildren = 100.0 * ((f64)Anchor->TSCElapsedInclusive / (f64)TotalTSCElapsed);
+        fprintf(Dest, ", %.2f%% w/children", PercentWithChildren);
+    }
+    fprintf(Dest, ")");
+    
+    if(Anchor->ProcessedByteCount && TimerFreq)
+    {
+        f64 Megabyte = 1024.0*1024.0;
+        f64 Gigabyte = Megabyte*1024.0;
+        
+        f64 Seconds = (f64)Anchor->TSCElapsedInclusive / (f64)TimerFreq;
+        f64 BytesPerSecond = (f64)Anchor->ProcessedByteCount / Seconds;
+        f64 Megabytes = (f64)Anchor->ProcessedByteCount / Megabyte;
+        f64 GigabytesPerSecond = BytesPerSecond / Gigabyte;
+        
+        fprintf(Dest, "  %.3fmb at %.2fgb/s", Megabytes, GigabytesPerSecond);
+    }
+    
+    fprintf(Dest, "\n");
+}
+
+static void BeginProfile(void)
+{
+    GlobalProfiler.StartTSC = ReadCPUTimer();
+}
+
+static void EndAndPrintProfile(FILE *Dest)
+{
+    GlobalProfiler.EndTSC = ReadCPUTimer();
+    u64 CPUFreq = EstimateCPUTimerFreq(100);
+    
+    u64 TotalCPUElapsed = GlobalProfiler.EndTSC - GlobalProfiler.StartTSC;
+    
+    if(CPUFreq)
+    {
+        fprintf(Dest, "\nTotal time: %0.4fms (CPU freq %llu)\n", 1000.0 * (f64)TotalCPUElapsed / (f64)CPUFreq, CPUFreq);
+    }
+    
+    for(u32 AnchorIndex = 0; AnchorIndex < MAX_PROFILE_ANCHORS; ++AnchorIndex)
+    {
+        profile_anchor *Anchor = GlobalProfiler.Anchors + AnchorIndex;
+        if(Anchor->TSCElapsedInclusive)
+        {
+            PrintTimeElapsed(TotalCPUElapsed, CPUFreq, Anchor, Dest);
+        }
+    }
+}
+
+#else
+
+#define TimeBandwidth(...)
+#define TimeBlock(...)
+#define TimeFunctionBandwidth(...)
+#define TimeFunction
+#define ProfilerEndOfCompilationUnit
+#define BeginProfile(...)
+#define EndAndPrintProfile(...)
+
+#endif
@@ -0,0 +1,64 @@
+/* NOTE(agent): The pseudo-random number generator shared by haversine_generator and the tests and reports that
+   make up their own inputs. Include it after platform_metrics.cpp, which has the integer and float types.
+   
+   The same seed always gives the same series on every compiler and platform, which is what keeps
+   haversine_generator's output files reproducible from just the seed on the command line. */
+
+struct random_series
+{
+    // NOTE(agent): This is Bob Jenkins' "small noncryptographic PRNG", which is fast and more than random enough here
+    u64 A, B, C, D;
+};
+
+static u64 RotateLeft(u64 V, int Shift)
+{
+    u64 Result = (V << Shift) | (V >> (64 - Shift));
+    return Result;
+}
+
+static u64 RandomU64(random_series *Series)
+{
+    u64 A = Series->A;
+    u64 B = Series->B;
+    u64 C = Series->C;
+    u64 D = Series->D;
+    
+    u64 E = A - RotateLeft(B, 27);
+    
+    A = (B ^ RotateLeft(C, 17));
+    B = (C + D);
+    C = (D + E);
+    D = (E + A);
+    
+    Series->A = A;
+    Series->B = B;
+    Series->C = C;
+    Series->D = D;
+    
+    return D;
+}
+
+static random_series Seed(u64 Value)
+{
+    random_series Series = {};
+    
+    Series.A = 0xf1ea5eed;
+    Series.B = Value;
+    Series.C = Value;
+    Series.D = Value;
+    
+    u32 Count = 20;
+    while(Count--)
+    {
+        RandomU64(&Series);
+    }
+    
+    return Series;
+}
+
+static f64 RandomInRange(random_series *Series, f64 Min, f64 Max)
+{
+    f64 t = (f64)RandomU64(Series) / (f64)(u64)-1;
+    f64 Result = (1.0 - t)*Min + t*Max;
+    return Result;
+}
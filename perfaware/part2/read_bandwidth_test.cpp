@@ -0,0 +1,407 @@
+/* NOTE(agent): Reads a whole file over and over through the repetition tester, in every way we might want to read
+   input, to see which one is fastest on this machine before building an input stage around it:
+   
+   fread:    The CRT, one fread per buffer.
+   read:     The OS's read call (_read on Windows), one per buffer.
+   mmap:     The whole file mapped, with one byte of every page touched so that each page really is faulted in.
+   io_uring: file_reader's io_uring backend, with the buffer size as the block size (Linux only).
+   
+   Each one is run with buffer sizes from -min to -max kilobytes (4KB and 1GB by default, going up by 4x), and
+   with three kinds of buffer:
+   
+   reused:   One buffer, allocated and faulted in before timing starts, used for every run.
+   fresh:    Mapped from the OS at the start of every run and unmapped at the end, so it gets new pages (and
+             faults on them as the reads touch them) every time. malloc would keep handing back the same pages
+             for anything but the largest sizes, which is the reused case again.
+   populate: Freshly mapped every run, with the OS asked to fault in every page at once (MAP_POPULATE). Windows
+             has no such option for allocations, so there it is touched by hand, a page at a time.
+   
+   All three come from os_memory.cpp: reused and populate with the populate policy, fresh with the lazy one.
+   
+   mmap only has the lazy (fault on touch) and populate versions, and io_uring always uses file_reader's own
+   buffers, so those aren't swept over buffer kinds. The allocation, opening the file, and freeing and closing at
+   the end are all timed along with the reads, since a program reading its input pays for all of them.
+   
+   Usage: read_bandwidth_test [-seconds count] [-min kilobytes] [-max kilobytes] [data file]
+   
+   Note that mmap only touches one byte per page, so it measures what it costs to get the file mapped, not what
+   it costs to read all of it - unlike the others, which copy every byte into the buffer.
+   
+   Every test reports its fastest run in GB/s, the page faults during that run, and the average page faults per
+   run. The file will be in the OS's page cache after the first run, so this is reading from memory, not disk -
+   see file_reader_report for cold reads. */
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "repetition_tester.cpp"
+#include "os_memory.cpp"
+#include "file_reader.cpp"
+
+#if _WIN32
+#include <io.h>
+#endif
+
+#define ArrayCount(Array) (sizeof(Array)/sizeof((Array)[0]))
+
+#define MIN_BUFFER_SIZE (4ULL*1024)
+#define MAX_BUFFER_SIZE (1024ULL*1024*1024)
+
+enum allocation_type
+{
+    AllocType_Reused,
+    AllocType_Fresh,
+    AllocType_Populate,
+    
+    AllocType_Count,
+};
+
+static char const *AllocTypeNames[] =
+{
+    "reused",
+    "fresh",
+    "populate",
+};
+
+struct read_parameters
+{
+    char *FileName;
+    u64 FileSize;
+    u64 BufferSize;
+    allocation_type AllocType;
+    
+    os_memory ReusedBuffer;
+};
+
+typedef b32 read_test_function(read_parameters *Params);
+
+struct read_test
+{
+    char const *Name;
+    read_test_function *Function;
+    b32 SweepsBufferSize;
+    b32 SweepsAllocType;
+};
+
+static os_memory HandleAllocation(read_parameters *Params)
+{
+    os_memory Result = {};
+    switch(Params->AllocType)
+    {
+        case AllocType_Reused: {Result = Params->ReusedBuffer;} break;
+        case AllocType_Fresh: {Result = AllocateOSMemory(Params->BufferSize, MemoryPolicy_Lazy);} break;
+        case AllocType_Populate: {Result = AllocateOSMemory(Params->BufferSize, MemoryPolicy_Populate);} break;
+        default: {} break;
+    }
+    
+    if(!Result.Data)
+    {
+        fprintf(stderr, "ERROR: Unable to allocate a %llu byte buffer.\n", Params->BufferSize);
+    }
+    
+    return Result;
+}
+
+static void HandleDeallocation(read_parameters *Params, os_memory *Buffer)
+{
+    if(Params->AllocType != AllocType_Reused)
+    {
+        FreeOSMemory(Buffer);
+    }
+}
+
+static b32 ReadViaFRead(read_parameters *Params)
+{
+    b32 Result = false;
+    
+    FILE *File = fopen(Params->FileName, "rb");
+    os_memory Buffer = HandleAllocation(Params);
+    if(File && Buffer.Data)
+    {
+        // NOTE(agent): The CRT's own buffering would just add a copy for reads this large
+        setvbuf(File, 0, _IONBF, 0);
+        
+        u64 TotalRead = 0;
+        for(;;)
+        {
+            size_t BytesRead = fread(Buffer.Data, 1, Params->BufferSize, File);
+            TotalRead += BytesRead;
+            if(BytesRead < Params->BufferSize)
+            {
+                break;
+            }
+        }
+        
+        Result = (TotalRead == Params->FileSize);
+    }
+    
+    HandleDeallocation(Params, &Buffer);
+    if(File)
+    {
+        fclose(File);
+    }
+    
+    return Result;
+}
+
+static b32 ReadViaRead(read_parameters *Params)
+{
+    b32 Result = false;
+
+#if _WIN32
+    int File = _open(Params->FileName, _O_BINARY|_O_RDONLY);
+#else
+    int File = open(Params->FileName, O_RDONLY);
+#endif
+    os_memory Buffer = HandleAllocation(Params);
+    if((File != -1) && Buffer.Data)
+    {
+        u64 TotalRead = 0;
+        for(;;)
+        {
+#if _WIN32
+            int BytesRead = _read(File, Buffer.Data, (u32)Params->BufferSize);
+#else
+            ssize_t BytesRead = read(File, Buffer.Data, Params->BufferSize);
+#endif
+            if(BytesRead <= 0)
+            {
+                break;
+            }
+            
+            TotalRead += BytesRead;
+        }
+        
+        Result = (TotalRead == Params->FileSize);
+    }
+    
+    HandleDeallocation(Params, &Buffer);
+    if(File != -1)
+    {
+#if _WIN32
+        _close(File);
+#else
+        close(File);
+#endif
+    }
+    
+    return Result;
+}
+
+static b32 ReadViaFileReader(read_parameters *Params, file_read_backend Backend, u32 Flags, u32 QueueDepth)
+{
+    file_reader Reader;
+    if(!OpenFileReader(&Reader, Params->FileName, Backend, Flags, Params->BufferSize, QueueDepth))
+    {
+        return false;
+    }
+    
+    // NOTE(agent): The touch is one byte per page, which is all mmap needs to fault every page in, and keeps
+    // this from turning into a test of how fast the consumer can add
+    u64 TotalRead = 0;
+    u8 volatile Sink = 0;
+    file_block Block;
+    while(NextFileBlock(&Reader, &Block))
+    {
+        u8 Touch = 0;
+        for(u64 Offset = 0; Offset < Block.Count; Offset += 4096)
+        {
+            Touch += Block.Data[Offset];
+        }
+        Sink += Touch;
+        
+        TotalRead += Block.Count;
+        ReleaseFileBlock(&Reader, &Block);
+    }
+    
+    b32 Result = (!Reader.Failed && (TotalRead == Params->FileSize));
+    CloseFileReader(&Reader);
+    
+    return Result;
+}
+
+static b32 ReadViaMMap(read_parameters *Params)
+{
+    b32 Result = ReadViaFileReader(Params, FileRead_MMap, 0, 1);
+    return Result;
+}
+
+static b32 ReadViaMMapPopulate(read_parameters *Params)
+{
+    b32 Result = ReadViaFileReader(Params, FileRead_MMap, FileReaderFlag_Populate, 1);
+    return Result;
+}
+
+static b32 ReadViaIOUring(read_parameters *Params)
+{
+    // NOTE(agent): Four reads in flight, but never more than a gigabyte of buffers
+    u32 QueueDepth = 4;
+    while((QueueDepth > 1) && ((QueueDepth*Params->BufferSize) > MAX_BUFFER_SIZE))
+    {
+        QueueDepth /= 2;
+    }
+    
+    b32 Result = ReadViaFileReader(Params, FileRead_IOUring, 0, QueueDepth);
+    return Result;
+}
+
+static read_test const ReadTests[] =
+{
+    {"fread", ReadViaFRead, true, true},
+    {"read", ReadViaRead, true, true},
+    {"mmap", ReadViaMMap, false, false},
+    {"mmap", ReadViaMMapPopulate, false, false},
+    {"io_uring", ReadViaIOUring, true, false},
+};
+
+int main(int ArgCount, char **Args)
+{
+    u32 SecondsToTry = 3;
+    u64 MinBufferSize = MIN_BUFFER_SIZE;
+    u64 MaxBufferSize = MAX_BUFFER_SIZE;
+    char *FileName = 0;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        b32 HasValue = ((ArgIndex + 1) < ArgCount);
+        if(HasValue && (strcmp(Arg, "-seconds") == 0))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else if(HasValue && (strcmp(Arg, "-min") == 0))
+        {
+            MinBufferSize = 1024*strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(HasValue && (strcmp(Arg, "-max") == 0))
+        {
+            MaxBufferSize = 1024*strtoull(Args[++ArgIndex], 0, 10);
+        }
+        else if(!FileName)
+        {
+            FileName = Arg;
+        }
+        else
+        {
+            FileName = 0;
+            break;
+        }
+    }
+    
+    if(!FileName || (MinBufferSize < FILE_READER_ALIGNMENT) || (MinBufferSize % FILE_READER_ALIGNMENT) ||
+       (MaxBufferSize < MinBufferSize) || (MaxBufferSize > MAX_BUFFER_SIZE))
+    {
+        fprintf(stderr, "USAGE: %s [-seconds count] [-min kilobytes] [-max kilobytes] [data file]\n", Args[0]);
+        fprintf(stderr, "       (buffer sizes are multiples of 4 kilobytes, up to 1 gigabyte)\n");
+        return 1;
+    }
+    
+    file_reader SizeReader;
+    if(!OpenFileReader(&SizeReader, FileName, FileRead_MMap))
+    {
+        return 1;
+    }
+    u64 FileSize = SizeReader.FileSize;
+    CloseFileReader(&SizeReader);
+    
+    if(!FileSize)
+    {
+        fprintf(stderr, "ERROR: \"%s\" is empty.\n", FileName);
+        return 1;
+    }
+    
+    int Result = 0;
+    
+    u64 CPUTimerFreq = GetCPUTimerFreq();
+    f64 Gigabyte = 1024.0*1024.0*1024.0;
+    
+    fprintf(stdout, "File size: %llu bytes\n\n", FileSize);
+    fprintf(stdout, "%-10s %-9s %10s %10s %8s %10s %12s\n", "Test", "Buffer", "Size (kb)", "ms", "GB/s", "Faults", "Faults/run");
+    
+    for(u32 TestIndex = 0; TestIndex < ArrayCount(ReadTests); ++TestIndex)
+    {
+        read_test Test = ReadTests[TestIndex];
+        
+        // NOTE(agent): Buffers larger than the file are just the file size again, so the sweep stops at the first
+        // size that holds the whole thing
+        for(u64 BufferSize = MinBufferSize; BufferSize <= MaxBufferSize; BufferSize *= 4)
+        {
+            u32 AllocTypeCount = Test.SweepsAllocType ? AllocType_Count : 1;
+            for(u32 AllocType = 0; AllocType < AllocTypeCount; ++AllocType)
+            {
+                read_parameters Params = {};
+                Params.FileName = FileName;
+                Params.FileSize = FileSize;
+                Params.BufferSize = Test.SweepsBufferSize ? BufferSize : MaxBufferSize;
+                Params.AllocType = (allocation_type)AllocType;
+                
+                char const *BufferName = AllocTypeNames[AllocType];
+                if(!Test.SweepsAllocType)
+                {
+                    BufferName = (Test.Function == ReadViaMMap) ? "lazy" : (Test.Function == ReadViaMMapPopulate) ? "populate" : "reader";
+                }
+                
+                if(AllocType == AllocType_Reused)
+                {
+                    Params.ReusedBuffer = AllocateOSMemory(Params.BufferSize, MemoryPolicy_Populate);
+                    if(!Params.ReusedBuffer.Data)
+                    {
+                        fprintf(stderr, "ERROR: Unable to allocate a %llu byte buffer.\n", Params.BufferSize);
+                        Result = 1;
+                        continue;
+                    }
+                }
+                
+                repetition_tester Tester = {};
+                NewTestWave(&Tester, FileSize, CPUTimerFreq, SecondsToTry);
+                Tester.PrintNewMinimums = false;
+                while(IsTesting(&Tester))
+                {
+                    BeginTime(&Tester);
+                    b32 Succeeded = Test.Function(&Params);
+                    EndTime(&Tester);
+                    
+                    if(!Succeeded)
+                    {
+                        Error(&Tester, "Unable to read the whole file");
+                        Result = 1;
+                        break;
+                    }
+                    
+                    CountBytes(&Tester, FileSize);
+                }
+                
+                FreeOSMemory(&Params.ReusedBuffer);
+                
+                repetition_test_results Results = Tester.Results;
+                if(Results.Total.E[RepValue_TestCount])
+                {
+                    f64 Seconds = SecondsFromCPUTime((f64)Results.Min.E[RepValue_CPUTimer], CPUTimerFreq);
+                    f64 FaultsPerRun = (f64)Results.Total.E[RepValue_PageFaults] / (f64)Results.Total.E[RepValue_TestCount];
+                    if(Test.SweepsBufferSize)
+                    {
+                        fprintf(stdout, "%-10s %-9s %10llu", Test.Name, BufferName, Params.BufferSize / 1024);
+                    }
+                    else
+                    {
+                        fprintf(stdout, "%-10s %-9s %10s", Test.Name, BufferName, "-");
+                    }
+                    fprintf(stdout, " %10.2f %8.3f %10llu %12.1f\n", 1000.0*Seconds, ((f64)FileSize / Gigabyte) / Seconds,
+                            Results.Min.E[RepValue_PageFaults], FaultsPerRun);
+                }
+            }
+            
+            if(!Test.SweepsBufferSize || (BufferSize >= FileSize))
+            {
+                break;
+            }
+        }
+    }
+    
+    return Result;
+}
@@ -0,0 +1,273 @@
+/* NOTE(agent): A repetition tester runs the same piece of code over and over, keeping track of the fastest, slowest,
+   and average time it took. Rather than running a fixed number of times, it keeps going until it has gone
+   SecondsToTry seconds without seeing a new fastest time, which is a good sign that the fastest time it has is as
+   good as this machine is going to do. Each run also records how many page faults the OS reported during it,
+   since a run that faults is usually measuring the OS more than the code.
+   
+   It needs ReadCPUTimer, EstimateCPUTimerFreq, and ReadOSPageFaultCount from part1/platform_metrics.cpp, which has
+   to be included first. Everything is static, so it can be included in anything that includes platform_metrics.cpp
+   (the haversine code, the part1 sum benchmarks, or sim86 tools). Usage looks like this:
+   
+   repetition_tester Tester = {};
+   for(;;) // NOTE(agent): Optional, to keep re-running the test to see if anything changes
+   {
+       NewTestWave(&Tester, ByteCount, GetCPUTimerFreq());
+       while(IsTesting(&Tester))
+       {
+           BeginTime(&Tester);
+           // ... the code being tested ...
+           EndTime(&Tester);
+           CountBytes(&Tester, ByteCount);
+       }
+   }
+   
+   BeginTime/EndTime can be called more than once per run, in which case only the time between them counts
+   (so setup code in the loop doesn't get timed). Every run must count exactly ByteCount bytes, which is mostly
+   there to catch tests that accidentally skip part of their work. */
+
+enum repetition_value_type
+{
+    RepValue_TestCount,
+    
+    RepValue_CPUTimer,
+    RepValue_PageFaults,
+    RepValue_ByteCount,
+    
+    RepValue_Count,
+};
+
+struct repetition_value
+{
+    u64 E[RepValue_Count];
+};
+
+struct repetition_test_results
+{
+    repetition_value Total;
+    repetition_value Min;
+    repetition_value Max;
+};
+
+enum repetition_test_mode
+{
+    TestMode_Uninitialized,
+    TestMode_Testing,
+    TestMode_Completed,
+    TestMode_Error,
+};
+
+struct repetition_tester
+{
+    u64 TargetProcessedByteCount;
+    u64 CPUTimerFreq;
+    u64 TryForTime;
+    u64 TestsStartedAt;
+    
+    repetition_test_mode Mode;
+    b32 PrintNewMinimums;
+    u32 OpenBlockCount;
+    u32 CloseBlockCount;
+    
+    repetition_value AccumulatedOnThisTest;
+    repetition_test_results Results;
+};
+
+static u64 GetCPUTimerFreq(void)
+{
+    // NOTE(agent): Measuring the CPU timer takes a tenth of a second, so it is only done once per run of the program
+    static u64 CPUTimerFreq;
+    if(!CPUTimerFreq)
+    {
+        CPUTimerFreq = EstimateCPUTimerFreq(100);
+    }
+    
+    return CPUTimerFreq;
+}
+
+static f64 SecondsFromCPUTime(f64 CPUTime, u64 CPUTimerFreq)
+{
+    f64 Result = 0.0;
+    if(CPUTimerFreq)
+    {
+        Result = (CPUTime / (f64)CPUTimerFreq);
+    }
+    
+    return Result;
+}
+
+static void PrintValue(char const *Label, repetition_value Value, u64 CPUTimerFreq)
+{
+    u64 TestCount = Value.E[RepValue_TestCount];
+    f64 Divisor = TestCount ? (f64)TestCount : 1;
+    
+    f64 E[RepValue_Count];
+    for(u32 EIndex = 0; EIndex < RepValue_Count; ++EIndex)
+    {
+        E[EIndex] = (f64)Value.E[EIndex] / Divisor;
+    }
+    
+    printf("%s: %.0f", Label, E[RepValue_CPUTimer]);
+    if(CPUTimerFreq)
+    {
+        f64 Seconds = SecondsFromCPUTime(E[RepValue_CPUTimer], CPUTimerFreq);
+        printf(" (%fms)", 1000.0f*Seconds);
+        
+        if(E[RepValue_ByteCount] > 0)
+        {
+            f64 Gigabyte = (1024.0f * 1024.0f * 1024.0f);
+            f64 Bandwidth = E[RepValue_ByteCount] / (Gigabyte * Seconds);
+            printf(" %fgb/s", Bandwidth);
+        }
+    }
+    
+    if(E[RepValue_PageFaults] > 0)
+    {
+        printf(" PF: %0.4f (%0.4fk/fault)", E[RepValue_PageFaults], E[RepValue_ByteCount] / (E[RepValue_PageFaults] * 1024.0));
+    }
+}
+
+static void PrintResults(repetition_test_results Results, u64 CPUTimerFreq)
+{
+    PrintValue("Min", Results.Min, CPUTimerFreq);
+    printf("\n");
+    PrintValue("Max", Results.Max, CPUTimerFreq);
+    printf("\n");
+    if(Results.Total.E[RepValue_TestCount])
+    {
+        PrintValue("Avg", Results.Total, CPUTimerFreq);
+        printf("\n");
+    }
+}
+
+static void Error(repetition_tester *Tester, char const *Message)
+{
+    Tester->Mode = TestMode_Error;
+    fprintf(stderr, "ERROR: %s\n", Message);
+}
+
+static void NewTestWave(repetition_tester *Tester, u64 TargetProcessedByteCount, u64 CPUTimerFreq, u32 SecondsToTry = 10)
+{
+    if(Tester->Mode == TestMode_Uninitialized)
+    {
+        Tester->Mode = TestMode_Testing;
+        Tester->TargetProcessedByteCount = TargetProcessedByteCount;
+        Tester->CPUTimerFreq = CPUTimerFreq;
+        Tester->PrintNewMinimums = true;
+        Tester->Results.Min.E[RepValue_CPUTimer] = (u64)-1;
+    }
+    else if(Tester->Mode == TestMode_Completed)
+    {
+        Tester->Mode = TestMode_Testing;
+        
+        if(Tester->TargetProcessedByteCount != TargetProcessedByteCount)
+        {
+            Error(Tester, "TargetProcessedByteCount changed");
+        }
+        
+        if(Tester->CPUTimerFreq != CPUTimerFreq)
+        {
+            Error(Tester, "CPU frequency changed");
+        }
+    }
+    
+    Tester->TryForTime = SecondsToTry*CPUTimerFreq;
+    Tester->TestsStartedAt = ReadCPUTimer();
+}
+
+inline void BeginTime(repetition_tester *Tester)
+{
+    ++Tester->OpenBlockCount;
+    
+    // NOTE(agent): The page fault count is read first here and last in EndTime, so the (comparatively slow)
+    // call to the OS is never inside the timed region.
+    repetition_value *Accum = &Tester->AccumulatedOnThisTest;
+    Accum->E[RepValue_PageFaults] -= ReadOSPageFaultCount();
+    Accum->E[RepValue_CPUTimer] -= ReadCPUTimer();
+}
+
+inline void EndTime(repetition_tester *Tester)
+{
+    repetition_value *Accum = &Tester->AccumulatedOnThisTest;
+    Accum->E[RepValue_CPUTimer] += ReadCPUTimer();
+    Accum->E[RepValue_PageFaults] += ReadOSPageFaultCount();
+    
+    ++Tester->CloseBlockCount;
+}
+
+inline void CountBytes(repetition_tester *Tester, u64 ByteCount)
+{
+    repetition_value *Accum = &Tester->AccumulatedOnThisTest;
+    Accum->E[RepValue_ByteCount] += ByteCount;
+}
+
+static b32 IsTesting(repetition_tester *Tester)
+{
+    if(Tester->Mode == TestMode_Testing)
+    {
+        repetition_value Accum = Tester->AccumulatedOnThisTest;
+        u64 CurrentTime = ReadCPUTimer();
+        
+        // NOTE(agent): We don't count tests that had no timing blocks - we assume they took some other path
+        if(Tester->OpenBlockCount)
+        {
+            if(Tester->OpenBlockCount != Tester->CloseBlockCount)
+            {
+                Error(Tester, "Unbalanced BeginTime/EndTime");
+            }
+            
+            if(Accum.E[RepValue_ByteCount] != Tester->TargetProcessedByteCount)
+            {
+                Error(Tester, "Processed byte count mismatch");
+            }
+            
+            if(Tester->Mode == TestMode_Testing)
+            {
+                repetition_test_results *Results = &Tester->Results;
+                
+                Accum.E[RepValue_TestCount] = 1;
+                for(u32 EIndex = 0; EIndex < RepValue_Count; ++EIndex)
+                {
+                    Results->Total.E[EIndex] += Accum.E[EIndex];
+                }
+                
+                if(Results->Max.E[RepValue_CPUTimer] < Accum.E[RepValue_CPUTimer])
+                {
+                    Results->Max = Accum;
+                }
+                
+                if(Results->Min.E[RepValue_CPUTimer] > Accum.E[RepValue_CPUTimer])
+                {
+                    Results->Min = Accum;
+                    
+                    // NOTE(agent): Whenever we get a new minimum time, we reset the clock to the full trial time
+                    Tester->TestsStartedAt = CurrentTime;
+                    
+                    if(Tester->PrintNewMinimums)
+                    {
+                        PrintValue("Min", Results->Min, Tester->CPUTimerFreq);
+                        printf("                                   \r");
+                        fflush(stdout);
+                    }
+                }
+                
+                Tester->OpenBlockCount = 0;
+                Tester->CloseBlockCount = 0;
+                Tester->AccumulatedOnThisTest = {};
+            }
+        }
+        
+        if((CurrentTime - Tester->TestsStartedAt) > Tester->TryForTime)
+        {
+            Tester->Mode = TestMode_Completed;
+            
+            if(Tester->PrintNewMinimums)
+            {
+                printf("                                                          \r");
+                PrintResults(Tester->Results, Tester->CPUTimerFreq);
+            }
+        }
+    }
+    
+    b32 Result = (Tester->Mode == TestMode_Testing);
+    return Result;
+}
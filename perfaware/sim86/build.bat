@@ -6,6 +6,12 @@ call cl -nologo -Zi -FC ..\sim86.cpp -Fesim86_msvc_debug.exe
 call clang -g -fuse-ld=lld ..\sim86.cpp -o sim86_clang_debug.exe
 call cl -O2 -nologo -Zi -FC ..\sim86.cpp -Fesim86_msvc_release.exe
 call clang -O3 -g -fuse-ld=lld ..\sim86.cpp -o sim86_clang_release.exe
+call cl -O2 -nologo -Zi -FC -DSIM86_SPECIALIZED_DECODE=1 ..\sim86.cpp -Fesim86_msvc_specialized_release.exe
+call clang -O3 -g -fuse-ld=lld -DSIM86_SPECIALIZED_DECODE=1 ..\sim86.cpp -o sim86_clang_specialized_release.exe
+call clang -O3 -g -fuse-ld=lld -DPROFILER=1 ..\sim86.cpp -o sim86_clang_profiled_release.exe
+
+call cl -O2 -nologo -Zi -FC ..\sim86_decode_test.cpp -Fesim86_decode_test.exe
+call cl -O2 -nologo -Zi -FC ..\sim86_benchmark.cpp -Fesim86_benchmark.exe
 
 call clang -P -E ..\sim86_lib.h | call clang-format --style="Microsoft" > ..\shared\sim86_shared.h
 call clang -P -E ..\sim86_instruction_table_standalone.h | call clang-format --style="Microsoft" > sim86_instruction_table_standalone.h
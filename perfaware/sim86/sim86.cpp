@@ -27,6 +27,13 @@
 #include <string.h>
 #include <assert.h>
 
+#if PROFILER
+#include "../part1/platform_metrics.cpp"
+#endif
+#include "../part2/profiler.cpp"
+#include "../part2/os_memory.cpp"
+#include "../part2/arena.cpp"
+
 #include "sim86_instruction.h"
 #include "sim86_instruction_table.h"
 #include "sim86_memory.h"
@@ -34,15 +41,26 @@
 #include "sim86_execute.h"
 #include "sim86_cycles.h"
 #include "sim86_text.h"
+#include "sim86_length.h"
+#include "sim86_threads.h"
+#include "sim86_cfg.h"
 
 #include "sim86_instruction.cpp"
 #include "sim86_instruction_table.cpp"
 #include "sim86_memory.cpp"
 #include "sim86_decode.cpp"
+#if SIM86_SPECIALIZED_DECODE
+#include "sim86_decode_specialized.cpp"
+#endif
 #include "sim86_execute.cpp"
 #include "sim86_cycles.cpp"
 #include "sim86_text_table.cpp"
 #include "sim86_text.cpp"
+#include "sim86_length.cpp"
+#include "sim86_threads.cpp"
+#include "sim86_cfg.cpp"
+
+#define SIM86_OUTPUT_BUFFER_SIZE (64*1024)
 
 enum sim_flags
 {
@@ -51,6 +69,7 @@ enum sim_flags
     SimFlag_DumpMemory = 0x4,
     SimFlag_ExplainClocks = 0x8,
     SimFlag_NoRegisterDiffs = 0x10,
+    SimFlag_Headless = 0x20,
 };
 
 static u32 LoadMemoryFromFile(char *FileName, segmented_access SegMem, u32 AtOffset)
@@ -67,6 +86,8 @@ static u32 LoadMemoryFromFile(char *FileName, segmented_access SegMem, u32 AtOff
     FILE *File = fopen(FileName, "rb");
     if(File)
     {
+        // NOTE(agent): The file is read straight into main memory, so it doesn't need a buffer of its own
+        setvbuf(File, 0, _IONBF, 0);
         Result = fread(SegMem.Memory + BaseAddress, 1, MaxBytes, File);
         fclose(File);
     }
@@ -78,11 +99,12 @@ static u32 LoadMemoryFromFile(char *FileName, segmented_access SegMem, u32 AtOff
     return Result;
 }
 
-static segmented_access AllocateMemoryPow2(u32 SizePow2)
+static segmented_access AllocateMemoryPow2(u32 SizePow2, memory_policy Policy = GetDefaultMemoryPolicy())
 {
     static u8 FailedAllocationByte;
     
-    u8 *Memory = (u8 *)malloc(1 << SizePow2);
+    // NOTE(agent): The simulated memory lives for the whole run, so it is never freed
+    u8 *Memory = AllocateOSMemory(1 << SizePow2, Policy).Data;
     if(!Memory)
     {
         SizePow2 = 0;
@@ -93,39 +115,95 @@ static segmented_access AllocateMemoryPow2(u32 SizePow2)
     return Result;
 }
 
-static void PrintEstimatedClocks(timing_state State, instruction Instruction, u32 SimFlags,
-                                 instruction_clock_interval *Accum)
+static instruction_clock_interval AccumulateEstimatedClocks(timing_state State, instruction Instruction, instruction_timing *Timing,
+                                                            instruction_clock_interval *Accum)
 {
-    instruction_timing Timing = EstimateInstructionClocks(State, Instruction);
-    instruction_clock_interval Clocks = ExpectedClocksFrom(State, Instruction, Timing);
+    *Timing = EstimateInstructionClocks(State, Instruction);
+    instruction_clock_interval Clocks = ExpectedClocksFrom(State, Instruction, *Timing);
     Accum->Min += Clocks.Min;
     Accum->Max += Clocks.Max;
     
+    return Clocks;
+}
+
+static void PrintEstimatedClocks(timing_state State, instruction Instruction, u32 SimFlags,
+                                 instruction_clock_interval *Accum, text_output *Dest)
+{
+    instruction_timing Timing;
+    instruction_clock_interval Clocks = AccumulateEstimatedClocks(State, Instruction, &Timing, Accum);
+    
     if(Accum->Min != Accum->Max)
     {
-        fprintf(stdout, "Clocks: +[%u,%u] = [%u,%u]", Clocks.Min, Clocks.Max, Accum->Min, Accum->Max);
+        Print(Dest, "Clocks: +[%u,%u] = [%u,%u]", Clocks.Min, Clocks.Max, Accum->Min, Accum->Max);
     }
     else
     {
-        fprintf(stdout, "Clocks: +%u = %u", Clocks.Min, Accum->Min);
+        Print(Dest, "Clocks: +%u = %u", Clocks.Min, Accum->Min);
     }
     
     if(SimFlags & SimFlag_ExplainClocks)
     {
-        ExplainTiming(Timing, Clocks, stdout);
+        ExplainTiming(Timing, Clocks, Dest);
     }
 }
 
-static void DisAsm8086(u32 DisAsmByteCount, segmented_access DisAsmStart, u32 SimFlags, timing_state Timing)
+enum disasm_error
 {
-    segmented_access At = DisAsmStart;
+    DisAsmError_None,
+    DisAsmError_Unrecognized,
+    DisAsmError_OutsideRegion,
+};
+
+static void PrintDisAsmError(disasm_error Error, text_output *Out)
+{
+    if(Error)
+    {
+        // NOTE(agent): Whatever was disassembled before the error goes out first, so the error comes after it
+        FlushTextOutput(Out);
+    }
     
-    instruction_table Table = Get8086InstructionTable();
+    switch(Error)
+    {
+        case DisAsmError_None: {} break;
+        
+        case DisAsmError_Unrecognized:
+        {
+            fprintf(stderr, "ERROR: Unrecognized binary in instruction stream.\n");
+        } break;
+        
+        case DisAsmError_OutsideRegion:
+        {
+            fprintf(stderr, "ERROR: Instruction extends outside disassembly region\n");
+        } break;
+    }
+}
 
-    // NOTE(casey): When not simulating, assume branches are taken, since that is what most loop conditionals will do
-    // and that is what we would normally be timing.
-    Timing.AssumeBranchTaken = true;
-    instruction_clock_interval TimeAccum = {};
+// NOTE(agent): If Dest is null, nothing is printed, but the clocks are still accumulated (if they are being shown).
+static void PrintDisAsmLine(instruction Instruction, u32 SimFlags, timing_state Timing, instruction_clock_interval *TimeAccum, text_output *Dest)
+{
+    if(Dest)
+    {
+        PrintInstruction(Instruction, Dest);
+        if(SimFlags & SimFlag_ShowClocks)
+        {
+            PrintString(Dest, " ; ");
+            PrintEstimatedClocks(Timing, Instruction, SimFlags, TimeAccum, Dest);
+        }
+        PrintString(Dest, "\n");
+    }
+    else if(SimFlags & SimFlag_ShowClocks)
+    {
+        instruction_timing IgnoredTiming;
+        AccumulateEstimatedClocks(Timing, Instruction, &IgnoredTiming, TimeAccum);
+    }
+}
+
+static disasm_error DisAsm8086Range(instruction_table Table, u32 DisAsmByteCount, segmented_access DisAsmStart, u32 SimFlags,
+                                    timing_state Timing, instruction_clock_interval *TimeAccum, text_output *Dest)
+{
+    disasm_error Result = DisAsmError_None;
+    
+    segmented_access At = DisAsmStart;
     
     u32 Count = DisAsmByteCount;
     while(Count)
@@ -140,24 +218,398 @@ static void DisAsm8086(u32 DisAsmByteCount, segmented_access DisAsmStart, u32 Si
             }
             else
             {
-                fprintf(stderr, "ERROR: Instruction extends outside disassembly region\n");
+                Result = DisAsmError_OutsideRegion;
+                break;
+            }
+            
+            PrintDisAsmLine(Instruction, SimFlags, Timing, TimeAccum, Dest);
+        }
+        else
+        {
+            Result = DisAsmError_Unrecognized;
+            break;
+        }
+    }
+    
+    return Result;
+}
+
+static void DisAsm8086(u32 DisAsmByteCount, segmented_access DisAsmStart, u32 SimFlags, timing_state Timing, text_output *Out)
+{
+    instruction_table Table = Get8086InstructionTable();
+    
+    // NOTE(casey): When not simulating, assume branches are taken, since that is what most loop conditionals will do
+    // and that is what we would normally be timing.
+    Timing.AssumeBranchTaken = true;
+    instruction_clock_interval TimeAccum = {};
+    
+    disasm_error Error = DisAsm8086Range(Table, DisAsmByteCount, DisAsmStart, SimFlags, Timing, &TimeAccum, Out);
+    PrintDisAsmError(Error, Out);
+}
+
+static void StreamDisAsm8086(char *FileName, u32 SimFlags, timing_state Timing, text_output *Out)
+{
+    /* NOTE(agent): Main memory only holds 1mb, so for files bigger than that, the file is streamed through a
+       small ring buffer instead. The ring is addressed with a segmented_access whose mask wraps at the ring size,
+       so the decoder reads straight out of it, and an instruction that straddles the end of the ring just wraps
+       around to its beginning like any other access would.
+       
+       The ring is split in two halves. As soon as decoding moves past the end of one half, that half is refilled
+       with the next part of the file, while decoding continues in the other. Since a half is much larger than
+       any instruction, the bytes of the next instruction are always already there. */
+    
+    u32 const RingSizePow2 = 16;
+    u32 const RingSize = (1 << RingSizePow2);
+    u32 const HalfSize = RingSize / 2;
+    static u8 Ring[RingSize];
+    
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+        // NOTE(agent): Reads go straight into the ring, so the file doesn't need a buffer of its own
+        setvbuf(File, 0, _IONBF, 0);
+        
+        instruction_table Table = Get8086InstructionTable();
+        segmented_access RingAccess = FixedMemoryPow2(RingSizePow2, Ring);
+        
+        Timing.AssumeBranchTaken = true;
+        instruction_clock_interval TimeAccum = {};
+        
+        b32 EndOfFile = false;
+        u64 FileSize = 0;
+        u64 FilledTo = 0;
+        u64 DecodeAt = 0;
+        
+        disasm_error Error = DisAsmError_None;
+        for(;;)
+        {
+            // NOTE(agent): The half before the one DecodeAt is in is no longer needed, so it can be refilled
+            // (both halves are filled to begin with)
+            while((FilledTo < HalfSize) || (DecodeAt >= (FilledTo - HalfSize)))
+            {
+                u8 *Half = Ring + (FilledTo & (RingSize - 1));
+                size_t ReadCount = EndOfFile ? 0 : fread(Half, 1, HalfSize, File);
+                if(ReadCount < HalfSize)
+                {
+                    // NOTE(agent): Past the end of the file, the decoder sees zeroes, just as it would past the end
+                    // of a file loaded into main memory
+                    EndOfFile = true;
+                    memset(Half + ReadCount, 0, HalfSize - ReadCount);
+                }
+                
+                FileSize += ReadCount;
+                FilledTo += HalfSize;
+            }
+            
+            if(DecodeAt >= FileSize)
+            {
                 break;
             }
             
-            PrintInstruction(Instruction, stdout);
-            if(SimFlags & SimFlag_ShowClocks)
+            segmented_access At = RingAccess;
+            At.SegmentOffset = (u16)(DecodeAt & (RingSize - 1));
+            
+            instruction Instruction = DecodeInstruction(Table, At);
+            if(!Instruction.Op)
             {
-                printf(" ; ");
-                PrintEstimatedClocks(Timing, Instruction, SimFlags, &TimeAccum);
+                Error = DisAsmError_Unrecognized;
+                break;
+            }
+            
+            if((FileSize - DecodeAt) < Instruction.Size)
+            {
+                Error = DisAsmError_OutsideRegion;
+                break;
             }
-            printf("\n");
+            
+            PrintDisAsmLine(Instruction, SimFlags, Timing, &TimeAccum, Out);
+            DecodeAt += Instruction.Size;
         }
-        else
+        
+        PrintDisAsmError(Error, Out);
+        
+        fclose(File);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open %s.\n", FileName);
+    }
+}
+
+#define DISASM_TEXT_PER_BYTE 64
+
+struct disasm_chunk
+{
+    // NOTE(agent): Filled in by the length pre-scan, which starts at an arbitrary offset and so
+    // may or may not be on the real instruction stream
+    u32 SpeculativeStart;
+    u32 SpeculativeExit;
+    b32 SpeculativeInvalid;
+    
+    // NOTE(agent): The real instruction boundaries, once they have been resolved
+    u32 Start;
+    u32 End;
+    
+    instruction_clock_interval Clocks;
+    instruction_clock_interval StartingAccum;
+    
+    text_output Output;
+    disasm_error Error;
+};
+
+struct parallel_disasm
+{
+    instruction_table Table;
+    instruction_length_table *Lengths;
+    u8 *IsSpeculativeStart;
+    
+    segmented_access DisAsmStart;
+    u32 DisAsmByteCount;
+    u32 SimFlags;
+    timing_state Timing;
+    
+    disasm_chunk *Chunks;
+};
+
+static void ScanChunkLengths(void *Params, u32 ChunkIndex)
+{
+    parallel_disasm *DisAsm = (parallel_disasm *)Params;
+    disasm_chunk *Chunk = DisAsm->Chunks + ChunkIndex;
+    u32 ChunkEnd = Chunk[1].SpeculativeStart;
+    
+    u32 Offset = Chunk->SpeculativeStart;
+    while(Offset < ChunkEnd)
+    {
+        DisAsm->IsSpeculativeStart[Offset] = true;
+        
+        u32 Length = GetInstructionLength(DisAsm->Lengths, MoveBaseTo(DisAsm->DisAsmStart, Offset));
+        if(!Length)
         {
-            fprintf(stderr, "ERROR: Unrecognized binary in instruction stream.\n");
+            Chunk->SpeculativeInvalid = true;
             break;
         }
+        
+        Offset += Length;
+    }
+    
+    Chunk->SpeculativeExit = Offset;
+}
+
+static void SumChunkClocks(void *Params, u32 ChunkIndex)
+{
+    parallel_disasm *DisAsm = (parallel_disasm *)Params;
+    disasm_chunk *Chunk = DisAsm->Chunks + ChunkIndex;
+    
+    DisAsm8086Range(DisAsm->Table, Chunk->End - Chunk->Start, MoveBaseTo(DisAsm->DisAsmStart, Chunk->Start),
+                    DisAsm->SimFlags, DisAsm->Timing, &Chunk->Clocks, 0);
+}
+
+static void DisAsmChunk(void *Params, u32 ChunkIndex)
+{
+    parallel_disasm *DisAsm = (parallel_disasm *)Params;
+    disasm_chunk *Chunk = DisAsm->Chunks + ChunkIndex;
+    
+    instruction_clock_interval TimeAccum = Chunk->StartingAccum;
+    Chunk->Error = DisAsm8086Range(DisAsm->Table, Chunk->End - Chunk->Start, MoveBaseTo(DisAsm->DisAsmStart, Chunk->Start),
+                                   DisAsm->SimFlags, DisAsm->Timing, &TimeAccum, &Chunk->Output);
+}
+
+static void ParallelDisAsm8086(arena *Arena, u32 ThreadCount, u32 DisAsmByteCount, segmented_access DisAsmStart, u32 SimFlags,
+                               timing_state Timing, text_output *Out)
+{
+    /* NOTE(agent): Instruction N+1 can't be found without decoding instruction N, so on its own, disassembly is
+       serial. But finding instruction lengths is far cheaper than decoding and printing, and 8086 instruction
+       streams tend to resynchronize quickly: a length scan started at the wrong offset usually lands on a real
+       instruction boundary within a few instructions. So:
+       
+       1) Every chunk is length-scanned in parallel from its nominal start, marking each instruction start it sees.
+       2) Serially, the real instruction stream is walked from the beginning of each chunk only until it lands
+          on one of that chunk's marked starts. From there on, the speculative scan was correct, and its exit
+          point is the real start of the next chunk.
+       3) Each chunk is then decoded and printed in parallel into its own text buffer (after a parallel pass to
+          total up clocks, if they are being shown, since each line prints a running total).
+       
+       The buffers are then copied out in order, so the output is identical to DisAsm8086.
+       
+       Everything here is pushed on the arena, and popped off at the end. Each chunk's text buffer is sized for
+       DISASM_TEXT_PER_BYTE characters per byte of code, which real code never gets near - the arena's blocks
+       are lazily paged (unless MEMORY_POLICY says otherwise), so the part that isn't written to costs nothing.
+       If a chunk does run out of room anyway, it is just disassembled again, straight to Out, when its turn comes. */
+    
+    u32 const MinChunkSize = 4096;
+    u32 ChunkCount = ThreadCount*16;
+    if(ChunkCount > (DisAsmByteCount / MinChunkSize))
+    {
+        ChunkCount = DisAsmByteCount / MinChunkSize;
+    }
+    
+    parallel_disasm DisAsm = {};
+    DisAsm.Table = Get8086InstructionTable();
+    DisAsm.DisAsmStart = DisAsmStart;
+    DisAsm.DisAsmByteCount = DisAsmByteCount;
+    DisAsm.SimFlags = SimFlags;
+    DisAsm.Timing = Timing;
+    DisAsm.Timing.AssumeBranchTaken = true;
+    
+    temp_arena Temp = BeginTemp(Arena);
+    if(ChunkCount > 1)
+    {
+        DisAsm.Lengths = PushStruct(Arena, instruction_length_table);
+        DisAsm.IsSpeculativeStart = PushArrayZero(Arena, DisAsmByteCount, u8);
+        DisAsm.Chunks = PushArrayZero(Arena, ChunkCount + 1, disasm_chunk);
+    }
+    
+    if(DisAsm.Lengths && DisAsm.IsSpeculativeStart && DisAsm.Chunks)
+    {
+        BuildInstructionLengthTable(DisAsm.Table, DisAsm.Lengths);
+        
+        u32 ChunkSize = (DisAsmByteCount + ChunkCount - 1) / ChunkCount;
+        for(u32 ChunkIndex = 0; ChunkIndex <= ChunkCount; ++ChunkIndex)
+        {
+            u32 Start = ChunkIndex*ChunkSize;
+            DisAsm.Chunks[ChunkIndex].SpeculativeStart = (Start < DisAsmByteCount) ? Start : DisAsmByteCount;
+        }
+        
+        DoParallelWork(ThreadCount, ChunkCount, ScanChunkLengths, &DisAsm);
+        
+        // NOTE(agent): Resolve the real chunk boundaries, and stop at the first chunk whose instruction stream goes bad
+        u32 UsedChunkCount = 0;
+        u32 Offset = 0;
+        for(u32 ChunkIndex = 0; ChunkIndex < ChunkCount; ++ChunkIndex)
+        {
+            disasm_chunk *Chunk = DisAsm.Chunks + ChunkIndex;
+            u32 ChunkEnd = Chunk[1].SpeculativeStart;
+            
+            Chunk->Start = Offset;
+            ++UsedChunkCount;
+            
+            b32 Invalid = false;
+            while(Offset < ChunkEnd)
+            {
+                if(DisAsm.IsSpeculativeStart[Offset])
+                {
+                    Offset = Chunk->SpeculativeExit;
+                    Invalid = Chunk->SpeculativeInvalid;
+                    break;
+                }
+                
+                u32 Length = GetInstructionLength(DisAsm.Lengths, MoveBaseTo(DisAsmStart, Offset));
+                if(!Length)
+                {
+                    Invalid = true;
+                    break;
+                }
+                
+                Offset += Length;
+            }
+            
+            if(Invalid || (ChunkIndex == (ChunkCount - 1)))
+            {
+                // NOTE(agent): The last chunk runs to the end, so that it reports the same error DisAsm8086 would
+                Chunk->End = DisAsmByteCount;
+                break;
+            }
+            
+            Chunk->End = Offset;
+        }
+        
+        if(SimFlags & SimFlag_ShowClocks)
+        {
+            DoParallelWork(ThreadCount, UsedChunkCount, SumChunkClocks, &DisAsm);
+            
+            instruction_clock_interval Accum = {};
+            for(u32 ChunkIndex = 0; ChunkIndex < UsedChunkCount; ++ChunkIndex)
+            {
+                disasm_chunk *Chunk = DisAsm.Chunks + ChunkIndex;
+                Chunk->StartingAccum = Accum;
+                Accum.Min += Chunk->Clocks.Min;
+                Accum.Max += Chunk->Clocks.Max;
+            }
+        }
+        
+        b32 OutputsValid = true;
+        for(u32 ChunkIndex = 0; ChunkIndex < UsedChunkCount; ++ChunkIndex)
+        {
+            disasm_chunk *Chunk = DisAsm.Chunks + ChunkIndex;
+            u64 TextSize = (u64)(Chunk->End - Chunk->Start)*DISASM_TEXT_PER_BYTE;
+            Chunk->Output = TextOutputToMemory(PushArray(Arena, TextSize, char), TextSize);
+            OutputsValid = OutputsValid && Chunk->Output.Data;
+        }
+        
+        if(OutputsValid)
+        {
+            DoParallelWork(ThreadCount, UsedChunkCount, DisAsmChunk, &DisAsm);
+            
+            for(u32 ChunkIndex = 0; ChunkIndex < UsedChunkCount; ++ChunkIndex)
+            {
+                disasm_chunk *Chunk = DisAsm.Chunks + ChunkIndex;
+                
+                if(Chunk->Output.Overflowed)
+                {
+                    instruction_clock_interval TimeAccum = Chunk->StartingAccum;
+                    DisAsm8086Range(DisAsm.Table, Chunk->End - Chunk->Start, MoveBaseTo(DisAsmStart, Chunk->Start),
+                                    SimFlags, DisAsm.Timing, &TimeAccum, Out);
+                }
+                else
+                {
+                    PrintText(Out, Chunk->Output.Data, Chunk->Output.Used);
+                }
+                
+                PrintDisAsmError(Chunk->Error, Out);
+                if(Chunk->Error)
+                {
+                    break;
+                }
+            }
+        }
+        else
+        {
+            DisAsm8086(DisAsmByteCount, DisAsmStart, SimFlags, Timing, Out);
+        }
+    }
+    else
+    {
+        // NOTE(agent): Too small to be worth splitting up (or out of memory)
+        DisAsm8086(DisAsmByteCount, DisAsmStart, SimFlags, Timing, Out);
+    }
+    
+    EndTemp(Temp);
+}
+
+static void RecursiveDisAsm8086(arena *Arena, u32 DisAsmByteCount, segmented_access DisAsmStart, char *CFGFileName, text_output *Out)
+{
+    instruction_table Table = Get8086InstructionTable();
+    
+    temp_arena Temp = BeginTemp(Arena);
+    
+    control_flow_graph Graph = {};
+    if(BuildControlFlowGraph(Arena, Table, DisAsmByteCount, DisAsmStart, &Graph))
+    {
+        PrintControlFlowListing(&Graph, DisAsmStart, Out);
+        
+        if(CFGFileName)
+        {
+            FILE *CFGFile = fopen(CFGFileName, "wb");
+            if(CFGFile)
+            {
+                if(!WriteControlFlowGraph(&Graph, CFGFile))
+                {
+                    fprintf(stderr, "ERROR: Unable to write control flow graph to %s.\n", CFGFileName);
+                }
+                fclose(CFGFile);
+            }
+            else
+            {
+                fprintf(stderr, "ERROR: Unable to open %s.\n", CFGFileName);
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to allocate memory for control flow graph.\n");
     }
+    
+    EndTemp(Temp);
 }
 
 static b32 IsRet(operation_type Op)
@@ -167,11 +619,19 @@ static b32 IsRet(operation_type Op)
     return Result;
 }
 
-static void Run8086(u32 OnePastLastByte, segmented_access MainMemory, u32 SimFlags, timing_state Timing)
+static void Run8086(u32 OnePastLastByte, segmented_access MainMemory, u32 SimFlags, timing_state Timing, text_output *Out)
 {
+    TimeFunction;
+    
+    /* NOTE(agent): In headless mode, nothing is printed per instruction. Clocks are always estimated, and the
+       only output is a single HEADLESS line at the end with the totals, so other programs can run the simulator
+       and read the result without having to parse a whole trace. */
+    b32 Headless = (SimFlags & SimFlag_Headless);
+    
     instruction_table Table = Get8086InstructionTable();
     register_state_8086 Registers = {};
     instruction_clock_interval TimeAccum = {};
+    u32 InstructionCount = 0;
     
     for(;;)
     {
@@ -190,7 +650,10 @@ static void Run8086(u32 OnePastLastByte, segmented_access MainMemory, u32 SimFla
                 if((SimFlags & SimFlag_StopOnRet) &&
                    IsRet(Instruction.Op))
                 {
-                    fprintf(stdout, "STOPONRET: Return encountered at address %u.\n", Instruction.Address);
+                    if(!Headless)
+                    {
+                        Print(Out, "STOPONRET: Return encountered at address %u.\n", Instruction.Address);
+                    }
                     break;
                 }
                 
@@ -199,28 +662,39 @@ static void Run8086(u32 OnePastLastByte, segmented_access MainMemory, u32 SimFla
                 
                 if(!Exec.Unimplemented)
                 {
-                    PrintInstruction(Instruction, stdout);
-                    printf(" ; ");
-                    if(SimFlags & SimFlag_ShowClocks)
+                    ++InstructionCount;
+                    if(Headless)
                     {
+                        instruction_timing InstructionTiming;
                         UpdateTimingForExec(&Timing, Exec);
-                        PrintEstimatedClocks(Timing, Instruction, SimFlags, &TimeAccum);
-                        fprintf(stdout, " | ");
+                        AccumulateEstimatedClocks(Timing, Instruction, &InstructionTiming, &TimeAccum);
                     }
-                    if(!(SimFlags & SimFlag_NoRegisterDiffs))
+                    else
                     {
-                        PrintRegisterDifference(&PrevRegisters, &Registers, stdout);
+                        PrintInstruction(Instruction, Out);
+                        PrintString(Out, " ; ");
+                        if(SimFlags & SimFlag_ShowClocks)
+                        {
+                            UpdateTimingForExec(&Timing, Exec);
+                            PrintEstimatedClocks(Timing, Instruction, SimFlags, &TimeAccum, Out);
+                            PrintString(Out, " | ");
+                        }
+                        if(!(SimFlags & SimFlag_NoRegisterDiffs))
+                        {
+                            PrintRegisterDifference(&PrevRegisters, &Registers, Out);
+                        }
+                        PrintString(Out, "\n");
                     }
-                    printf("\n");
                 }
                 else
                 {
-                    printf("ERROR: Unimplemented instruction (%s).\n", GetMnemonic(Instruction.Op));
+                    Print(Out, "ERROR: Unimplemented instruction (%s).\n", GetMnemonic(Instruction.Op));
                     break;
                 }
             }
             else
             {
+                FlushTextOutput(Out);
                 fprintf(stderr, "ERROR: Unrecognized binary in instruction stream.\n");
                 break;
             }
@@ -231,16 +705,29 @@ static void Run8086(u32 OnePastLastByte, segmented_access MainMemory, u32 SimFla
         }
     }
     
-    printf("\n");
-    printf("Final registers:\n");
-    PrintRegisters(&Registers, stdout);
-    printf("\n");
+    if(Headless)
+    {
+        Print(Out, "HEADLESS: %u instructions, %u to %u clocks.\n", InstructionCount, TimeAccum.Min, TimeAccum.Max);
+    }
+    else
+    {
+        PrintString(Out, "\n");
+        PrintString(Out, "Final registers:\n");
+        PrintRegisters(&Registers, Out);
+        PrintString(Out, "\n");
+    }
 }
 
 int main(int ArgCount, char **Args)
 {
+    BeginProfile();
+    
     b32 Execute = false;
     u32 DumpIndex = 0;
+    u32 ThreadCount = 1;
+    b32 Recursive = false;
+    b32 Stream = false;
+    char *CFGFileName = 0;
     u32 SimFlags = 0;
     
     timing_state Timing = {};
@@ -248,6 +735,17 @@ int main(int ArgCount, char **Args)
     u32 MainMemPow2 = 20;
     u32 MainMemSize = (1 << MainMemPow2);
     segmented_access MainMemory = AllocateMemoryPow2(MainMemPow2);
+    
+    /* NOTE(agent): Everything that goes to stdout is printed into Out, which does the buffering (so stdout doesn't
+       need a buffer of its own), and everything else a file needs besides main memory is pushed on Arena and
+       popped off when that file is done. So only the first file allocates anything - every file after it
+       reuses the same memory. */
+    arena Arena = {};
+    Arena.Policy = GetDefaultMemoryPolicy();
+    
+    setvbuf(stdout, 0, _IONBF, 0);
+    text_output Out = TextOutputToFile(stdout, PushArray(&Arena, SIM86_OUTPUT_BUFFER_SIZE, char), SIM86_OUTPUT_BUFFER_SIZE);
+    
     if(IsValid(MainMemory))
     {
         if(ArgCount > 1)
@@ -284,31 +782,90 @@ int main(int ArgCount, char **Args)
                 {
                     SimFlags |= SimFlag_StopOnRet;
                 }
+                else if(strcmp(FileName, "-headless") == 0)
+                {
+                    Execute = true;
+                    SimFlags |= SimFlag_Headless;
+                }
+                else if(strcmp(FileName, "-stream") == 0)
+                {
+                    Execute = false;
+                    Stream = true;
+                }
+                else if(strcmp(FileName, "-cfg") == 0)
+                {
+                    Execute = false;
+                    Recursive = true;
+                }
+                else if((strcmp(FileName, "-cfgout") == 0) && ((ArgIndex + 1) < ArgCount))
+                {
+                    Execute = false;
+                    Recursive = true;
+                    CFGFileName = Args[++ArgIndex];
+                }
+                else if((strcmp(FileName, "-threads") == 0) && ((ArgIndex + 1) < ArgCount))
+                {
+                    ThreadCount = atoi(Args[++ArgIndex]);
+                    if(ThreadCount == 0)
+                    {
+                        ThreadCount = GetProcessorCount();
+                    }
+#if PROFILER
+                    // NOTE(agent): The profiler only works for code running on one thread
+                    ThreadCount = 1;
+#endif
+                }
                 else
                 {
                     if(SimFlags & SimFlag_ShowClocks)
                     {
-                        fprintf(stdout,
-                                "\n"
-                                "WARNING: Clocks reported by this utility are strictly from the 8086 manual.\n"
-                                "They will be inaccurate, both because the manual clocks are estimates, and because\n"
-                                "some of the entries in the manual look highly suspicious and are probably typos.\n"
-                                "\n");
+                        Print(&Out,
+                              "\n"
+                              "WARNING: Clocks reported by this utility are strictly from the 8086 manual.\n"
+                              "They will be inaccurate, both because the manual clocks are estimates, and because\n"
+                              "some of the entries in the manual look highly suspicious and are probably typos.\n"
+                              "\n");
                     }
                     
-                    u32 BytesRead = LoadMemoryFromFile(FileName, MainMemory, 0);
-                    if(Execute)
+                    if(Stream && !Execute)
                     {
-                        printf("--- %s execution ---\n", FileName);
-                        Run8086(BytesRead, MainMemory, SimFlags, Timing);
+                        // NOTE(agent): Streaming never loads the file into main memory, so it isn't limited to 1mb
+                        Print(&Out, "; %s disassembly:\n", FileName);
+                        PrintString(&Out, "bits 16\n");
+                        StreamDisAsm8086(FileName, SimFlags, Timing, &Out);
                     }
                     else
                     {
-                        printf("; %s disassembly:\n", FileName);
-                        printf("bits 16\n");
-                        DisAsm8086(BytesRead, MainMemory, SimFlags, Timing);
+                        u32 BytesRead = LoadMemoryFromFile(FileName, MainMemory, 0);
+                        if(Execute)
+                        {
+                            if(!(SimFlags & SimFlag_Headless))
+                            {
+                                Print(&Out, "--- %s execution ---\n", FileName);
+                            }
+                            Run8086(BytesRead, MainMemory, SimFlags, Timing, &Out);
+                        }
+                        else
+                        {
+                            Print(&Out, "; %s disassembly:\n", FileName);
+                            PrintString(&Out, "bits 16\n");
+                            if(Recursive)
+                            {
+                                RecursiveDisAsm8086(&Arena, BytesRead, MainMemory, CFGFileName, &Out);
+                            }
+                            else if(ThreadCount > 1)
+                            {
+                                ParallelDisAsm8086(&Arena, ThreadCount, BytesRead, MainMemory, SimFlags, Timing, &Out);
+                            }
+                            else
+                            {
+                                DisAsm8086(BytesRead, MainMemory, SimFlags, Timing, &Out);
+                            }
+                        }
                     }
                     
+                    FlushTextOutput(&Out);
+                    
                     if(SimFlags & SimFlag_DumpMemory)
                     {
                         char DumpFileName[256];
@@ -335,5 +892,12 @@ int main(int ArgCount, char **Args)
         fprintf(stderr, "ERROR: Unable to allow main memory for 8086.\n");
     }
     
+    FlushTextOutput(&Out);
+    
+    // NOTE(agent): The profile goes to stderr, so stdout is still a clean disassembly/trace
+    EndAndPrintProfile(stderr);
+    
     return 0;
 }
+
+ProfilerEndOfCompilationUnit;
@@ -0,0 +1,195 @@
+/* NOTE(agent): Measures how fast the simulator can get through 8086 machine code, using the repetition tester
+   from part2. The file is loaded into memory once, and then each test steps through all of it over and over:
+   once with the table-interpreting decoder, once with the SIM86_SPECIALIZED_DECODE decoders, and once with just
+   the instruction length table (which is all the parallel disassembler's prescan uses).
+   
+   Usage: sim86_benchmark [-seconds count] <8086 machine code file>
+   
+   Bandwidth is in bytes of machine code per second. */
+
+#define SIM86_SPECIALIZED_DECODE 1
+
+#include "sim86.h"
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../part1/platform_metrics.cpp"
+#include "../part2/repetition_tester.cpp"
+#include "../part2/profiler.cpp"
+
+#include "sim86_instruction.h"
+#include "sim86_instruction_table.h"
+#include "sim86_memory.h"
+#include "sim86_decode.h"
+#include "sim86_length.h"
+
+#include "sim86_instruction.cpp"
+#include "sim86_instruction_table.cpp"
+#include "sim86_memory.cpp"
+#include "sim86_decode.cpp"
+#include "sim86_decode_specialized.cpp"
+#include "sim86_length.cpp"
+
+static u32 DecodeAll(instruction_table Table, segmented_access Start, u32 ByteCount, encoding_decoder *Decoder)
+{
+    // NOTE(agent): Returns how many bytes actually decoded, so a file with bad bytes in it can be reported
+    segmented_access At = Start;
+    u32 Offset = 0;
+    while(Offset < ByteCount)
+    {
+        instruction Instruction = DecodeInstruction(Table, At, Decoder);
+        if(!Instruction.Op)
+        {
+            break;
+        }
+        
+        Offset += Instruction.Size;
+        At = MoveBaseBy(At, Instruction.Size);
+    }
+    
+    u32 Result = (Offset < ByteCount) ? Offset : ByteCount;
+    return Result;
+}
+
+static u32 ScanAllLengths(instruction_length_table *Lengths, segmented_access Start, u32 ByteCount)
+{
+    segmented_access At = Start;
+    u32 Offset = 0;
+    while(Offset < ByteCount)
+    {
+        u32 Size = GetInstructionLength(Lengths, At);
+        if(!Size)
+        {
+            break;
+        }
+        
+        Offset += Size;
+        At = MoveBaseBy(At, Size);
+    }
+    
+    u32 Result = (Offset < ByteCount) ? Offset : ByteCount;
+    return Result;
+}
+
+enum sim86_test
+{
+    Test_TableDecode,
+    Test_SpecializedDecode,
+    Test_LengthOnly,
+    
+    Test_Count,
+};
+
+static char const *TestNames[Test_Count] =
+{
+    "Table decode",
+    "Specialized decode",
+    "Length only",
+};
+
+int main(int ArgCount, char **Args)
+{
+    u32 SecondsToTry = 10;
+    char *FileName = 0;
+    
+    for(int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char *Arg = Args[ArgIndex];
+        if((strcmp(Arg, "-seconds") == 0) && ((ArgIndex + 1) < ArgCount))
+        {
+            SecondsToTry = atoi(Args[++ArgIndex]);
+        }
+        else
+        {
+            FileName = Arg;
+        }
+    }
+    
+    if(!FileName)
+    {
+        fprintf(stderr, "USAGE: %s [-seconds count] <8086 machine code file>\n", Args[0]);
+        return 1;
+    }
+    
+    u32 MemoryPow2 = 20;
+    u8 *Memory = (u8 *)calloc(1, 1 << MemoryPow2);
+    instruction_length_table *Lengths = (instruction_length_table *)malloc(sizeof(instruction_length_table));
+    if(!Memory || !Lengths)
+    {
+        fprintf(stderr, "ERROR: Unable to allocate memory.\n");
+        return 1;
+    }
+    
+    segmented_access Start = FixedMemoryPow2(MemoryPow2, Memory);
+    
+    u32 ByteCount = 0;
+    FILE *File = fopen(FileName, "rb");
+    if(File)
+    {
+        ByteCount = (u32)fread(Memory, 1, 1 << MemoryPow2, File);
+        fclose(File);
+    }
+    else
+    {
+        fprintf(stderr, "ERROR: Unable to open %s.\n", FileName);
+        return 1;
+    }
+    
+    instruction_table Table = Get8086InstructionTable();
+    BuildInstructionLengthTable(Table, Lengths);
+    
+    // NOTE(agent): Every test has to process the same number of bytes every run, so it stops short at
+    // the first thing that doesn't decode, and all the tests are timed over just the part before it.
+    u32 DecodeCount = DecodeAll(Table, Start, ByteCount, TableDecode);
+    if(DecodeCount < ByteCount)
+    {
+        printf("NOTE: Only the first %u of %u bytes decode, so only those are timed.\n", DecodeCount, ByteCount);
+    }
+    
+    if(DecodeCount == 0)
+    {
+        fprintf(stderr, "ERROR: Nothing in %s decodes.\n", FileName);
+        return 1;
+    }
+    
+    u64 CPUTimerFreq = GetCPUTimerFreq();
+    repetition_tester Testers[Test_Count] = {};
+    u32 ErrorCount = 0;
+    
+    for(u32 TestIndex = 0; TestIndex < Test_Count; ++TestIndex)
+    {
+        repetition_tester *Tester = &Testers[TestIndex];
+        
+        printf("\n--- %s ---\n", TestNames[TestIndex]);
+        NewTestWave(Tester, DecodeCount, CPUTimerFreq, SecondsToTry);
+        
+        while(IsTesting(Tester))
+        {
+            u32 Processed = 0;
+            
+            BeginTime(Tester);
+            switch(TestIndex)
+            {
+                case Test_TableDecode: {Processed = DecodeAll(Table, Start, DecodeCount, TableDecode);} break;
+                case Test_SpecializedDecode: {Processed = DecodeAll(Table, Start, DecodeCount, SpecializedDecode);} break;
+                case Test_LengthOnly: {Processed = ScanAllLengths(Lengths, Start, DecodeCount);} break;
+            }
+            EndTime(Tester);
+            
+            CountBytes(Tester, Processed);
+        }
+        
+        if(Tester->Mode == TestMode_Error)
+        {
+            ++ErrorCount;
+        }
+    }
+    
+    int Result = (ErrorCount == 0) ? 0 : 1;
+    return Result;
+}
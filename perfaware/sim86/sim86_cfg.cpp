@@ -0,0 +1,495 @@
+enum cfg_byte_mark : u8
+{
+    Mark_InstructionStart = 0x1,
+    Mark_Leader = 0x2,
+    Mark_JumpTarget = 0x4,
+    Mark_CallTarget = 0x8,
+    Mark_Queued = 0x10,
+};
+
+static control_flow GetControlFlow(instruction Instruction)
+{
+    control_flow Result = Flow_None;
+    
+    switch(Instruction.Op)
+    {
+        case Op_jmp: {Result = Flow_Jump;} break;
+        case Op_call: {Result = Flow_Call;} break;
+        
+        case Op_je:
+        case Op_jl:
+        case Op_jle:
+        case Op_jb:
+        case Op_jbe:
+        case Op_jp:
+        case Op_jo:
+        case Op_js:
+        case Op_jne:
+        case Op_jnl:
+        case Op_jg:
+        case Op_jnb:
+        case Op_ja:
+        case Op_jnp:
+        case Op_jno:
+        case Op_jns:
+        case Op_loop:
+        case Op_loopz:
+        case Op_loopnz:
+        case Op_jcxz:
+        {
+            Result = Flow_Branch;
+        } break;
+        
+        case Op_ret:
+        case Op_retf:
+        case Op_iret:
+        case Op_hlt:
+        {
+            Result = Flow_Stop;
+        } break;
+        
+        default: {} break;
+    }
+    
+    if((Result == Flow_Jump) && !GetBranchTarget(Instruction, {}, 0))
+    {
+        // NOTE(agent): Jumps through registers, memory, or to another segment can't be followed
+        Result = Flow_Stop;
+    }
+    
+    return Result;
+}
+
+static b32 GetBranchTarget(instruction Instruction, segmented_access Region, u32 *Offset)
+{
+    b32 Result = false;
+    
+    instruction_operand Operand = Instruction.Operands[0];
+    if((Operand.Type == Operand_Immediate) &&
+       (Operand.Immediate.Flags & Immediate_RelativeJumpDisplacement))
+    {
+        if(Offset)
+        {
+            /* NOTE(agent): Displacements are relative to the end of the instruction, and land in the same code
+               segment - IP is only 16 bits, so a jump off either end of the segment wraps around to the other end,
+               just as it does on an 8086. The code segment is the region's segment. Targets before the start of
+               the region wrap around to very large offsets, so they fail the same range check as targets past
+               the end. */
+            u32 CodeSegment = (u32)Region.SegmentBase << 4;
+            u32 NextIP = Instruction.Address + Instruction.Size - CodeSegment;
+            u32 TargetIP = (NextIP + Operand.Immediate.Value) & 0xffff;
+            *Offset = ((CodeSegment + TargetIP) & Region.Mask) - GetAbsoluteAddressOf(Region);
+        }
+        
+        Result = true;
+    }
+    
+    return Result;
+}
+
+static void MarkTarget(u8 *Marks, u32 *Stack, u32 *StackCount, u32 Offset, u8 Mark)
+{
+    Marks[Offset] |= Mark_Leader | Mark;
+    if(!(Marks[Offset] & Mark_Queued))
+    {
+        Marks[Offset] |= Mark_Queued;
+        Stack[(*StackCount)++] = Offset;
+    }
+}
+
+static cfg_block *FindBlockAt(control_flow_graph *Graph, u32 Offset)
+{
+    cfg_block *Result = 0;
+    
+    u32 Low = 0;
+    u32 High = Graph->BlockCount;
+    while(Low < High)
+    {
+        u32 Mid = Low + (High - Low) / 2;
+        cfg_block *Block = Graph->Blocks + Mid;
+        if(Block->Offset < Offset)
+        {
+            Low = Mid + 1;
+        }
+        else if(Block->Offset > Offset)
+        {
+            High = Mid;
+        }
+        else
+        {
+            Result = Block;
+            break;
+        }
+    }
+    
+    return Result;
+}
+
+static void AddEdge(control_flow_graph *Graph, cfg_block *From, u32 ToOffset, cfg_edge_kind Kind)
+{
+    cfg_block *To = FindBlockAt(Graph, ToOffset);
+    if(To)
+    {
+        cfg_edge *Edge = Graph->Edges + Graph->EdgeCount++;
+        Edge->ToBlock = (u32)(To - Graph->Blocks);
+        Edge->Kind = Kind;
+        ++From->EdgeCount;
+    }
+    else if(Kind == Edge_FallThrough)
+    {
+        From->Flags |= Block_RunsOffEnd;
+    }
+    else
+    {
+        From->Flags |= Block_UnresolvedTarget;
+    }
+}
+
+static b32 BuildControlFlowGraph(arena *Arena, instruction_table Table, u32 ByteCount, segmented_access Start, control_flow_graph *Graph)
+{
+    /* NOTE(agent): This is a standard recursive-traversal disassembly. Starting from the first byte (and then from
+       every jump, branch, and call target found along the way), instructions are decoded one after the other until
+       control leaves in a way that can't fall through. Only bytes that are actually reached get decoded, so data
+       mixed in with the code doesn't throw off the decoding of the code that follows it.
+       
+       Every target, and every instruction after a transfer of control, starts a basic block. Blocks are then
+       formed by walking from each of those "leaders" to the next one. Calls end blocks too, so that every block
+       has at most two successors.
+       
+       Everything the graph points to is pushed on Arena, along with the scratch space used to build it, and none
+       of it is popped - the caller pops it all together when it's done with the graph (see RecursiveDisAsm8086). */
+    
+    b32 Result = false;
+    
+    *Graph = {};
+    Graph->ByteCount = ByteCount;
+    
+    u8 *Marks = PushArrayZero(Arena, ByteCount + 1, u8);
+    u32 *Stack = PushArray(Arena, ByteCount + 1, u32);
+    if(Marks && Stack)
+    {
+        u32 StackCount = 0;
+        MarkTarget(Marks, Stack, &StackCount, 0, Mark_CallTarget);
+        
+        u32 InstructionCount = 0;
+        while(StackCount)
+        {
+            u32 Offset = Stack[--StackCount];
+            while(!(Marks[Offset] & Mark_InstructionStart))
+            {
+                instruction Instruction = DecodeInstruction(Table, MoveBaseTo(Start, Offset));
+                u32 NextOffset = Offset + Instruction.Size;
+                if(!Instruction.Op || (NextOffset > ByteCount))
+                {
+                    break;
+                }
+                
+                Marks[Offset] |= Mark_InstructionStart;
+                ++InstructionCount;
+                
+                control_flow Flow = GetControlFlow(Instruction);
+                
+                u32 Target;
+                if((Flow != Flow_None) && GetBranchTarget(Instruction, Start, &Target) && (Target < ByteCount))
+                {
+                    MarkTarget(Marks, Stack, &StackCount, Target, (Flow == Flow_Call) ? Mark_CallTarget : Mark_JumpTarget);
+                }
+                
+                if(NextOffset >= ByteCount)
+                {
+                    break;
+                }
+                
+                if((Flow == Flow_Branch) || (Flow == Flow_Call))
+                {
+                    MarkTarget(Marks, Stack, &StackCount, NextOffset, 0);
+                    break;
+                }
+                else if(Flow != Flow_None)
+                {
+                    break;
+                }
+                
+                if(Marks[NextOffset] & Mark_InstructionStart)
+                {
+                    // NOTE(agent): Falling into instructions that were already decoded from somewhere else means
+                    // they now have more than one way in, so they have to start a block.
+                    Marks[NextOffset] |= Mark_Leader;
+                }
+                
+                Offset = NextOffset;
+            }
+        }
+        
+        u32 BlockCount = 0;
+        for(u32 Offset = 0; Offset < ByteCount; ++Offset)
+        {
+            if((Marks[Offset] & (Mark_InstructionStart|Mark_Leader)) == (Mark_InstructionStart|Mark_Leader))
+            {
+                ++BlockCount;
+            }
+        }
+        
+        Graph->Blocks = PushArrayZero(Arena, BlockCount, cfg_block);
+        Graph->Edges = PushArrayZero(Arena, 2*BlockCount, cfg_edge);
+        Graph->Instructions = PushArrayZero(Arena, InstructionCount, instruction);
+        if((Graph->Blocks && Graph->Edges && Graph->Instructions) || !BlockCount)
+        {
+            for(u32 Offset = 0; Offset < ByteCount; ++Offset)
+            {
+                if((Marks[Offset] & (Mark_InstructionStart|Mark_Leader)) == (Mark_InstructionStart|Mark_Leader))
+                {
+                    cfg_block *Block = Graph->Blocks + Graph->BlockCount++;
+                    Block->Offset = Offset;
+                    Block->FirstInstruction = Graph->InstructionCount;
+                    Block->Function = ~0u;
+                    if(Marks[Offset] & Mark_CallTarget)
+                    {
+                        Block->Flags |= Block_FunctionEntry;
+                        ++Graph->FunctionCount;
+                    }
+                    if(Marks[Offset] & Mark_JumpTarget)
+                    {
+                        Block->Flags |= Block_JumpTarget;
+                    }
+                    
+                    u32 At = Offset;
+                    for(;;)
+                    {
+                        instruction Instruction = DecodeInstruction(Table, MoveBaseTo(Start, At));
+                        Graph->Instructions[Graph->InstructionCount++] = Instruction;
+                        ++Block->InstructionCount;
+                        At += Instruction.Size;
+                        
+                        if((GetControlFlow(Instruction) != Flow_None) ||
+                           (At >= ByteCount) ||
+                           ((Marks[At] & (Mark_InstructionStart|Mark_Leader)) != Mark_InstructionStart))
+                        {
+                            break;
+                        }
+                    }
+                    
+                    Block->Size = At - Offset;
+                }
+            }
+            
+            for(u32 BlockIndex = 0; BlockIndex < Graph->BlockCount; ++BlockIndex)
+            {
+                cfg_block *Block = Graph->Blocks + BlockIndex;
+                Block->FirstEdge = Graph->EdgeCount;
+                
+                instruction Last = Graph->Instructions[Block->FirstInstruction + Block->InstructionCount - 1];
+                control_flow Flow = GetControlFlow(Last);
+                u32 NextOffset = Block->Offset + Block->Size;
+                
+                u32 Target = 0;
+                b32 HasTarget = GetBranchTarget(Last, Start, &Target);
+                switch(Flow)
+                {
+                    case Flow_None:
+                    {
+                        AddEdge(Graph, Block, NextOffset, Edge_FallThrough);
+                    } break;
+                    
+                    case Flow_Jump:
+                    {
+                        AddEdge(Graph, Block, Target, Edge_Taken);
+                    } break;
+                    
+                    case Flow_Branch:
+                    {
+                        AddEdge(Graph, Block, Target, Edge_Taken);
+                        AddEdge(Graph, Block, NextOffset, Edge_FallThrough);
+                    } break;
+                    
+                    case Flow_Call:
+                    {
+                        if(HasTarget)
+                        {
+                            AddEdge(Graph, Block, Target, Edge_Call);
+                        }
+                        else
+                        {
+                            Block->Flags |= Block_EndsInIndirect;
+                        }
+                        AddEdge(Graph, Block, NextOffset, Edge_FallThrough);
+                    } break;
+                    
+                    case Flow_Stop:
+                    {
+                        if(Last.Op == Op_hlt)
+                        {
+                            Block->Flags |= Block_EndsInHalt;
+                        }
+                        else if(Last.Op == Op_jmp)
+                        {
+                            Block->Flags |= Block_EndsInIndirect;
+                        }
+                        else
+                        {
+                            Block->Flags |= Block_EndsInReturn;
+                        }
+                    } break;
+                }
+            }
+            
+            /* NOTE(agent): Blocks belong to the first function (in address order) that reaches them without going
+               through a call. Function entries always belong to their own function, even when something else
+               jumps to them. */
+            u32 FunctionIndex = 0;
+            for(u32 BlockIndex = 0; BlockIndex < Graph->BlockCount; ++BlockIndex)
+            {
+                cfg_block *Block = Graph->Blocks + BlockIndex;
+                if(Block->Flags & Block_FunctionEntry)
+                {
+                    Block->Function = FunctionIndex++;
+                }
+            }
+            
+            for(u32 EntryIndex = 0; EntryIndex < Graph->BlockCount; ++EntryIndex)
+            {
+                cfg_block *Entry = Graph->Blocks + EntryIndex;
+                if(Entry->Flags & Block_FunctionEntry)
+                {
+                    u32 StackCount = 0;
+                    Stack[StackCount++] = EntryIndex;
+                    while(StackCount)
+                    {
+                        cfg_block *Block = Graph->Blocks + Stack[--StackCount];
+                        for(u32 EdgeIndex = 0; EdgeIndex < Block->EdgeCount; ++EdgeIndex)
+                        {
+                            cfg_edge Edge = Graph->Edges[Block->FirstEdge + EdgeIndex];
+                            cfg_block *To = Graph->Blocks + Edge.ToBlock;
+                            if((Edge.Kind != Edge_Call) && (To->Function == ~0u))
+                            {
+                                To->Function = Entry->Function;
+                                Stack[StackCount++] = Edge.ToBlock;
+                            }
+                        }
+                    }
+                }
+            }
+            
+            u32 *FunctionBlockCounts = Stack;
+            memset(FunctionBlockCounts, 0, Graph->FunctionCount*sizeof(u32));
+            for(u32 BlockIndex = 0; BlockIndex < Graph->BlockCount; ++BlockIndex)
+            {
+                cfg_block *Block = Graph->Blocks + BlockIndex;
+                assert(Block->Function < Graph->FunctionCount);
+                Block->IndexInFunction = FunctionBlockCounts[Block->Function]++;
+            }
+            
+            Result = true;
+        }
+    }
+    
+    if(!Result)
+    {
+        *Graph = {};
+    }
+    
+    return Result;
+}
+
+static void PrintBlockLabel(control_flow_graph *Graph, cfg_block *Block, text_output *Dest)
+{
+    Print(Dest, ".LBB%u_%u", Block->Function, Block->IndexInFunction);
+}
+
+static void PrintControlFlowListing(control_flow_graph *Graph, segmented_access Start, text_output *Dest)
+{
+    u32 Offset = 0;
+    for(u32 BlockIndex = 0; BlockIndex < Graph->BlockCount; ++BlockIndex)
+    {
+        cfg_block *Block = Graph->Blocks + BlockIndex;
+        
+        if(Block->Offset < Offset)
+        {
+            // NOTE(agent): Some other instruction already covered the start of this block (code that jumps into
+            // the middle of an instruction), so it can't be listed in place. It is only noted.
+            PrintString(Dest, "; NOTE: block ");
+            PrintBlockLabel(Graph, Block, Dest);
+            Print(Dest, " at +%u overlaps the preceding instruction and is not listed\n", Block->Offset);
+            continue;
+        }
+        
+        // NOTE(agent): Bytes that were never reached are assumed to be data, and are listed as such
+        u32 ByteInLine = 0;
+        while(Offset < Block->Offset)
+        {
+            Print(Dest, "%s0x%02x", ByteInLine ? ", " : "db ", *AccessMemory(MoveBaseTo(Start, Offset)));
+            ++Offset;
+            if((++ByteInLine == 16) || (Offset == Block->Offset))
+            {
+                PrintString(Dest, "\n");
+                ByteInLine = 0;
+            }
+        }
+        
+        if(Block->Flags & (Block_FunctionEntry|Block_JumpTarget))
+        {
+            PrintBlockLabel(Graph, Block, Dest);
+            PrintString(Dest, ":\n");
+        }
+        
+        for(u32 InstructionIndex = 0; InstructionIndex < Block->InstructionCount; ++InstructionIndex)
+        {
+            instruction Instruction = Graph->Instructions[Block->FirstInstruction + InstructionIndex];
+            
+            u32 Target;
+            cfg_block *TargetBlock = 0;
+            if(!(Instruction.Flags & (Inst_Lock|Inst_Rep|Inst_Segment)) &&
+               GetBranchTarget(Instruction, Start, &Target))
+            {
+                TargetBlock = FindBlockAt(Graph, Target);
+            }
+            
+            if(TargetBlock)
+            {
+                Print(Dest, "%s ", GetMnemonic(Instruction.Op));
+                PrintBlockLabel(Graph, TargetBlock, Dest);
+            }
+            else
+            {
+                PrintInstruction(Instruction, Dest);
+            }
+            PrintString(Dest, "\n");
+        }
+        
+        Offset = Block->Offset + Block->Size;
+    }
+    
+    u32 ByteInLine = 0;
+    while(Offset < Graph->ByteCount)
+    {
+        Print(Dest, "%s0x%02x", ByteInLine ? ", " : "db ", *AccessMemory(MoveBaseTo(Start, Offset)));
+        ++Offset;
+        if((++ByteInLine == 16) || (Offset == Graph->ByteCount))
+        {
+            PrintString(Dest, "\n");
+            ByteInLine = 0;
+        }
+    }
+}
+
+static b32 WriteControlFlowGraph(control_flow_graph *Graph, FILE *Dest)
+{
+    cfg_file_header Header = {};
+    Header.Magic = CFG_FILE_MAGIC;
+    Header.Version = CFG_FILE_VERSION;
+    Header.ByteCount = Graph->ByteCount;
+    Header.FunctionCount = Graph->FunctionCount;
+    Header.BlockCount = Graph->BlockCount;
+    Header.EdgeCount = Graph->EdgeCount;
+    Header.InstructionCount = Graph->InstructionCount;
+    Header.BlockSize = sizeof(cfg_block);
+    Header.EdgeSize = sizeof(cfg_edge);
+    Header.InstructionSize = sizeof(instruction);
+    
+    b32 Result = ((fwrite(&Header, sizeof(Header), 1, Dest) == 1) &&
+                  (fwrite(Graph->Blocks, sizeof(cfg_block), Graph->BlockCount, Dest) == Graph->BlockCount) &&
+                  (fwrite(Graph->Edges, sizeof(cfg_edge), Graph->EdgeCount, Dest) == Graph->EdgeCount) &&
+                  (fwrite(Graph->Instructions, sizeof(instruction), Graph->InstructionCount, Dest) == Graph->InstructionCount));
+    
+    return Result;
+}
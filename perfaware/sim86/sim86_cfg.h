@@ -0,0 +1,103 @@
+enum control_flow
+{
+    Flow_None, // NOTE(agent): Execution continues with the next instruction
+    Flow_Jump, // NOTE(agent): Always transfers elsewhere (jmp)
+    Flow_Branch, // NOTE(agent): Either transfers elsewhere or continues (jcc, loop, jcxz)
+    Flow_Call, // NOTE(agent): Transfers elsewhere, and is expected to come back to the next instruction
+    Flow_Stop, // NOTE(agent): Transfers somewhere that can't be known statically (ret, iret, indirect jmp, hlt)
+};
+
+enum cfg_edge_kind : u32
+{
+    Edge_Taken,
+    Edge_FallThrough,
+    Edge_Call,
+};
+
+enum cfg_block_flag : u32
+{
+    Block_FunctionEntry = 0x1, // NOTE(agent): The start of the image, or the target of a call
+    Block_JumpTarget = 0x2,
+    Block_EndsInReturn = 0x4,
+    Block_EndsInIndirect = 0x8, // NOTE(agent): Ends in a jmp or call that can't be followed (through a register or memory, or to another segment)
+    Block_EndsInHalt = 0x10,
+    Block_UnresolvedTarget = 0x20, // NOTE(agent): A direct target was outside the image, or did not decode
+    Block_RunsOffEnd = 0x40, // NOTE(agent): Execution would continue past the end of the image, or into bytes that did not decode
+};
+
+struct cfg_edge
+{
+    u32 ToBlock;
+    cfg_edge_kind Kind;
+};
+
+struct cfg_block
+{
+    // NOTE(agent): Offsets are from the start of the disassembled region
+    u32 Offset;
+    u32 Size;
+    
+    u32 FirstInstruction;
+    u32 InstructionCount;
+    
+    u32 FirstEdge;
+    u32 EdgeCount;
+    
+    // NOTE(agent): Which function this block belongs to, and its index within that function in address order.
+    // These are what the .LBB<Function>_<IndexInFunction> labels are made from.
+    u32 Function;
+    u32 IndexInFunction;
+    
+    u32 Flags;
+};
+
+struct control_flow_graph
+{
+    u32 ByteCount;
+    u32 FunctionCount;
+    
+    // NOTE(agent): Blocks are in address order. Each block's instructions are stored contiguously,
+    // so Instructions is also in address order.
+    u32 BlockCount;
+    cfg_block *Blocks;
+    
+    u32 EdgeCount;
+    cfg_edge *Edges;
+    
+    u32 InstructionCount;
+    instruction *Instructions;
+};
+
+/* NOTE(agent): WriteControlFlowGraph saves a control_flow_graph as a cfg_file_header followed directly by the
+   Blocks, Edges, and Instructions arrays, in that order, exactly as they are laid out in memory. The instructions
+   use the same layout as sim86_shared.h, so anything that can load the shared library can read them without
+   having to decode the machine code again. */
+
+#define CFG_FILE_MAGIC 0x47464338 // NOTE(agent): "8CFG"
+#define CFG_FILE_VERSION 1
+
+struct cfg_file_header
+{
+    u32 Magic;
+    u32 Version;
+    
+    u32 ByteCount;
+    u32 FunctionCount;
+    u32 BlockCount;
+    u32 EdgeCount;
+    u32 InstructionCount;
+    
+    u32 BlockSize;
+    u32 EdgeSize;
+    u32 InstructionSize;
+};
+
+static control_flow GetControlFlow(instruction Instruction);
+static b32 GetBranchTarget(instruction Instruction, segmented_access Region, u32 *Offset);
+
+static b32 BuildControlFlowGraph(arena *Arena, instruction_table Table, u32 ByteCount, segmented_access Start, control_flow_graph *Graph);
+
+static cfg_block *FindBlockAt(control_flow_graph *Graph, u32 Offset);
+
+static void PrintControlFlowListing(control_flow_graph *Graph, segmented_access Start, text_output *Dest);
+static b32 WriteControlFlowGraph(control_flow_graph *Graph, FILE *Dest);
@@ -36,32 +36,10 @@ static u32 CalculateEAClocksFrom(instruction Instruction, u32 OperandIndex)
     assert(Operand.Type == Operand_Memory);
     
     effective_address_expression Expr = Operand.Address;
-    register_index T0 = Expr.Terms[0].Register.Index;
-    register_index T1 = Expr.Terms[1].Register.Index;
-    if(T0)
-    {
-        if(T1)
-        {
-            if(((T0 == Register_bp) && (T1 == Register_di)) ||
-               ((T0 == Register_b) && (T1 == Register_si)))
-            {
-                Result = 7;
-            }
-            else
-            {
-                Result = 8;
-            }
-        }
-        else
-        {
-            Result = 5;
-        }
-    }
-    else
-    {
-        Result = 2;
-    }
+    Result = GetModRMEntry(Expr).EAClocks;
     
+    // NOTE(agent): The displacement clocks are charged by value rather than by encoding, so
+    // an explicit zero displacement (eg., [bp+0]) costs the same as no displacement at all.
     if(Expr.Displacement)
     {
         Result += 4;
@@ -10,12 +10,6 @@
    
    ======================================================================== */
 
-struct decode_context
-{
-    u32 DefaultSegment;
-    u32 AdditionalFlags;
-};
-
 static instruction_operand GetRegOperand(u32 IntelRegIndex, b32 Wide)
 {
     // NOTE(casey): This maps Intel's REG and RM field encodings for registers to our encoding for registers.
@@ -38,6 +32,115 @@ static instruction_operand GetRegOperand(u32 IntelRegIndex, b32 Wide)
     return Result;
 }
 
+struct modrm_table
+{
+    modrm_entry Entries[256];
+};
+
+static constexpr modrm_table BuildModRMTable()
+{
+    /* NOTE(agent): This is evaluated at compile time, so there is no startup cost and nothing
+       for library users to initialize. Every field of the ModRM byte that affects addressing is
+       resolved here once, rather than for every instruction we decode. */
+    
+    register_mapping_8086 const IntelTerm0[8] = { Register_b,  Register_b, Register_bp, Register_bp, Register_si, Register_di, Register_bp, Register_b};
+    register_mapping_8086 const IntelTerm1[8] = {Register_si, Register_di, Register_si, Register_di};
+    
+    // NOTE(agent): These are the 8086 manual's EA clocks for each base/index combination, not counting the displacement.
+    u32 const IntelEAClocks[8] = {7, 8, 8, 7, 5, 5, 5, 5};
+    
+    modrm_table Result = {};
+    
+    for(u32 ModRM = 0; ModRM < 256; ++ModRM)
+    {
+        u32 Mod = (ModRM >> 6) & 0x3;
+        u32 RM = ModRM & 0x7;
+        
+        modrm_entry *Entry = &Result.Entries[ModRM];
+        Entry->DefaultSegment = Register_ds;
+        
+        if(Mod == 0b11)
+        {
+            Entry->IsRegister = true;
+        }
+        else if((Mod == 0b00) && (RM == 0b110))
+        {
+            // NOTE(agent): Direct address
+            Entry->DisplacementByteCount = 2;
+            Entry->EAClocks = 2;
+        }
+        else
+        {
+            Entry->Terms[0] = IntelTerm0[RM];
+            Entry->Terms[1] = IntelTerm1[RM];
+            Entry->DisplacementByteCount = Mod;
+            Entry->EAClocks = IntelEAClocks[RM];
+            if(Entry->Terms[0] == Register_bp)
+            {
+                Entry->DefaultSegment = Register_ss;
+            }
+        }
+    }
+    
+    return Result;
+}
+
+static constexpr modrm_table ModRMTable8086 = BuildModRMTable();
+
+struct modrm_terms_table
+{
+    modrm_entry Entries[Register_count][Register_count];
+};
+
+static constexpr modrm_terms_table BuildModRMTermsTable(modrm_table const &ModRMTable)
+{
+    /* NOTE(agent): The ModRM byte is not part of the (public) instruction, so an address that has already been
+       decoded is looked up by its terms instead. Each base/index combination comes from exactly one r/m value,
+       and the mod only changes how many displacement bytes were read, which doesn't matter once the address is
+       decoded - so the mod=01 entry stands in for all of them. Every other combination of terms (no terms at
+       all, from direct addresses and intersegment addresses, which did not come from a ModRM byte) behaves like
+       a direct address. */
+    modrm_terms_table Result = {};
+    
+    for(u32 T0 = 0; T0 < Register_count; ++T0)
+    {
+        for(u32 T1 = 0; T1 < Register_count; ++T1)
+        {
+            Result.Entries[T0][T1] = ModRMTable.Entries[0b00000110];
+        }
+    }
+    
+    for(u32 RM = 0; RM < 8; ++RM)
+    {
+        modrm_entry const &Entry = ModRMTable.Entries[0b01000000 | RM];
+        Result.Entries[Entry.Terms[0]][Entry.Terms[1]] = Entry;
+    }
+    
+    return Result;
+}
+
+static constexpr modrm_terms_table ModRMTermsTable8086 = BuildModRMTermsTable(ModRMTable8086);
+
+static modrm_entry GetModRMEntry(u32 ModRM)
+{
+    modrm_entry Result = ModRMTable8086.Entries[ModRM & 0xff];
+    return Result;
+}
+
+static modrm_entry GetModRMEntry(effective_address_expression Address)
+{
+    register_index T0 = Address.Terms[0].Register.Index;
+    register_index T1 = Address.Terms[1].Register.Index;
+    
+    modrm_entry Result = ModRMTermsTable8086.Entries[0][0];
+    if((T0 < Register_count) && (T1 < Register_count))
+    {
+        Result = ModRMTermsTable8086.Entries[T0][T1];
+    }
+    
+    return Result;
+}
+
 // NOTE(casey): ParseDataValue is not a real function, it's basically just a macro that is used in
 // TryParse. It should never be called otherwise, but that is not something you can do in C++.
 // In other languages it would be a "local function".
@@ -68,14 +171,129 @@ static u32 ParseDataValue(segmented_access *Access, b32 Exists, b32 Wide, b32 Si
     return Result;
 }
 
-static instruction TryDecode(decode_context *Context, instruction_encoding *Inst, segmented_access At)
+// NOTE(agent): BuildDecodedInstruction takes the fields extracted from the opcode bytes of an instruction
+// and reads the rest of it (displacement and data), producing the final operands. At must point to the first
+// byte after the opcode bytes.
+static instruction BuildDecodedInstruction(decode_context *Context, operation_type Op, b32 *Has, u32 *Bits,
+                                           segmented_access At, u32 StartingAddress)
 {
     instruction Dest = {};
+    
+    u32 ModRM = (Bits[Bits_MOD] << 6) | ((Bits[Bits_REG] & 0x7) << 3) | (Bits[Bits_RM] & 0x7);
+    modrm_entry Entry = GetModRMEntry(ModRM);
+    
+    u32 RM = Bits[Bits_RM];
+    u32 W = Bits[Bits_W];
+    b32 S = Bits[Bits_S];
+    b32 D = Bits[Bits_D];
+    
+    Has[Bits_Disp] = ((Has[Bits_Disp]) || (Entry.DisplacementByteCount != 0));
+
+    b32 DisplacementIsW = ((Bits[Bits_DispAlwaysW]) || (Entry.DisplacementByteCount == 2));
+    b32 DataIsW = ((Bits[Bits_WMakesDataW]) && !S && W);
+    
+    Bits[Bits_Disp] |= ParseDataValue(&At, Has[Bits_Disp], DisplacementIsW, (!DisplacementIsW));
+    Bits[Bits_Data] |= ParseDataValue(&At, Has[Bits_Data], DataIsW, S);
+    
+    Dest.Op = Op;
+    Dest.Flags = Context->AdditionalFlags;
+    Dest.Address = StartingAddress;
+    // NOTE(agent): Masked so that an instruction which wraps around the end of memory still gets the right size
+    Dest.Size = (GetAbsoluteAddressOf(At) - StartingAddress) & GetHighestAddress(At);
+    Dest.SegmentOverride = Context->DefaultSegment;
+    
+    if(W)
+    {
+        Dest.Flags |= Inst_Wide;
+    }
+
+    if(Bits[Bits_Far])
+    {
+        Dest.Flags |= Inst_Far;
+    }
+    
+    if(Bits[Bits_Z])
+    {
+        Dest.Flags |= Inst_RepNE;
+    }
+    
+    u32 Disp = Bits[Bits_Disp];
+    s16 Displacement = (s16)Disp;
+    
+    instruction_operand *RegOperand = &Dest.Operands[D ? 0 : 1];
+    instruction_operand *ModOperand = &Dest.Operands[D ? 1 : 0];
+    
+    if(Has[Bits_SR])
+    {
+        *RegOperand = RegisterOperand(Register_es + (Bits[Bits_SR] & 0x3), 2);
+    }
+    
+    if(Has[Bits_REG])
+    {
+        *RegOperand = GetRegOperand(Bits[Bits_REG], W);
+    }
+    
+    if(Has[Bits_MOD])
+    {
+        if(Entry.IsRegister)
+        {
+            *ModOperand = GetRegOperand(RM, W || (Bits[Bits_RMRegAlwaysW]));
+        }
+        else
+        {
+            *ModOperand = EffectiveAddressOperand(RegisterAccess(Entry.Terms[0], 0, 2), RegisterAccess(Entry.Terms[1], 0, 2), Displacement);
+        }
+    }
+    
+    if(Has[Bits_Data] && Has[Bits_Disp] && !Has[Bits_MOD])
+    {
+        Dest.Operands[0] = IntersegmentAddressOperand(Bits[Bits_Data], Bits[Bits_Disp]);
+    }
+    else
+    {
+        //
+        // NOTE(casey): Because there are some strange opcodes that do things like have an immediate as
+        // a _destination_ ("out", for example), I define immediates and other "additional operands" to
+        // go in "whatever slot was not used by the reg and mod fields".
+        //
+        
+        instruction_operand *LastOperand = &Dest.Operands[0];
+        if(LastOperand->Type)
+        {
+            LastOperand = &Dest.Operands[1];
+        }
+        
+        if(Bits[Bits_RelJMPDisp])
+        {
+            *LastOperand = ImmediateOperand(Displacement, Immediate_RelativeJumpDisplacement);
+        }
+        else if(Has[Bits_Data])
+        {
+            *LastOperand = ImmediateOperand(Bits[Bits_Data]);
+        }
+        else if(Has[Bits_V])
+        {
+            if(Bits[Bits_V])
+            {
+                *LastOperand = RegisterOperand(Register_c, 1);
+            }
+            else
+            {
+                *LastOperand = ImmediateOperand(1);
+            }
+        }
+    }
+    
+    return Dest;
+}
+
+static instruction TryDecode(decode_context *Context, instruction_encoding *Inst, segmented_access At)
+{
     b32 Has[Bits_Count] = {};
     u32 Bits[Bits_Count] = {};
     b32 Valid = true;
     
-    u64 StartingAddress = GetAbsoluteAddressOf(At);
+    u32 StartingAddress = GetAbsoluteAddressOf(At);
     
     u8 BitsPendingCount = 0;
     u8 BitsPending = 0;
@@ -121,128 +339,16 @@ static instruction TryDecode(decode_context *Context, instruction_encoding *Inst
         }
     }
     
+    instruction Dest = {};
     if(Valid)
     {
-        u32 Mod = Bits[Bits_MOD];
-        u32 RM = Bits[Bits_RM];
-        u32 W = Bits[Bits_W];
-        b32 S = Bits[Bits_S];
-        b32 D = Bits[Bits_D];
-        
-        b32 HasDirectAddress = ((Mod == 0b00) && (RM == 0b110));
-        Has[Bits_Disp] = ((Has[Bits_Disp]) || (Mod == 0b10) || (Mod == 0b01) || HasDirectAddress);
-
-        b32 DisplacementIsW = ((Bits[Bits_DispAlwaysW]) || (Mod == 0b10) || HasDirectAddress);
-        b32 DataIsW = ((Bits[Bits_WMakesDataW]) && !S && W);
-        
-        Bits[Bits_Disp] |= ParseDataValue(&At, Has[Bits_Disp], DisplacementIsW, (!DisplacementIsW));
-        Bits[Bits_Data] |= ParseDataValue(&At, Has[Bits_Data], DataIsW, S);
-        
-        Dest.Op = Inst->Op;
-        Dest.Flags = Context->AdditionalFlags;
-        Dest.Address = StartingAddress;
-        Dest.Size = GetAbsoluteAddressOf(At) - StartingAddress;
-        Dest.SegmentOverride = Context->DefaultSegment;
-        
-        if(W)
-        {
-            Dest.Flags |= Inst_Wide;
-        }
-
-        if(Bits[Bits_Far])
-        {
-            Dest.Flags |= Inst_Far;
-        }
-        
-        if(Bits[Bits_Z])
-        {
-            Dest.Flags |= Inst_RepNE;
-        }
-        
-        u32 Disp = Bits[Bits_Disp];
-        s16 Displacement = (s16)Disp;
-        
-        instruction_operand *RegOperand = &Dest.Operands[D ? 0 : 1];
-        instruction_operand *ModOperand = &Dest.Operands[D ? 1 : 0];
-        
-        if(Has[Bits_SR])
-        {
-            *RegOperand = RegisterOperand(Register_es + (Bits[Bits_SR] & 0x3), 2);
-        }
-        
-        if(Has[Bits_REG])
-        {
-            *RegOperand = GetRegOperand(Bits[Bits_REG], W);
-        }
-        
-        if(Has[Bits_MOD])
-        {
-            if(Mod == 0b11)
-            {
-                *ModOperand = GetRegOperand(RM, W || (Bits[Bits_RMRegAlwaysW]));
-            }
-            else
-            {
-                register_mapping_8086 IntelTerm0[8] = { Register_b,  Register_b, Register_bp, Register_bp, Register_si, Register_di, Register_bp, Register_b};
-                register_mapping_8086 IntelTerm1[8] = {Register_si, Register_di, Register_si, Register_di};
-                
-                u32 I = RM&0x7;
-                register_mapping_8086 Term0 = IntelTerm0[I];
-                register_mapping_8086 Term1 = IntelTerm1[I];
-                if((Mod == 0b00) && (RM == 0b110))
-                {
-                    Term0 = {};
-                    Term1 = {};
-                }
-                
-                *ModOperand = EffectiveAddressOperand(RegisterAccess(Term0, 0, 2), RegisterAccess(Term1, 0, 2), Displacement);
-            }
-        }
-        
-        if(Has[Bits_Data] && Has[Bits_Disp] && !Has[Bits_MOD])
-        {
-            Dest.Operands[0] = IntersegmentAddressOperand(Bits[Bits_Data], Bits[Bits_Disp]);
-        }
-        else
-        {
-            //
-            // NOTE(casey): Because there are some strange opcodes that do things like have an immediate as
-            // a _destination_ ("out", for example), I define immediates and other "additional operands" to
-            // go in "whatever slot was not used by the reg and mod fields".
-            //
-            
-            instruction_operand *LastOperand = &Dest.Operands[0];
-            if(LastOperand->Type)
-            {
-                LastOperand = &Dest.Operands[1];
-            }
-            
-            if(Bits[Bits_RelJMPDisp])
-            {
-                *LastOperand = ImmediateOperand(Displacement, Immediate_RelativeJumpDisplacement);
-            }
-            else if(Has[Bits_Data])
-            {
-                *LastOperand = ImmediateOperand(Bits[Bits_Data]);
-            }
-            else if(Has[Bits_V])
-            {
-                if(Bits[Bits_V])
-                {
-                    *LastOperand = RegisterOperand(Register_c, 1);
-                }
-                else
-                {
-                    *LastOperand = ImmediateOperand(1);
-                }
-            }
-        }
+        Dest = BuildDecodedInstruction(Context, Inst->Op, Has, Bits, At, StartingAddress);
     }
     
     return Dest;
 }
 
-static instruction DecodeInstruction(instruction_table Table, segmented_access At)
+static instruction TableDecode(decode_context *Context, instruction_table Table, segmented_access At)
 {
     /* TODO(casey): Hmm. It seems like this is a very inefficient way to parse
        instructions, isn't it? For every instruction, we check every entry in the
@@ -250,6 +356,24 @@ static instruction DecodeInstruction(instruction_table Table, segmented_access A
        it know what they were doing, and has a plan for how it can be optimized
        later? Only time will tell... :) */
     
+    instruction Result = {};
+    for(u32 Index = 0; Index < Table.EncodingCount; ++Index)
+    {
+        instruction_encoding Inst = Table.Encodings[Index];
+        Result = TryDecode(Context, &Inst, At);
+        if(Result.Op)
+        {
+            break;
+        }
+    }
+    
+    return Result;
+}
+
+static instruction DecodeInstruction(instruction_table Table, segmented_access At, encoding_decoder *DecodeEncoding)
+{
+    TimeFunction;
+    
     decode_context Context = {};
     instruction Result = {};
     
@@ -257,17 +381,11 @@ static instruction DecodeInstruction(instruction_table Table, segmented_access A
     u32 TotalSize = 0;
     while(TotalSize < Table.MaxInstructionByteCount)
     {
-        Result = {};
-        for(u32 Index = 0; Index < Table.EncodingCount; ++Index)
+        Result = DecodeEncoding(&Context, Table, At);
+        if(Result.Op)
         {
-            instruction_encoding Inst = Table.Encodings[Index];
-            Result = TryDecode(&Context, &Inst, At);
-            if(Result.Op)
-            {
-                At.SegmentOffset += Result.Size;
-                TotalSize += Result.Size;
-                break;
-            }
+            At.SegmentOffset += Result.Size;
+            TotalSize += Result.Size;
         }
         
         if(Result.Op == Op_lock)
@@ -301,3 +419,13 @@ static instruction DecodeInstruction(instruction_table Table, segmented_access A
     
     return Result;
 }
+
+static instruction DecodeInstruction(instruction_table Table, segmented_access At)
+{
+#if SIM86_SPECIALIZED_DECODE
+    instruction Result = DecodeInstruction(Table, At, SpecializedDecode);
+#else
+    instruction Result = DecodeInstruction(Table, At, TableDecode);
+#endif
+    return Result;
+}
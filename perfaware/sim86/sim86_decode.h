@@ -32,4 +32,42 @@ enum register_mapping_8086
     Register_count,
 };
 
+struct modrm_entry
+{
+    // NOTE(agent): If IsRegister is set (MOD=11), the operand is the register encoded in RM, and its width
+    // depends on the instruction. Otherwise, the operand is an effective address made of Terms plus a
+    // displacement of DisplacementByteCount bytes.
+    b32 IsRegister;
+    register_mapping_8086 Terms[2];
+    u32 DisplacementByteCount;
+    
+    register_mapping_8086 DefaultSegment;
+    u32 EAClocks;
+};
+
+struct decode_context
+{
+    u32 DefaultSegment;
+    u32 AdditionalFlags;
+};
+
+/* NOTE(agent): An encoding_decoder decodes a single table entry (no prefixes) at At, returning an
+   instruction with Op_None if nothing matches. TableDecode walks the runtime instruction_table.
+   SpecializedDecode uses decoders generated at compile time from sim86_instruction_table.inl,
+   so no bit fields are interpreted at runtime. Set SIM86_SPECIALIZED_DECODE to 1 to make
+   DecodeInstruction use it by default. */
+typedef instruction encoding_decoder(decode_context *Context, instruction_table Table, segmented_access At);
+
+#ifndef SIM86_SPECIALIZED_DECODE
+#define SIM86_SPECIALIZED_DECODE 0
+#endif
+
+static modrm_entry GetModRMEntry(u32 ModRM);
+static modrm_entry GetModRMEntry(effective_address_expression Address);
+static instruction TableDecode(decode_context *Context, instruction_table Table, segmented_access At);
+#if SIM86_SPECIALIZED_DECODE
+static instruction SpecializedDecode(decode_context *Context, instruction_table Table, segmented_access At);
+#endif
+
+static instruction DecodeInstruction(instruction_table Table, segmented_access At, encoding_decoder *DecodeEncoding);
 static instruction DecodeInstruction(instruction_table Table, segmented_access At);
@@ -0,0 +1,257 @@
+/* NOTE(agent): This file generates one decoder per entry of sim86_instruction_table.inl at compile time.
+   The same bit-field walk that TryDecode does at runtime is done here by constexpr functions, which
+   produce, for each encoding, the literal bits its opcode bytes must match and where each field lives
+   in those bytes. Every generated decoder is then just a couple of masked compares followed by shifts
+   and masks with constant operands, and it hands off to the same BuildDecodedInstruction that TryDecode
+   uses, so the two paths cannot drift apart in how they build operands.
+   
+   Decoders are also grouped by first opcode byte, so SpecializedDecode only tries the encodings
+   that could possibly match, in the same order they appear in the table. */
+
+static constexpr instruction_encoding SpecializedTable8086[] =
+{
+#include "sim86_instruction_table.inl"
+};
+
+#define SPECIALIZED_ENCODING_COUNT ArrayCount(SpecializedTable8086)
+
+struct specialized_field
+{
+    b32 Has;
+    u32 ImplicitValue;
+    
+    // NOTE(agent): A field can be assembled from at most two parts (esc splits its data across two bytes)
+    u32 PartCount;
+    u32 ByteIndex[2];
+    u32 Shift[2];
+    u32 Mask[2];
+    u32 DestShift[2];
+};
+
+struct specialized_encoding
+{
+    b32 Valid;
+    operation_type Op;
+    
+    u32 OpcodeByteCount;
+    u32 LiteralMask[2];
+    u32 LiteralValue[2];
+    
+    specialized_field Fields[Bits_Count];
+};
+
+struct specialized_encoding_table
+{
+    specialized_encoding Entries[SPECIALIZED_ENCODING_COUNT];
+};
+
+static constexpr specialized_encoding SpecializeEncoding(instruction_encoding Inst)
+{
+    specialized_encoding Result = {};
+    Result.Valid = true;
+    Result.Op = Inst.Op;
+    
+    u32 BitsPendingCount = 0;
+    for(u32 BitsIndex = 0; BitsIndex < ArrayCount(Inst.Bits); ++BitsIndex)
+    {
+        instruction_bits TestBits = Inst.Bits[BitsIndex];
+        if(TestBits.Usage == Bits_End)
+        {
+            break;
+        }
+        
+        if(TestBits.BitCount != 0)
+        {
+            if(BitsPendingCount == 0)
+            {
+                BitsPendingCount = 8;
+                ++Result.OpcodeByteCount;
+            }
+            
+            if((TestBits.BitCount > BitsPendingCount) || (Result.OpcodeByteCount > ArrayCount(Result.LiteralMask)))
+            {
+                Result.Valid = false;
+                break;
+            }
+            
+            BitsPendingCount -= TestBits.BitCount;
+            
+            u32 ByteIndex = Result.OpcodeByteCount - 1;
+            u32 Mask = (1 << TestBits.BitCount) - 1;
+            
+            if(TestBits.Usage == Bits_Literal)
+            {
+                Result.LiteralMask[ByteIndex] |= (Mask << BitsPendingCount);
+                Result.LiteralValue[ByteIndex] |= ((TestBits.Value & Mask) << BitsPendingCount);
+            }
+            else
+            {
+                specialized_field *Field = &Result.Fields[TestBits.Usage];
+                if(Field->PartCount >= ArrayCount(Field->ByteIndex))
+                {
+                    Result.Valid = false;
+                    break;
+                }
+                
+                u32 PartIndex = Field->PartCount++;
+                Field->Has = true;
+                Field->ByteIndex[PartIndex] = ByteIndex;
+                Field->Shift[PartIndex] = BitsPendingCount;
+                Field->Mask[PartIndex] = Mask;
+                Field->DestShift[PartIndex] = TestBits.Shift;
+            }
+        }
+        else if(TestBits.Usage != Bits_Literal)
+        {
+            specialized_field *Field = &Result.Fields[TestBits.Usage];
+            Field->Has = true;
+            Field->ImplicitValue |= (TestBits.Value << TestBits.Shift);
+        }
+    }
+    
+    return Result;
+}
+
+static constexpr specialized_encoding_table BuildSpecializedEncodingTable()
+{
+    specialized_encoding_table Result = {};
+    for(u32 Index = 0; Index < SPECIALIZED_ENCODING_COUNT; ++Index)
+    {
+        Result.Entries[Index] = SpecializeEncoding(SpecializedTable8086[Index]);
+    }
+    
+    return Result;
+}
+
+static constexpr specialized_encoding_table SpecializedEncodings8086 = BuildSpecializedEncodingTable();
+
+static constexpr u32 NextEncodingForFirstByte(u32 FirstByte, u32 Index)
+{
+    while((Index < SPECIALIZED_ENCODING_COUNT) &&
+          ((FirstByte & SpecializedEncodings8086.Entries[Index].LiteralMask[0]) !=
+           SpecializedEncodings8086.Entries[Index].LiteralValue[0]))
+    {
+        ++Index;
+    }
+    
+    return Index;
+}
+
+static u32 SpecializedFieldValue(specialized_field Field, u8 *Bytes)
+{
+    u32 Result = Field.ImplicitValue;
+    if(Field.PartCount > 0)
+    {
+        Result |= ((Bytes[Field.ByteIndex[0]] >> Field.Shift[0]) & Field.Mask[0]) << Field.DestShift[0];
+    }
+    if(Field.PartCount > 1)
+    {
+        Result |= ((Bytes[Field.ByteIndex[1]] >> Field.Shift[1]) & Field.Mask[1]) << Field.DestShift[1];
+    }
+    
+    return Result;
+}
+
+template<u32 EncodingIndex>
+static instruction TrySpecializedDecode(decode_context *Context, segmented_access At)
+{
+    static constexpr specialized_encoding Spec = SpecializedEncodings8086.Entries[EncodingIndex];
+    static_assert(Spec.Valid, "Instruction table entry cannot be specialized (fields straddle bytes or span more than two opcode bytes)");
+    
+    instruction Result = {};
+    
+    u32 StartingAddress = GetAbsoluteAddressOf(At);
+    
+    u8 Bytes[2] = {};
+    Bytes[0] = *AccessMemory(At, 0);
+    if(Spec.OpcodeByteCount > 1)
+    {
+        Bytes[1] = *AccessMemory(At, 1);
+    }
+    
+    if(((Bytes[0] & Spec.LiteralMask[0]) == Spec.LiteralValue[0]) &&
+       ((Bytes[1] & Spec.LiteralMask[1]) == Spec.LiteralValue[1]))
+    {
+        b32 Has[Bits_Count] = {};
+        u32 Bits[Bits_Count] = {};
+
+#define SPECIALIZED_FIELD(Usage) Has[Usage] = Spec.Fields[Usage].Has; Bits[Usage] = SpecializedFieldValue(Spec.Fields[Usage], Bytes)
+        SPECIALIZED_FIELD(Bits_D);
+        SPECIALIZED_FIELD(Bits_S);
+        SPECIALIZED_FIELD(Bits_W);
+        SPECIALIZED_FIELD(Bits_V);
+        SPECIALIZED_FIELD(Bits_Z);
+        SPECIALIZED_FIELD(Bits_MOD);
+        SPECIALIZED_FIELD(Bits_REG);
+        SPECIALIZED_FIELD(Bits_RM);
+        SPECIALIZED_FIELD(Bits_SR);
+        SPECIALIZED_FIELD(Bits_Disp);
+        SPECIALIZED_FIELD(Bits_Data);
+        SPECIALIZED_FIELD(Bits_DispAlwaysW);
+        SPECIALIZED_FIELD(Bits_WMakesDataW);
+        SPECIALIZED_FIELD(Bits_RMRegAlwaysW);
+        SPECIALIZED_FIELD(Bits_RelJMPDisp);
+        SPECIALIZED_FIELD(Bits_Far);
+#undef SPECIALIZED_FIELD
+
+        At.SegmentOffset += Spec.OpcodeByteCount;
+        Result = BuildDecodedInstruction(Context, Spec.Op, Has, Bits, At, StartingAddress);
+    }
+    
+    return Result;
+}
+
+// NOTE(agent): specialized_chain<FirstByte, Index> tries every encoding that can start with FirstByte,
+// starting at table entry Index, in table order.
+template<u32 FirstByte, u32 EncodingIndex>
+struct specialized_chain
+{
+    static instruction Decode(decode_context *Context, segmented_access At)
+    {
+        instruction Result = TrySpecializedDecode<EncodingIndex>(Context, At);
+        if(!Result.Op)
+        {
+            Result = specialized_chain<FirstByte, NextEncodingForFirstByte(FirstByte, EncodingIndex + 1)>::Decode(Context, At);
+        }
+        
+        return Result;
+    }
+};
+
+template<u32 FirstByte>
+struct specialized_chain<FirstByte, SPECIALIZED_ENCODING_COUNT>
+{
+    static instruction Decode(decode_context *Context, segmented_access At)
+    {
+        instruction Result = {};
+        return Result;
+    }
+};
+
+typedef instruction specialized_decoder(decode_context *Context, segmented_access At);
+
+struct specialized_dispatch
+{
+    specialized_decoder *Decoders[256];
+};
+
+template<u32... FirstBytes> struct first_byte_list {};
+template<u32 Count, u32... FirstBytes> struct make_first_byte_list : make_first_byte_list<Count - 1, Count - 1, FirstBytes...> {};
+template<u32... FirstBytes> struct make_first_byte_list<0, FirstBytes...> {typedef first_byte_list<FirstBytes...> Type;};
+
+template<u32... FirstBytes>
+static constexpr specialized_dispatch BuildSpecializedDispatch(first_byte_list<FirstBytes...>)
+{
+    specialized_dispatch Result = {{&specialized_chain<FirstBytes, NextEncodingForFirstByte(FirstBytes, 0)>::Decode...}};
+    return Result;
+}
+
+static constexpr specialized_dispatch SpecializedDispatch8086 = BuildSpecializedDispatch(make_first_byte_list<256>::Type());
+
+static instruction SpecializedDecode(decode_context *Context, instruction_table Table, segmented_access At)
+{
+    // NOTE(agent): The specialized decoders are generated from the built-in 8086 table, so Table is not consulted here.
+    u8 FirstByte = *AccessMemory(At);
+    instruction Result = SpecializedDispatch8086.Decoders[FirstByte](Context, At);
+    return Result;
+}
@@ -0,0 +1,108 @@
+/* NOTE(agent): This checks that the decoders generated by SIM86_SPECIALIZED_DECODE produce exactly
+   the same instructions as the table-interpreting decoder. Every possible pair of leading bytes is
+   tried (which covers every opcode and ModRM combination, as well as every prefix followed by every
+   opcode), each with several different pseudo-random tails for the displacement and data bytes. */
+
+#define SIM86_SPECIALIZED_DECODE 1
+
+#include "sim86.h"
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../part2/profiler.cpp"
+
+#include "sim86_instruction.h"
+#include "sim86_instruction_table.h"
+#include "sim86_memory.h"
+#include "sim86_decode.h"
+#include "sim86_execute.h"
+#include "sim86_cycles.h"
+#include "sim86_text.h"
+
+#include "sim86_instruction.cpp"
+#include "sim86_instruction_table.cpp"
+#include "sim86_memory.cpp"
+#include "sim86_decode.cpp"
+#include "sim86_decode_specialized.cpp"
+#include "sim86_execute.cpp"
+#include "sim86_cycles.cpp"
+#include "sim86_text_table.cpp"
+#include "sim86_text.cpp"
+
+static u64 RandomU64(u64 *Series)
+{
+    // NOTE(agent): xorshift64, just so the test is reproducible everywhere
+    u64 X = *Series;
+    X ^= X << 13;
+    X ^= X >> 7;
+    X ^= X << 17;
+    *Series = X;
+    return X;
+}
+
+int main(void)
+{
+    u32 const TailsPerPattern = 8;
+    
+    instruction_table Table = Get8086InstructionTable();
+    
+    // NOTE(agent): No buffer, so mismatches print straight to stdout, in order with the printfs around them
+    text_output Out = TextOutputToFile(stdout, 0, 0);
+    
+    u8 Bytes[16] = {};
+    segmented_access At = FixedMemoryPow2(4, Bytes);
+    
+    u64 Series = 0x9E3779B97F4A7C15ull;
+    u32 TestCount = 0;
+    u32 DecodedCount = 0;
+    u32 MismatchCount = 0;
+    for(u32 Pattern = 0; Pattern < 0x10000; ++Pattern)
+    {
+        for(u32 TailIndex = 0; TailIndex < TailsPerPattern; ++TailIndex)
+        {
+            for(u32 ByteIndex = 2; ByteIndex < ArrayCount(Bytes); ++ByteIndex)
+            {
+                Bytes[ByteIndex] = (u8)RandomU64(&Series);
+            }
+            Bytes[0] = (u8)(Pattern >> 8);
+            Bytes[1] = (u8)(Pattern & 0xff);
+            
+            instruction Expected = DecodeInstruction(Table, At, TableDecode);
+            instruction Specialized = DecodeInstruction(Table, At, SpecializedDecode);
+            
+            ++TestCount;
+            if(Expected.Op)
+            {
+                ++DecodedCount;
+            }
+            
+            if(memcmp(&Expected, &Specialized, sizeof(Expected)) != 0)
+            {
+                if(MismatchCount < 16)
+                {
+                    printf("MISMATCH:");
+                    for(u32 ByteIndex = 0; ByteIndex < ArrayCount(Bytes); ++ByteIndex)
+                    {
+                        printf(" %02x", Bytes[ByteIndex]);
+                    }
+                    printf("\n  table:       ");
+                    PrintInstruction(Expected, &Out);
+                    printf("\n  specialized: ");
+                    PrintInstruction(Specialized, &Out);
+                    printf("\n");
+                }
+                
+                ++MismatchCount;
+            }
+        }
+    }
+    
+    printf("%u byte patterns tested (%u decoded), %u mismatches\n", TestCount, DecodedCount, MismatchCount);
+    
+    int Result = (MismatchCount == 0) ? 0 : -1;
+    return Result;
+}
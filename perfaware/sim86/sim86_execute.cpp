@@ -281,7 +281,8 @@ static operand_access AccessOperand(segmented_access Memory, register_state_8086
             }
             else
             {
-                u16 SegReg = (Source.Address.Terms[0].Register.Index == Register_bp) ? Registers->ss : Registers->ds;
+                modrm_entry Entry = GetModRMEntry(Source.Address);
+                u16 SegReg = GetRegisterValueU16(Registers, Entry.DefaultSegment);
                 
                 Result.Op.Memory = Memory.Memory;
                 Result.Op.SegmentBase = DetermineSegmentAccess(Memory, Instruction, Registers, SegReg).SegmentBase;
@@ -307,6 +308,8 @@ static operand_access AccessOperand(segmented_access Memory, register_state_8086
 
 static exec_result ExecInstruction(segmented_access Memory, register_state_8086 *Registers, instruction Instruction)
 {
+    TimeFunction;
+    
     exec_result Result = {};
     
     u32 WWidth = (Instruction.Flags & Inst_Wide) ? 2 : 1;
@@ -0,0 +1,76 @@
+static void BuildInstructionLengthTable(instruction_table Table, instruction_length_table *Lengths)
+{
+    /* NOTE(agent): Rather than transcribe a second description of the instruction set, the lengths
+       are taken from the decoder itself, so they cannot disagree with it. The bytes after the first
+       two never affect the length, so they are left as zero. */
+    
+    u8 Bytes[16] = {};
+    segmented_access At = FixedMemoryPow2(4, Bytes);
+    
+    Lengths->MaxInstructionByteCount = Table.MaxInstructionByteCount;
+    for(u32 Pattern = 0; Pattern < ArrayCount(Lengths->Entries); ++Pattern)
+    {
+        Bytes[0] = (u8)(Pattern >> 8);
+        Bytes[1] = (u8)(Pattern & 0xff);
+        
+        decode_context Context = {};
+#if SIM86_SPECIALIZED_DECODE
+        instruction Instruction = SpecializedDecode(&Context, Table, At);
+#else
+        instruction Instruction = TableDecode(&Context, Table, At);
+#endif
+
+        u8 Entry = 0;
+        if(Instruction.Op)
+        {
+            assert(Instruction.Size <= Length_SizeMask);
+            Entry = (u8)Instruction.Size;
+            if((Instruction.Op == Op_lock) ||
+               (Instruction.Op == Op_rep) ||
+               (Instruction.Op == Op_segment))
+            {
+                Entry |= Length_Prefix;
+            }
+        }
+        
+        Lengths->Entries[Pattern] = Entry;
+    }
+}
+
+static u32 GetInstructionLength(instruction_length_table *Lengths, segmented_access At)
+{
+    /* NOTE(agent): This mirrors the prefix handling in DecodeInstruction exactly, so it returns
+       the same Size that DecodeInstruction would, or 0 wherever DecodeInstruction would fail. */
+    
+    u32 Result = 0;
+    
+    u32 TotalSize = 0;
+    b32 Valid = false;
+    while(TotalSize < Lengths->MaxInstructionByteCount)
+    {
+        u32 Pattern = ((u32)*AccessMemory(At, 0) << 8) | *AccessMemory(At, 1);
+        u8 Entry = Lengths->Entries[Pattern];
+        u32 Size = (Entry & Length_SizeMask);
+        
+        Valid = (Size != 0);
+        if(!Valid)
+        {
+            break;
+        }
+        
+        At.SegmentOffset += Size;
+        TotalSize += Size;
+        
+        if(!(Entry & Length_Prefix))
+        {
+            break;
+        }
+    }
+    
+    if(Valid && (TotalSize <= Lengths->MaxInstructionByteCount))
+    {
+        Result = TotalSize;
+    }
+    
+    return Result;
+}
@@ -0,0 +1,18 @@
+enum instruction_length_flag
+{
+    Length_Prefix = 0x80, // NOTE(agent): This encoding is a prefix (lock, rep, segment) and must be followed by another
+    Length_SizeMask = 0x7f,
+};
+
+struct instruction_length_table
+{
+    // NOTE(agent): Indexed by the first two bytes of an encoding (first byte in the high 8 bits).
+    // Each entry is the size of the encoding in bytes, or 0 if the bytes do not decode, combined
+    // with Length_Prefix for prefixes. The 8086 has no encoding whose size depends on anything
+    // past its first two bytes, so this is all we need to know to step from one instruction to the next.
+    u8 Entries[0x10000];
+    u32 MaxInstructionByteCount;
+};
+
+static void BuildInstructionLengthTable(instruction_table Table, instruction_length_table *Lengths);
+static u32 GetInstructionLength(instruction_length_table *Lengths, segmented_access At);
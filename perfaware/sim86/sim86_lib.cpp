@@ -14,6 +14,8 @@
 
 #include "sim86.h"
 
+#include "../part2/profiler.cpp"
+
 #include "sim86_instruction.h"
 #include "sim86_instruction_table.h"
 #include "sim86_memory.h"
@@ -23,6 +25,9 @@
 #include "sim86_instruction_table.cpp"
 #include "sim86_memory.cpp"
 #include "sim86_decode.cpp"
+#if SIM86_SPECIALIZED_DECODE
+#include "sim86_decode_specialized.cpp"
+#endif
 #include "sim86_text_table.cpp"
 
 extern "C" u32 Sim86_GetVersion(void)
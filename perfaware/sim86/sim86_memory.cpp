@@ -42,6 +42,19 @@ static segmented_access MoveBaseBy(segmented_access Access, s32 Offset)
     return Result;
 }
 
+static segmented_access MoveBaseTo(segmented_access Access, u32 Offset)
+{
+    // NOTE(agent): Unlike MoveBaseBy, this can move any distance within the address space. The result is
+    // normalized the same way MoveBaseBy normalizes, so stepping there with MoveBaseBy gives the same access.
+    u32 Address = GetAbsoluteAddressOf(Access, 0) + Offset;
+    
+    segmented_access Result = Access;
+    Result.SegmentBase = (u16)(Address >> 4);
+    Result.SegmentOffset = (u16)(Address & 0xf);
+    
+    return Result;
+}
+
 static u8 *AccessMemory(segmented_access SegMem, u16 Offset)
 {
     u32 AbsAddr = GetAbsoluteAddressOf(SegMem, Offset);
@@ -21,6 +21,7 @@ struct segmented_access
 static u32 GetHighestAddress(segmented_access SegMem);
 static u32 GetAbsoluteAddressOf(segmented_access SegMem, u16 Offset = 0);
 static segmented_access MoveBaseBy(segmented_access Access, s32 Offset);
+static segmented_access MoveBaseTo(segmented_access Access, u32 Offset);
 
 static u8 *AccessMemory(segmented_access SegMem, u16 Offset = 0);
 
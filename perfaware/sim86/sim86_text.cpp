@@ -10,7 +10,116 @@
    
    ======================================================================== */
 
-static void PrintEffectiveAddressExpression(effective_address_expression Address, FILE *Dest)
+static text_output TextOutputToFile(FILE *File, char *Data, u64 Size)
+{
+    text_output Result = {};
+    Result.File = File;
+    if(Data)
+    {
+        Result.Data = Data;
+        Result.Size = Size;
+    }
+    
+    return Result;
+}
+
+static text_output TextOutputToMemory(char *Data, u64 Size)
+{
+    text_output Result = {};
+    if(Data)
+    {
+        Result.Data = Data;
+        Result.Size = Size;
+    }
+    
+    return Result;
+}
+
+static void FlushTextOutput(text_output *Dest)
+{
+    if(Dest->File && Dest->Used)
+    {
+        fwrite(Dest->Data, Dest->Used, 1, Dest->File);
+        Dest->Used = 0;
+    }
+}
+
+static b32 MakeRoomFor(text_output *Dest, u64 Count)
+{
+    // NOTE(agent): The text needs one byte more than Count, since vsnprintf always writes a terminating zero
+    b32 Result = ((Dest->Used + Count) < Dest->Size);
+    if(!Result && Dest->File)
+    {
+        FlushTextOutput(Dest);
+        Result = (Count < Dest->Size);
+    }
+    else if(!Result)
+    {
+        Dest->Overflowed = true;
+    }
+    
+    return Result;
+}
+
+static void PrintText(text_output *Dest, char const *Text, u64 Count)
+{
+    if(!Dest->Overflowed)
+    {
+        if(MakeRoomFor(Dest, Count))
+        {
+            memcpy(Dest->Data + Dest->Used, Text, Count);
+            Dest->Used += Count;
+        }
+        else if(Dest->File)
+        {
+            // NOTE(agent): Bigger than the whole buffer, so it goes straight to the file
+            fwrite(Text, Count, 1, Dest->File);
+        }
+    }
+}
+
+static void PrintString(text_output *Dest, char const *String)
+{
+    // NOTE(agent): Most of what gets printed is fixed strings (mnemonics, register names, punctuation), and
+    // copying those directly is much cheaper than going through vsnprintf
+    PrintText(Dest, String, strlen(String));
+}
+
+static void Print(text_output *Dest, char const *Format, ...)
+{
+    if(!Dest->Overflowed)
+    {
+        va_list Args;
+        va_start(Args, Format);
+        int Count = vsnprintf(Dest->Data + Dest->Used, Dest->Size - Dest->Used, Format, Args);
+        va_end(Args);
+        
+        if(Count > 0)
+        {
+            if((Dest->Used + Count) < Dest->Size)
+            {
+                Dest->Used += Count;
+            }
+            else if(MakeRoomFor(Dest, Count))
+            {
+                // NOTE(agent): It didn't fit before, but there's room now that the buffer has been flushed
+                va_start(Args, Format);
+                vsnprintf(Dest->Data + Dest->Used, Dest->Size - Dest->Used, Format, Args);
+                va_end(Args);
+                
+                Dest->Used += Count;
+            }
+            else if(Dest->File)
+            {
+                va_start(Args, Format);
+                vfprintf(Dest->File, Format, Args);
+                va_end(Args);
+            }
+        }
+    }
+}
+
+static void PrintEffectiveAddressExpression(effective_address_expression Address, text_output *Dest)
 {
     b32 HadTerms = false;
     
@@ -22,12 +131,12 @@ static void PrintEffectiveAddressExpression(effective_address_expression Address
         
         if(Reg.Index)
         {
-            fprintf(Dest, "%s", Separator);
+            PrintString(Dest, Separator);
             if(Term.Scale != 1)
             {
-                fprintf(Dest, "%d*", Term.Scale);
+                Print(Dest, "%d*", Term.Scale);
             }
-            fprintf(Dest, "%s", GetRegName(Reg));
+            PrintString(Dest, GetRegName(Reg));
             Separator = "+";
             
             HadTerms = true;
@@ -36,12 +145,14 @@ static void PrintEffectiveAddressExpression(effective_address_expression Address
     
     if(!HadTerms || (Address.Displacement != 0))
     {
-        fprintf(Dest, "%+d", Address.Displacement);
+        Print(Dest, "%+d", Address.Displacement);
     }
 }
 
-static void PrintInstruction(instruction Instruction, FILE *Dest)
+static void PrintInstruction(instruction Instruction, text_output *Dest)
 {
+    TimeFunction;
+    
     u32 Flags = Instruction.Flags;
     u32 W = Flags & Inst_Wide;
     
@@ -54,18 +165,20 @@ static void PrintInstruction(instruction Instruction, FILE *Dest)
             Instruction.Operands[0] = Instruction.Operands[1];
             Instruction.Operands[1] = Temp;
         }
-        fprintf(Dest, "lock ");
+        PrintString(Dest, "lock ");
     }
     
     char const *MnemonicSuffix = "";
     if(Flags & Inst_Rep)
     {
         u32 Z = Flags & Inst_RepNE;
-        fprintf(Dest, "%s ", Z ? "rep" : "repne");
+        PrintString(Dest, Z ? "rep " : "repne ");
         MnemonicSuffix = W ? "w" : "b";
     }
     
-    fprintf(Dest, "%s%s ", GetMnemonic(Instruction.Op), MnemonicSuffix);
+    PrintString(Dest, GetMnemonic(Instruction.Op));
+    PrintString(Dest, MnemonicSuffix);
+    PrintString(Dest, " ");
     
     char const *Separator = "";
     for(u32 OperandIndex = 0; OperandIndex < ArrayCount(Instruction.Operands); ++OperandIndex)
@@ -73,7 +186,7 @@ static void PrintInstruction(instruction Instruction, FILE *Dest)
         instruction_operand Operand = Instruction.Operands[OperandIndex];
         if(Operand.Type != Operand_None)
         {
-            fprintf(Dest, "%s", Separator);
+            PrintString(Dest, Separator);
             Separator = ", ";
             
             switch(Operand.Type)
@@ -82,7 +195,7 @@ static void PrintInstruction(instruction Instruction, FILE *Dest)
                 
                 case Operand_Register:
                 {
-                    fprintf(Dest, "%s", GetRegName(Operand.Register));
+                    PrintString(Dest, GetRegName(Operand.Register));
                 } break;
                 
                 case Operand_Memory:
@@ -91,28 +204,29 @@ static void PrintInstruction(instruction Instruction, FILE *Dest)
                     
                     if(Address.Flags & Address_ExplicitSegment)
                     {
-                        fprintf(Dest, "%u:%u", Address.ExplicitSegment, Address.Displacement);
+                        Print(Dest, "%u:%u", Address.ExplicitSegment, Address.Displacement);
                     }
                     else
                     {
                         if(Flags & Inst_Far)
                         {
-                            fprintf(Dest, "far ");
+                            PrintString(Dest, "far ");
                         }
                         
                         if(Instruction.Operands[0].Type != Operand_Register)
                         {
-                            fprintf(Dest, "%s ", W ? "word" : "byte");
+                            PrintString(Dest, W ? "word " : "byte ");
                         }
                         
                         if(Flags & Inst_Segment)
                         {
-                            fprintf(Dest, "%s:", GetRegName({Instruction.SegmentOverride, 0, 2}));
+                            PrintString(Dest, GetRegName({Instruction.SegmentOverride, 0, 2}));
+                            PrintString(Dest, ":");
                         }
                         
-                        fprintf(Dest, "[");
+                        PrintString(Dest, "[");
                         PrintEffectiveAddressExpression(Address, Dest);
-                        fprintf(Dest, "]");
+                        PrintString(Dest, "]");
                     }
                 } break;
                 
@@ -121,11 +235,11 @@ static void PrintInstruction(instruction Instruction, FILE *Dest)
                     immediate Immediate = Operand.Immediate;
                     if(Immediate.Flags & Immediate_RelativeJumpDisplacement)
                     {
-                        fprintf(Dest, "$%+d", Immediate.Value + Instruction.Size);
+                        Print(Dest, "$%+d", Immediate.Value + Instruction.Size);
                     }
                     else
                     {
-                        fprintf(Dest, "%d", Immediate.Value);
+                        Print(Dest, "%d", Immediate.Value);
                     }
                 } break;
             }
@@ -133,20 +247,20 @@ static void PrintInstruction(instruction Instruction, FILE *Dest)
     }
 }
 
-static void PrintFlags(u32 Value, FILE *Dest)
+static void PrintFlags(u32 Value, text_output *Dest)
 {
-    if(Value & Flag_CF) {fprintf(Dest, "C");}
-    if(Value & Flag_PF) {fprintf(Dest, "P");}
-    if(Value & Flag_AF) {fprintf(Dest, "A");}
-    if(Value & Flag_ZF) {fprintf(Dest, "Z");}
-    if(Value & Flag_SF) {fprintf(Dest, "S");}
-    if(Value & Flag_TF) {fprintf(Dest, "T");}
-    if(Value & Flag_IF) {fprintf(Dest, "I");}
-    if(Value & Flag_DF) {fprintf(Dest, "D");}
-    if(Value & Flag_OF) {fprintf(Dest, "O");}
+    if(Value & Flag_CF) {PrintString(Dest, "C");}
+    if(Value & Flag_PF) {PrintString(Dest, "P");}
+    if(Value & Flag_AF) {PrintString(Dest, "A");}
+    if(Value & Flag_ZF) {PrintString(Dest, "Z");}
+    if(Value & Flag_SF) {PrintString(Dest, "S");}
+    if(Value & Flag_TF) {PrintString(Dest, "T");}
+    if(Value & Flag_IF) {PrintString(Dest, "I");}
+    if(Value & Flag_DF) {PrintString(Dest, "D");}
+    if(Value & Flag_OF) {PrintString(Dest, "O");}
 }
 
-static void PrintRegisters(register_state_8086 *Registers, FILE *Dest)
+static void PrintRegisters(register_state_8086 *Registers, text_output *Dest)
 {
     for(u32 RegIndex = 0; RegIndex < ArrayCount(Registers->u16); ++RegIndex)
     {
@@ -158,21 +272,21 @@ static void PrintRegisters(register_state_8086 *Registers, FILE *Dest)
         char const *Name = GetRegName(Access);
         if(Value && *Name)
         {
-            fprintf(Dest, "%8s: ", Name);
+            Print(Dest, "%8s: ", Name);
             if(RegIndex == FLAGS_REGISTER_8086)
             {
                 PrintFlags(Value, Dest);
             }
             else
             {
-                fprintf(Dest, "0x%04x (%u)", Value, Value);
+                Print(Dest, "0x%04x (%u)", Value, Value);
             }
-            fprintf(Dest, "\n");
+            PrintString(Dest, "\n");
         }
     }
 }
 
-static void PrintRegisterDifference(register_state_8086 *Old, register_state_8086 *New, FILE *Dest)
+static void PrintRegisterDifference(register_state_8086 *Old, register_state_8086 *New, text_output *Dest)
 {
     for(u32 RegIndex = 0; RegIndex < ArrayCount(Old->u16); ++RegIndex)
     {
@@ -186,51 +300,51 @@ static void PrintRegisterDifference(register_state_8086 *Old, register_state_808
         
         if(OldVal != NewVal)
         {
-            fprintf(Dest, "%s:", Name);
+            Print(Dest, "%s:", Name);
             if(RegIndex == FLAGS_REGISTER_8086)
             {
                 PrintFlags(OldVal, Dest);
-                fprintf(Dest, "->");
+                PrintString(Dest, "->");
                 PrintFlags(NewVal, Dest);
             }
             else
             {
-                fprintf(Dest, "0x%x->0x%x", OldVal, NewVal);
+                Print(Dest, "0x%x->0x%x", OldVal, NewVal);
             }
-            fprintf(Dest, " ");
+            PrintString(Dest, " ");
         }
     }
 }
 
-static void PrintClockInterval(instruction_clock_interval Clocks, FILE *Dest)
+static void PrintClockInterval(instruction_clock_interval Clocks, text_output *Dest)
 {
     if(Clocks.Min != Clocks.Max)
     {
-        fprintf(Dest, "[%u,%u]", Clocks.Min, Clocks.Max);
+        Print(Dest, "[%u,%u]", Clocks.Min, Clocks.Max);
     }
     else
     {
-        fprintf(Dest, "%u", Clocks.Min);
+        Print(Dest, "%u", Clocks.Min);
     }
 }
 
-static void ExplainTiming(instruction_timing Timing, instruction_clock_interval Clocks, FILE *Dest)
+static void ExplainTiming(instruction_timing Timing, instruction_clock_interval Clocks, text_output *Dest)
 {
     if(Timing.Base.Min != Clocks.Min)
     {
-        fprintf(Dest, " (");
+        PrintString(Dest, " (");
         PrintClockInterval(Timing.Base, Dest);
         if(Timing.EAClocks)
         {
-            fprintf(Dest, " + %uea", Timing.EAClocks);
+            Print(Dest, " + %uea", Timing.EAClocks);
         }
         
         u32 Penalty = Clocks.Min - (Timing.Base.Min + Timing.EAClocks);
         if(Penalty)
         {
-            fprintf(Dest, " + %up", Penalty);
+            Print(Dest, " + %up", Penalty);
         }
         
-        fprintf(Dest, ")");
+        PrintString(Dest, ")");
     }
 }
@@ -10,4 +10,25 @@
    
    ======================================================================== */
 
-static void PrintInstruction(instruction Instruction, FILE *Dest);
+#include <stdarg.h>
+
+struct text_output
+{
+    /* NOTE(agent): Text is printed into Data. If there is a File, Data is written to it whenever it fills up, and
+       by FlushTextOutput. If there isn't, text that doesn't fit is dropped, and Overflowed is set. */
+    char *Data;
+    u64 Size;
+    u64 Used;
+    
+    FILE *File;
+    b32 Overflowed;
+};
+
+static text_output TextOutputToFile(FILE *File, char *Data, u64 Size);
+static text_output TextOutputToMemory(char *Data, u64 Size);
+static void FlushTextOutput(text_output *Dest);
+static void Print(text_output *Dest, char const *Format, ...);
+static void PrintText(text_output *Dest, char const *Text, u64 Count);
+static void PrintString(text_output *Dest, char const *String);
+
+static void PrintInstruction(instruction Instruction, text_output *Dest);
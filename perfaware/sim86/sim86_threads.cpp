@@ -0,0 +1,68 @@
+/* NOTE(agent): Only the bare minimum of threading is needed here (start some threads, hand out work
+   indices, wait for them to finish), so rather than pulling in std::thread, this just talks to the
+   OS directly, through the same few calls the haversine code uses. */
+
+#include "../part2/os_thread.cpp"
+
+struct parallel_work_queue
+{
+    parallel_work_function *Work;
+    void *Params;
+    u32 WorkCount;
+    u32 volatile NextWorkIndex;
+};
+
+static void DrainWorkQueue(parallel_work_queue *Queue)
+{
+    for(;;)
+    {
+        u32 WorkIndex = AtomicIncrementU32(&Queue->NextWorkIndex);
+        if(WorkIndex >= Queue->WorkCount)
+        {
+            break;
+        }
+        
+        Queue->Work(Queue->Params, WorkIndex);
+    }
+}
+
+static THREAD_PROC(WorkerThreadProc)
+{
+    DrainWorkQueue((parallel_work_queue *)Param);
+    return 0;
+}
+
+static void DoParallelWork(u32 ThreadCount, u32 WorkCount, parallel_work_function *Work, void *Params)
+{
+    parallel_work_queue Queue = {};
+    Queue.Work = Work;
+    Queue.Params = Params;
+    Queue.WorkCount = WorkCount;
+    
+    os_thread Threads[256];
+    u32 StartedCount = 0;
+    
+    u32 MaxExtraThreads = ArrayCount(Threads);
+    u32 ExtraThreadCount = (ThreadCount > 1) ? (ThreadCount - 1) : 0;
+    if(ExtraThreadCount > MaxExtraThreads)
+    {
+        ExtraThreadCount = MaxExtraThreads;
+    }
+    
+    for(u32 ThreadIndex = 0; ThreadIndex < ExtraThreadCount; ++ThreadIndex)
+    {
+        os_thread Thread;
+        if(StartThread(&Thread, WorkerThreadProc, &Queue))
+        {
+            Threads[StartedCount++] = Thread;
+        }
+    }
+    
+    // NOTE(agent): The calling thread works too, so even if no threads could be started, all the work still gets done.
+    DrainWorkQueue(&Queue);
+    
+    for(u32 ThreadIndex = 0; ThreadIndex < StartedCount; ++ThreadIndex)
+    {
+        JoinThread(Threads[ThreadIndex]);
+    }
+}
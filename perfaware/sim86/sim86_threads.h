@@ -0,0 +1,7 @@
+typedef void parallel_work_function(void *Params, u32 WorkIndex);
+
+static u32 GetProcessorCount(void);
+
+// NOTE(agent): Calls Work(Params, WorkIndex) for every WorkIndex in [0, WorkCount), spread across ThreadCount threads
+// (the calling thread is one of them). Work items are handed out in increasing order, but may complete in any order.
+static void DoParallelWork(u32 ThreadCount, u32 WorkCount, parallel_work_function *Work, void *Params);